@@ -9,11 +9,15 @@ from pathlib import Path
 # generate a random test file with commands
 def generate_test_file(num_orders=1000, output_file="test_input.txt", 
                        price_range=(100, 200), qty_range=(1, 100),
-                       seed=None):
+                       seed=None, num_symbols=0):
 
     if seed is not None:
         random.seed(seed)
-    
+
+    # with symbols every N/C command names one, e.g. "N SYM0003 1 B 120 10"
+    symbols = [f"SYM{i:04d}" for i in range(num_symbols)]
+    order_symbol = {}
+
     existing_order_ids = set()
     active_order_ids = []  # Track orders that can be cancelled
     commands = []
@@ -29,20 +33,28 @@ def generate_test_file(num_orders=1000, output_file="test_input.txt",
             side = random.choice(['B', 'S'])
             price = random.randint(price_range[0], price_range[1])
             qty = random.randint(qty_range[0], qty_range[1])
-            
-            commands.append(f"N {order_id} {side} {price} {qty}")
+
+            if symbols:
+                symbol = random.choice(symbols)
+                order_symbol[order_id] = symbol
+                commands.append(f"N {symbol} {order_id} {side} {price} {qty}")
+            else:
+                commands.append(f"N {order_id} {side} {price} {qty}")
             active_order_ids.append(order_id)
             
         elif rand < 0.90 and active_order_ids:  # Cancel order
             order_id = random.choice(active_order_ids)
-            commands.append(f"C {order_id}")
+            if symbols:
+                commands.append(f"C {order_symbol.pop(order_id)} {order_id}")
+            else:
+                commands.append(f"C {order_id}")
             active_order_ids.remove(order_id)
             
         elif rand < 0.95:  # Print top of book
-            commands.append("P")
+            commands.append(f"P {random.choice(symbols)}" if symbols else "P")
             
         else:  # Print full book
-            commands.append("B")
+            commands.append(f"B {random.choice(symbols)}" if symbols else "B")
     
     # Write to file
     with open(output_file, 'w') as f:
@@ -53,7 +65,9 @@ def generate_test_file(num_orders=1000, output_file="test_input.txt",
     print(f"Generated {len(commands)} commands in {output_file}")
     print(f"  - Orders: {len([c for c in commands if c.startswith('N')])}")
     print(f"  - Cancels: {len([c for c in commands if c.startswith('C')])}")
-    print(f"  - Queries: {len([c for c in commands if c in ['P', 'B']])}")
+    print(f"  - Queries: {len([c for c in commands if c[0] in 'PB'])}")
+    if symbols:
+        print(f"  - Symbols: {len(symbols)}")
 
 def main():
     parser = argparse.ArgumentParser(description='Generate random test cases')
@@ -71,6 +85,8 @@ def main():
                        help='Maximum quantity (default: 100)')
     parser.add_argument('--seed', type=int, default=None,
                        help='Random seed for reproducibility')
+    parser.add_argument('--symbols', type=int, default=0,
+                       help='Number of symbols to spread N/C commands over (default: 0, single unnamed book)')
     
     args = parser.parse_args()
     
@@ -79,7 +95,8 @@ def main():
         output_file=args.output,
         price_range=(args.price_min, args.price_max),
         qty_range=(args.qty_min, args.qty_max),
-        seed=args.seed
+        seed=args.seed,
+        num_symbols=args.symbols
     )
 
 if __name__ == '__main__':
@@ -0,0 +1,455 @@
+/**
+basic_matching_engine.hpp
+--------------
+Defines BasicMatchingEngine, the price-time priority matching engine with
+its listeners fixed at compile time. Events are dispatched to every listener
+in Listeners... through plain member calls, so they inline and listeners with
+empty callbacks compile away. Per-level quantity changes are collected and
+sent through on_level_update only when some listener defines that callback.
+Orders, cancels and amends are split into profiled stages (see hot_path_profile.hpp),
+which cost nothing unless the build defines EXCHANGE_PROFILE.
+process_batch runs a span of commands, prefetching the index slots and book
+entries of the commands ahead of the one matching.
+ */
+
+#pragma once
+
+#include "order_book.hpp"
+#include "events.hpp"
+#include "command.hpp"
+#include "hot_path_profile.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct NewOrderResponse {
+    bool accepted;
+    std::optional<RejectReason> reject_reason;
+    std::vector<Trade> trades;
+};
+
+// Non-owning view of the trades produced by one order
+struct TradeView {
+    const Trade* data = nullptr;
+    std::size_t count = 0;
+
+    const Trade* begin() const { return data; }
+    const Trade* end() const { return data + count; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const Trade& operator[](std::size_t i) const { return data[i]; }
+};
+
+// Result of process_new_order_view, trades point into the engine's
+// reusable buffer and are only valid until the next engine call
+struct NewOrderView {
+    bool accepted;
+    std::optional<RejectReason> reject_reason;
+    TradeView trades;
+};
+
+// True if listener L has an on_level_update callback
+template <typename L, typename = void>
+struct wants_level_updates : std::false_type {};
+
+template <typename L>
+struct wants_level_updates<L, std::void_t<decltype(std::declval<L&>().on_level_update(std::declval<const LevelUpdate&>()))>>
+    : std::true_type {};
+
+// True if listener L decides at runtime whether it takes level updates (e.g. ListenerList)
+template <typename L, typename = void>
+struct switches_level_updates : std::false_type {};
+
+template <typename L>
+struct switches_level_updates<L, std::void_t<decltype(std::declval<const L&>().takes_level_updates())>>
+    : std::true_type {};
+
+template <typename... Listeners>
+class BasicMatchingEngine {
+private:
+    OrderBook ob;
+
+    // queries are const but still report to the listeners
+    mutable std::tuple<Listeners...> listeners;
+
+    // reused across orders so the matching path does not allocate once warm
+    std::vector<Fill> fill_buffer;
+    std::vector<Trade> trade_buffer;
+    std::vector<int> cancel_buffer;
+
+    // level changes are only collected when some listener takes them
+    static constexpr bool tracks_levels = (wants_level_updates<Listeners>::value || ...);
+    std::vector<LevelUpdate> level_buffer;
+
+    std::vector<LevelUpdate>* level_updates() {
+        if constexpr (tracks_levels){
+            bool wanted = false;
+            std::apply([&](const auto&... l){ ((wanted = wanted || takes_levels(l)), ...); }, listeners);
+            return wanted ? &level_buffer : nullptr;
+        }
+        else return nullptr;
+    }
+
+    template <typename L>
+    static bool takes_levels(const L& l) {
+        if constexpr (switches_level_updates<L>::value) return l.takes_level_updates();
+        else return wants_level_updates<L>::value;
+    }
+
+    // Sends the level changes of the last command to the listeners that take them
+    void emit_level_updates() {
+        if constexpr (tracks_levels){
+            for (const LevelUpdate& update : level_buffer){
+                emit([&](auto& l){
+                    if constexpr (wants_level_updates<std::decay_t<decltype(l)>>::value) l.on_level_update(update);
+                });
+            }
+            level_buffer.clear();
+        }
+    }
+
+    // reused by depth-limited book queries
+    mutable BookSnapshot depth_snapshot;
+
+    // BBO feed mode: on_tob is also sent after every command that moves the touch
+    bool bbo_feed = false;
+
+    static bool same_level(const std::optional<PriceLevel>& a, const std::optional<PriceLevel>& b) {
+        if (!a || !b) return a.has_value() == b.has_value();
+        return a->price == b->price && a->qty == b->qty;
+    }
+
+    // Sends the touch if it differs from before, the touch ahead of the last command
+    void emit_touch_change(const TopOfBook& before) {
+        const TopOfBook& after = ob.top_of_book();
+        if (same_level(before.best_bid, after.best_bid) && same_level(before.best_ask, after.best_ask)) return;
+        emit([&](auto& l){ l.on_tob(after); });
+    }
+
+    template <typename F>
+    void emit(F&& f) const {
+        std::apply([&](auto&... l){ (f(l), ...); }, listeners);
+    }
+
+    // First and second prefetch stages of a command some way ahead in a batch: the index
+    // slot of its id, then, once that has arrived, the order node and level it will touch
+    void prefetch_index(const Command& cmd) const {
+        if (cmd.type == CommandType::New || cmd.type == CommandType::Cancel || cmd.type == CommandType::Amend){
+            ob.prefetch_order(static_cast<int>(cmd.order_id));
+        }
+    }
+
+    void prefetch_entries(const Command& cmd) const {
+        if (cmd.type == CommandType::New) ob.prefetch_level(cmd.side, cmd.price);
+        else if (cmd.type == CommandType::Cancel || cmd.type == CommandType::Amend) ob.prefetch_resting(static_cast<int>(cmd.order_id));
+    }
+
+    // Sends the CXLs of a mass cancel, one pass over cancel_buffer per listener
+    void emit_mass_cancel(const TopOfBook& before) {
+        emit([&](auto& l){
+            for (int order_id : cancel_buffer) l.on_cancel(order_id, CancelResult::Cancelled);
+        });
+        emit_level_updates();
+        if (bbo_feed) emit_touch_change(before);
+    }
+
+    void order_match_buy(int incoming_id, int incoming_price, int& remaining_qty);
+    void order_match_sell(int incoming_id, int incoming_price, int& remaining_qty);
+
+public:
+    explicit BasicMatchingEngine(const BookConfig& config = BookConfig{}) : ob(config) {}
+
+    BasicMatchingEngine(const BookConfig& config, Listeners... ls)
+        : ob(config), listeners(std::move(ls)...) {}
+
+    NewOrderResponse process_new_order(int order_id, Side side, int price, int qty);
+    NewOrderView process_new_order_view(int order_id, Side side, int price, int qty);
+    TopOfBook top_of_book() const;
+    BookSnapshot print_book() const;
+
+    // Reports at most depth levels per side. The snapshot is reused by the next call,
+    // so after warm-up this does not allocate.
+    const BookSnapshot& print_book(std::size_t depth) const;
+    CancelResult cancel_order(int order_id);
+
+    // Cancels every resting order of side priced from min_price to max_price and sends a
+    // CXL for each, best level first and in time priority within a level, then the level
+    // and touch changes. Returns the number of orders cancelled.
+    std::size_t mass_cancel(Side side, int min_price = 1, int max_price = INT_MAX);
+
+    // Cancels every resting order, bids then asks
+    std::size_t mass_cancel();
+
+    // Changes a resting order's price and quantity (see OrderBook::amend). A new price that
+    // reaches the other side trades like an incoming order, after the AMD event.
+    // Non-positive price or qty is rejected as BAD and nothing is amended.
+    AmendResult amend_order(int order_id, int price, int qty);
+
+    // Reports a command the parser rejected to the listeners, in order with engine events
+    void report_reject(int order_id, RejectReason rr);
+
+    // Runs one parsed command, returns false when the command is Exit
+    bool process_command(const Command& cmd);
+
+    // Runs commands in order with the same results and events as process_command on each,
+    // stopping after an Exit (and then returning false). While a command runs, the index
+    // slots and then the order nodes and levels of the commands after it are prefetched.
+    bool process_batch(CommandSpan commands);
+
+    const OrderBook& order_book() const { return ob; }
+
+    // Turns on BBO feed mode, where listeners get on_tob whenever the best bid or ask
+    // price or quantity changes, not only on P
+    void set_bbo_feed(bool enabled) { bbo_feed = enabled; }
+
+    // Saves the engine's state (its book) for a later warm start, see OrderBook::save
+    void save_snapshot(SnapshotWriter& out) const { ob.save(out); }
+
+    // Restores state written by save_snapshot into a fresh engine, false if it is malformed
+    bool load_snapshot(SnapshotReader& in) { return ob.load(in); }
+
+    template <std::size_t I>
+    auto& listener() { return std::get<I>(listeners); }
+};
+
+template <typename... Listeners>
+NewOrderResponse BasicMatchingEngine<Listeners...>::process_new_order(int order_id, Side side, int price, int qty){
+    NewOrderView view = process_new_order_view(order_id, side, price, qty);
+    return NewOrderResponse{view.accepted, view.reject_reason, std::vector<Trade>(view.trades.begin(), view.trades.end())};
+}
+
+template <typename... Listeners>
+NewOrderView BasicMatchingEngine<Listeners...>::process_new_order_view(int order_id, Side side, int price, int qty){
+    PROFILE_COMMAND();
+    trade_buffer.clear();
+    TopOfBook before;
+    if (bbo_feed) before = ob.top_of_book();
+    if (ob.has_order(order_id)){
+        PROFILE_LAP(Validate);
+        emit([&](auto& l){ l.on_reject(order_id, RejectReason::DUP); });
+        PROFILE_LAP(Dispatch);
+        return NewOrderView{false, RejectReason::DUP, TradeView{}};
+    }
+    if (price <= 0 || qty <= 0){
+        PROFILE_LAP(Validate);
+        emit([&](auto& l){ l.on_reject(order_id, RejectReason::BAD); });
+        PROFILE_LAP(Dispatch);
+        return NewOrderView{false, RejectReason::BAD, TradeView{}};
+    }
+    PROFILE_LAP(Validate);
+
+    // Order Acknowledged
+    emit([&](auto& l){ l.on_ack(order_id); });
+    PROFILE_LAP(Dispatch);
+
+    int remaining_qty = qty;
+    if (side == Side::Buy) order_match_buy(order_id, price, remaining_qty);
+    else order_match_sell(order_id, price, remaining_qty);
+    PROFILE_LAP(Match);
+    for (const Trade& trade : trade_buffer){
+        emit([&](auto& l){ l.on_trade(trade); });
+    }
+    PROFILE_LAP(Dispatch);
+
+    if (remaining_qty > 0){
+        ob.add_limit(order_id, side, price, remaining_qty, level_updates());
+        PROFILE_LAP(Rest);
+    }
+    emit_level_updates();
+    if (bbo_feed) emit_touch_change(before);
+    PROFILE_LAP(Dispatch);
+    return NewOrderView{true, std::nullopt, TradeView{trade_buffer.data(), trade_buffer.size()}};
+}
+
+template <typename... Listeners>
+void BasicMatchingEngine<Listeners...>::order_match_buy(int incoming_id, int incoming_price, int& remaining_qty){
+    while (remaining_qty > 0 && ob.has_best_ask()){
+        int price = ob.best_ask_price();
+        if (price > incoming_price){
+            break;
+        }
+        int fill_qty = std::min(ob.best_ask_quantity(), remaining_qty);
+        fill_buffer.clear();
+        ob.consume_best_ask(fill_qty, fill_buffer, level_updates());
+        for (const Fill& f : fill_buffer){
+            trade_buffer.push_back(Trade{incoming_id, f.resting_order_id, price, f.qty_filled});
+            remaining_qty -= f.qty_filled;
+        }
+    }
+}
+
+template <typename... Listeners>
+void BasicMatchingEngine<Listeners...>::order_match_sell(int incoming_id, int incoming_price, int& remaining_qty){
+    while (remaining_qty > 0 && ob.has_best_bid()){
+        int price = ob.best_bid_price();
+        if (price < incoming_price){
+            break;
+        }
+        int fill_qty = std::min(ob.best_bid_quantity(), remaining_qty);
+        fill_buffer.clear();
+        ob.consume_best_bid(fill_qty, fill_buffer, level_updates());
+        for (const Fill& f : fill_buffer){
+            trade_buffer.push_back(Trade{f.resting_order_id, incoming_id, price, f.qty_filled});
+            remaining_qty -= f.qty_filled;
+        }
+    }
+}
+
+template <typename... Listeners>
+TopOfBook BasicMatchingEngine<Listeners...>::top_of_book() const{
+    TopOfBook tob = ob.top_of_book();
+    emit([&](auto& l){ l.on_tob(tob); });
+    return tob;
+}
+
+template <typename... Listeners>
+BookSnapshot BasicMatchingEngine<Listeners...>::print_book() const{
+    BookSnapshot bs = ob.print_book();
+    emit([&](auto& l){ l.on_book(bs); });
+    return bs;
+}
+
+template <typename... Listeners>
+const BookSnapshot& BasicMatchingEngine<Listeners...>::print_book(std::size_t depth) const{
+    ob.print_book(depth, depth_snapshot);
+    emit([&](auto& l){ l.on_book(depth_snapshot); });
+    return depth_snapshot;
+}
+
+template <typename... Listeners>
+CancelResult BasicMatchingEngine<Listeners...>::cancel_order(int order_id){
+    PROFILE_COMMAND();
+    TopOfBook before;
+    if (bbo_feed) before = ob.top_of_book();
+    CancelResult res = ob.cancel(order_id, level_updates());
+    PROFILE_LAP(Cancel);
+    emit([&](auto& l){ l.on_cancel(order_id, res); });
+    emit_level_updates();
+    if (bbo_feed) emit_touch_change(before);
+    PROFILE_LAP(Dispatch);
+    return res;
+}
+
+template <typename... Listeners>
+std::size_t BasicMatchingEngine<Listeners...>::mass_cancel(Side side, int min_price, int max_price){
+    PROFILE_COMMAND();
+    TopOfBook before;
+    if (bbo_feed) before = ob.top_of_book();
+    cancel_buffer.clear();
+    ob.mass_cancel(side, min_price, max_price, cancel_buffer, level_updates());
+    PROFILE_LAP(Cancel);
+    emit_mass_cancel(before);
+    PROFILE_LAP(Dispatch);
+    return cancel_buffer.size();
+}
+
+template <typename... Listeners>
+std::size_t BasicMatchingEngine<Listeners...>::mass_cancel(){
+    PROFILE_COMMAND();
+    TopOfBook before;
+    if (bbo_feed) before = ob.top_of_book();
+    cancel_buffer.clear();
+    ob.mass_cancel(Side::Buy, INT_MIN, INT_MAX, cancel_buffer, level_updates());
+    ob.mass_cancel(Side::Sell, INT_MIN, INT_MAX, cancel_buffer, level_updates());
+    PROFILE_LAP(Cancel);
+    emit_mass_cancel(before);
+    PROFILE_LAP(Dispatch);
+    return cancel_buffer.size();
+}
+
+template <typename... Listeners>
+AmendResult BasicMatchingEngine<Listeners...>::amend_order(int order_id, int price, int qty){
+    PROFILE_COMMAND();
+    if (price <= 0 || qty <= 0){
+        emit([&](auto& l){ l.on_reject(order_id, RejectReason::BAD); });
+        return AmendResult::Unknown;
+    }
+    TopOfBook before;
+    if (bbo_feed) before = ob.top_of_book();
+    AmendOutcome outcome = ob.amend(order_id, price, qty, level_updates());
+    PROFILE_LAP(Amend);
+    AmendResult res = outcome.action == AmendAction::Unknown ? AmendResult::Unknown : AmendResult::Amended;
+    emit([&](auto& l){ l.on_amend(order_id, res); });
+    PROFILE_LAP(Dispatch);
+
+    if (outcome.action == AmendAction::Pulled){
+        trade_buffer.clear();
+        int remaining_qty = qty;
+        if (outcome.side == Side::Buy) order_match_buy(order_id, price, remaining_qty);
+        else order_match_sell(order_id, price, remaining_qty);
+        PROFILE_LAP(Match);
+        for (const Trade& trade : trade_buffer){
+            emit([&](auto& l){ l.on_trade(trade); });
+        }
+        PROFILE_LAP(Dispatch);
+        if (remaining_qty > 0){
+            ob.rest_pulled(order_id, outcome.side, price, remaining_qty, level_updates());
+            PROFILE_LAP(Rest);
+        }
+    }
+    emit_level_updates();
+    if (bbo_feed) emit_touch_change(before);
+    PROFILE_LAP(Dispatch);
+    return res;
+}
+
+template <typename... Listeners>
+void BasicMatchingEngine<Listeners...>::report_reject(int order_id, RejectReason rr){
+    emit([&](auto& l){ l.on_reject(order_id, rr); });
+}
+
+template <typename... Listeners>
+bool BasicMatchingEngine<Listeners...>::process_command(const Command& cmd){
+    int order_id = static_cast<int>(cmd.order_id);
+    switch (cmd.type) {
+        case CommandType::New:
+            process_new_order_view(order_id, cmd.side, cmd.price, cmd.qty);
+            break;
+        case CommandType::Reject:
+            report_reject(order_id, cmd.reject_reason);
+            break;
+        case CommandType::Cancel:
+            cancel_order(order_id);
+            break;
+        case CommandType::Amend:
+            amend_order(order_id, cmd.price, cmd.qty);
+            break;
+        case CommandType::MassCancel:
+            mass_cancel();
+            break;
+        case CommandType::MassCancelSide:
+            mass_cancel(cmd.side, cmd.price, cmd.qty);
+            break;
+        case CommandType::PrintTopOfBook:
+            top_of_book();
+            break;
+        case CommandType::PrintFullBook:
+            if (cmd.qty > 0) print_book(static_cast<std::size_t>(cmd.qty));
+            else print_book();
+            break;
+        case CommandType::Exit:
+            return false;
+    }
+    return true;
+}
+
+template <typename... Listeners>
+bool BasicMatchingEngine<Listeners...>::process_batch(CommandSpan commands){
+    // a command's index slot is fetched 16 commands ahead, so it has arrived when the
+    // second stage reads it 8 commands ahead to fetch the node and level
+    constexpr std::size_t index_distance = 16;
+    constexpr std::size_t entry_distance = 8;
+
+    bool running = true;
+    for (std::size_t i = 0; i < commands.size() && running; ++i){
+        if (i + index_distance < commands.size()) prefetch_index(commands[i + index_distance]);
+        if (i + entry_distance < commands.size()) prefetch_entries(commands[i + entry_distance]);
+        running = process_command(commands[i]);
+    }
+    return running;
+}
@@ -0,0 +1,61 @@
+/**
+binary_command.cpp
+--------------
+Implements encoding and decoding of fixed-width binary command records
+ */
+
+#include "binary_command.hpp"
+
+BinaryRecord encode_command(const Command& cmd){
+    BinaryRecord rec{};
+    rec.type = static_cast<std::uint8_t>(cmd.type);
+    rec.side = static_cast<std::uint8_t>(cmd.side);
+    rec.reject_reason = static_cast<std::uint8_t>(cmd.reject_reason);
+    rec.order_id = static_cast<std::int32_t>(cmd.order_id);
+    rec.price = cmd.price;
+    rec.qty = cmd.qty;
+    rec.symbol = cmd.symbol;
+    return rec;
+}
+
+// BAD reject of a record whose fields break the text grammar, order_id as the text parser gives it
+static Command reject_record(const BinaryRecord& rec, std::int32_t order_id){
+    Command cmd{CommandType::Reject, order_id};
+    cmd.reject_reason = RejectReason::BAD;
+    cmd.symbol = rec.symbol;
+    return cmd;
+}
+
+Command decode_command(const BinaryRecord& rec){
+    if (rec.type > static_cast<std::uint8_t>(CommandType::MassCancelSide)
+        || rec.side > static_cast<std::uint8_t>(Side::Sell)
+        || rec.reject_reason > static_cast<std::uint8_t>(RejectReason::DUP)){
+        return Command{CommandType::Reject};
+    }
+
+    // the same checks as parse_command_view, so a record cannot carry a command its line could not
+    CommandType type = static_cast<CommandType>(rec.type);
+    switch (type){
+        case CommandType::New:
+        case CommandType::Amend:
+            if (rec.order_id <= 0) return reject_record(rec, 0);
+            if (rec.price <= 0 || rec.qty <= 0) return reject_record(rec, rec.order_id);
+            break;
+        case CommandType::Cancel:
+            if (rec.order_id <= 0) return reject_record(rec, 0);
+            break;
+        case CommandType::MassCancelSide:
+            if (rec.price <= 0 || rec.qty < rec.price) return reject_record(rec, 0);
+            break;
+        case CommandType::PrintFullBook:
+            if (rec.qty < 0) return reject_record(rec, 0);
+            break;
+        default:
+            break;
+    }
+
+    Command cmd{type, rec.order_id, static_cast<Side>(rec.side), rec.price, rec.qty};
+    cmd.reject_reason = static_cast<RejectReason>(rec.reject_reason);
+    cmd.symbol = rec.symbol;
+    return cmd;
+}
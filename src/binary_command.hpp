@@ -0,0 +1,77 @@
+/**
+binary_command.hpp
+--------------
+Defines the fixed-width binary command format.
+A binary command file is an 8-byte magic header followed by 24-byte
+records, one per input line, in native byte order:
+
+  offset  size  field
+       0     1  CommandType
+       1     1  Side
+       2     1  RejectReason
+       3     1  reserved (0)
+       4     4  order id
+       8     4  price
+      12     4  quantity
+      16     8  symbol
+
+Malformed text lines are stored as Reject records carrying the order id
+and reason the text parser produced, so replaying a converted file gives
+exactly the output of the text file.
+ */
+
+#pragma once
+
+#include "command.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+constexpr std::string_view binary_command_magic("EXCMDB1\n", 8);
+constexpr std::size_t binary_record_size = 24;
+
+struct BinaryRecord {
+    std::uint8_t type;
+    std::uint8_t side;
+    std::uint8_t reject_reason;
+    std::uint8_t reserved;
+    std::int32_t order_id;
+    std::int32_t price;
+    std::int32_t qty;
+    std::uint64_t symbol;
+};
+
+static_assert(sizeof(BinaryRecord) == binary_record_size, "BinaryRecord must have no padding");
+
+BinaryRecord encode_command(const Command& cmd);
+
+// Records with an out of range type or side decode to Reject(BAD), like a malformed line.
+// So do records whose ids, prices or quantities the text grammar does not allow (for
+// example order id 0), with the order id the text parser would report.
+Command decode_command(const BinaryRecord& rec);
+
+// True if data starts with the binary command header
+inline bool is_binary_commands(std::string_view data){
+    return data.substr(0, binary_command_magic.size()) == binary_command_magic;
+}
+
+// Commands of a binary command buffer (header included), read straight from the buffer.
+// A truncated record at the end is ignored.
+class BinaryCommandReader {
+private:
+    std::string_view rest;
+
+public:
+    explicit BinaryCommandReader(std::string_view buffer)
+        : rest(buffer.substr(is_binary_commands(buffer) ? binary_command_magic.size() : buffer.size())) {}
+
+    bool next(Command& cmd) {
+        if (rest.size() < binary_record_size) return false;
+        BinaryRecord rec;
+        std::memcpy(&rec, rest.data(), binary_record_size);
+        rest.remove_prefix(binary_record_size);
+        cmd = decode_command(rec);
+        return true;
+    }
+};
@@ -0,0 +1,86 @@
+/*
+command.hpp
+-----------------
+Defines the Command data model shared by the parser and the engine.
+*/
+
+#pragma once
+
+#include "common.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Instrument symbol: 1-8 characters from [A-Z0-9._] starting with A-Z,
+// packed into an integer with the first character in the low byte.
+// Commands that name no symbol use default_symbol.
+using Symbol = std::uint64_t;
+constexpr Symbol default_symbol = 0;
+
+// Packs text into out, returns false if text is not a valid symbol
+inline bool parse_symbol(std::string_view text, Symbol& out){
+    if (text.empty() || text.size() > 8 || text[0] < 'A' || text[0] > 'Z') return false;
+    Symbol packed = 0;
+    for (std::size_t i = 0; i < text.size(); ++i){
+        char ch = text[i];
+        bool valid = (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '.' || ch == '_';
+        if (!valid) return false;
+        packed |= static_cast<Symbol>(static_cast<unsigned char>(ch)) << (8 * i);
+    }
+    out = packed;
+    return true;
+}
+
+// Returns the text of a packed symbol, empty for default_symbol
+inline std::string symbol_name(Symbol symbol){
+    std::string name;
+    for (; symbol != 0; symbol >>= 8){
+        name.push_back(static_cast<char>(symbol & 0xFF));
+    }
+    return name;
+}
+
+enum class CommandType {
+    New,
+    Cancel,
+    PrintTopOfBook,
+    PrintFullBook,
+    Exit,
+    Reject,
+    Amend,          // new price and qty of a resting order, its side is kept
+    MassCancel,     // every resting order of both sides
+    MassCancelSide  // resting orders of side priced from price to qty, inclusive
+};
+
+struct Command {
+    CommandType type;
+
+    std::int64_t order_id = 0;
+    
+    Side side = Side::Buy;
+    std::int32_t price = 0;        // MassCancelSide: lowest price cancelled
+    std::int32_t qty = 0;          // PrintFullBook: levels per side to print, 0 = all
+                                   // MassCancelSide: highest price cancelled
+
+    RejectReason reject_reason = RejectReason::BAD; 
+
+    Symbol symbol = default_symbol;
+};
+
+// Non-owning view of consecutive commands, the input of BasicMatchingEngine::process_batch
+struct CommandSpan {
+    const Command* data = nullptr;
+    std::size_t count = 0;
+
+    CommandSpan() = default;
+    CommandSpan(const Command* data, std::size_t count) : data(data), count(count) {}
+    CommandSpan(const std::vector<Command>& commands) : data(commands.data()), count(commands.size()) {}
+
+    const Command* begin() const { return data; }
+    const Command* end() const { return data + count; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const Command& operator[](std::size_t i) const { return data[i]; }
+};
@@ -0,0 +1,88 @@
+/**
+command_wal.cpp
+--------------
+Implements appending, syncing and reopening the write-ahead command journal
+ */
+
+#include "command_wal.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CommandWal::CommandWal(WalSync mode, std::size_t group)
+    : sync_mode(mode), group_size(group == 0 ? 1 : group) {
+    buffer.reserve((1 << 16) + binary_record_size);
+}
+
+CommandWal::~CommandWal(){
+    if (fd < 0) return;
+    commit();
+    ::close(fd);
+}
+
+bool CommandWal::open(const char* path){
+    fd = ::open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) return false;
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    if (size == 0){
+        buffer.append(binary_command_magic);
+        return commit();
+    }
+
+    char header[binary_command_magic.size()];
+    if (size < sizeof(header) || ::pread(fd, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))
+        || !is_binary_commands(std::string_view(header, sizeof(header)))){
+        return false;
+    }
+    recovered = (size - sizeof(header)) / binary_record_size;
+    std::size_t complete = sizeof(header) + recovered * binary_record_size;
+    if (complete != size && ::ftruncate(fd, static_cast<off_t>(complete)) != 0) return false;
+    return true;
+}
+
+bool CommandWal::write_buffer(){
+    const char* p = buffer.data();
+    std::size_t left = buffer.size();
+    while (left > 0 && !write_failed){
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0){
+            if (errno == EINTR) continue;
+            write_failed = true;
+            break;
+        }
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+    buffer.clear();
+    return !write_failed;
+}
+
+bool CommandWal::commit(){
+    if (fd < 0 || write_failed) return false;
+    if (!buffer.empty() && !write_buffer()) return false;
+    if (sync_mode != WalSync::None && unsynced != 0){
+        if (::fdatasync(fd) != 0){
+            write_failed = true;
+            return false;
+        }
+        ++syncs;
+    }
+    unsynced = 0;
+    return true;
+}
+
+bool CommandWal::reset(){
+    if (fd < 0 || write_failed) return false;
+    buffer.clear();
+    unsynced = 0;
+    if (::ftruncate(fd, static_cast<off_t>(binary_command_magic.size())) != 0 || ::fdatasync(fd) != 0){
+        write_failed = true;
+        return false;
+    }
+    ++syncs;
+    return true;
+}
@@ -0,0 +1,78 @@
+/**
+command_wal.hpp
+--------------
+Defines CommandWal, the write-ahead journal of processed commands.
+The journal is a binary command file (see binary_command.hpp), so it can be
+replayed with BinaryCommandReader or fed back to the simulator as input.
+Records are appended before the command runs and reach the file no later
+than the events they cause: the owner calls commit() before writing any
+buffered output. How often the file is synced trades durability for latency:
+
+  None    records are written, never synced. Survives a process crash,
+          not a machine crash.
+  Group   fdatasync once every group_size records, and on every commit()
+          that writes output. Durable up to the last group.
+  Always  write and fdatasync every record before it runs.
+ */
+
+#pragma once
+
+#include "binary_command.hpp"
+#include "command.hpp"
+#include <cstddef>
+#include <string>
+
+enum class WalSync {
+    None,
+    Group,
+    Always
+};
+
+class CommandWal {
+private:
+    int fd = -1;
+    WalSync sync_mode;
+    std::size_t group_size;
+    std::string buffer;
+    std::size_t unsynced = 0;     // records written or buffered since the last sync
+    std::size_t recovered = 0;
+    std::size_t syncs = 0;
+    bool write_failed = false;
+
+    bool write_buffer();
+
+public:
+    explicit CommandWal(WalSync mode = WalSync::Group, std::size_t group = 256);
+    ~CommandWal();
+
+    CommandWal(const CommandWal&) = delete;
+    CommandWal& operator=(const CommandWal&) = delete;
+
+    // Opens path for appending, creating it with the binary command header.
+    // An incomplete record left at the end by a crash is cut off.
+    // Returns false if the file cannot be opened or is not a command journal.
+    bool open(const char* path);
+
+    // Logs cmd ahead of running it. Returns false once a write or sync has failed.
+    bool append(const Command& cmd) {
+        BinaryRecord rec = encode_command(cmd);
+        buffer.append(reinterpret_cast<const char*>(&rec), binary_record_size);
+        ++unsynced;
+        if (sync_mode == WalSync::Always) return commit();
+        if (sync_mode == WalSync::Group && unsynced >= group_size) return commit();
+        if (buffer.size() >= (1 << 16)) return write_buffer();
+        return !write_failed;
+    }
+
+    // Writes buffered records and syncs them (unless the mode is None)
+    bool commit();
+
+    // Drops every record, leaving only the header; used once a snapshot covers them
+    bool reset();
+
+    // Complete records that were in the file when it was opened
+    std::size_t recovered_records() const { return recovered; }
+
+    std::size_t sync_count() const { return syncs; }
+    bool failed() const { return write_failed; }
+};
@@ -19,6 +19,16 @@ enum class RejectReason {
     DUP
 };
 
+enum class CancelResult {
+    Cancelled,
+    Unknown
+};
+
+enum class AmendResult {
+    Amended,
+    Unknown
+};
+
 struct Trade {
     int buy_id;
     int sell_id;
@@ -31,6 +41,13 @@ struct PriceLevel {
     int qty;
 };
 
+// New aggregate quantity of one price level after a change, qty is 0 when the level was removed
+struct LevelUpdate {
+    Side side;
+    int price;
+    int qty;
+};
+
 struct TopOfBook {
     std::optional<PriceLevel> best_ask;
     std::optional<PriceLevel> best_bid;
@@ -0,0 +1,102 @@
+/**
+event_format.hpp
+--------------
+Defines the text format of engine events. Each function appends one or
+more complete output lines to a string, formatting integers with
+std::to_chars. PrinterListener and TestListener both format through here,
+so production and golden-test output are byte-identical.
+ */
+
+#pragma once
+
+#include "common.hpp"
+#include <charconv>
+#include <string>
+#include <string_view>
+
+inline void append_int(std::string& out, int value){
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr - digits);
+}
+
+// "<prefix><tag><a><suffix>", tag and suffix carry their own spaces and newline
+inline void append_line(std::string& out, std::string_view prefix, std::string_view tag, int a,
+                        std::string_view suffix = "\n"){
+    out.append(prefix);
+    out.append(tag);
+    append_int(out, a);
+    out.append(suffix);
+}
+
+// "<prefix><tag><a> <b>\n"
+inline void append_pair(std::string& out, std::string_view prefix, std::string_view tag, int a, int b){
+    out.append(prefix);
+    out.append(tag);
+    append_int(out, a);
+    out.push_back(' ');
+    append_int(out, b);
+    out.push_back('\n');
+}
+
+inline void append_ack(std::string& out, std::string_view prefix, int order_id){
+    append_line(out, prefix, "ACK ", order_id);
+}
+
+inline void append_reject(std::string& out, std::string_view prefix, int order_id, RejectReason rr){
+    if (rr == RejectReason::BAD){
+        append_line(out, prefix, "REJ ", order_id, " BAD\n");
+    }
+    else if (rr == RejectReason::DUP){
+        append_line(out, prefix, "REJ ", order_id, " DUP\n");
+    }
+}
+
+inline void append_trade(std::string& out, std::string_view prefix, const Trade& trd){
+    out.append(prefix);
+    out.append("TRD ");
+    append_int(out, trd.buy_id);
+    out.push_back(' ');
+    append_int(out, trd.sell_id);
+    out.push_back(' ');
+    append_int(out, trd.price);
+    out.push_back(' ');
+    append_int(out, trd.qty);
+    out.push_back('\n');
+}
+
+inline void append_cancel(std::string& out, std::string_view prefix, int order_id, CancelResult cr){
+    if (cr == CancelResult::Cancelled){
+        append_line(out, prefix, "CXL ", order_id);
+    }
+    if (cr == CancelResult::Unknown){
+        append_line(out, prefix, "REJ ", order_id, " UNK\n");
+    }
+}
+
+inline void append_amend(std::string& out, std::string_view prefix, int order_id, AmendResult ar){
+    if (ar == AmendResult::Amended){
+        append_line(out, prefix, "AMD ", order_id);
+    }
+    if (ar == AmendResult::Unknown){
+        append_line(out, prefix, "REJ ", order_id, " UNK\n");
+    }
+}
+
+inline void append_tob(std::string& out, std::string_view prefix, const TopOfBook& tob){
+    if (tob.best_bid.has_value()){
+        append_pair(out, prefix, "TOB BID ", tob.best_bid->price, tob.best_bid->qty);
+    }
+    if (tob.best_ask.has_value()){
+        append_pair(out, prefix, "TOB ASK ", tob.best_ask->price, tob.best_ask->qty);
+    }
+}
+
+inline void append_book(std::string& out, std::string_view prefix, const BookSnapshot& bs){
+    for (const PriceLevel& pl : bs.bids){
+        append_pair(out, prefix, "BOOK BID ", pl.price, pl.qty);
+    }
+    for (const PriceLevel& pl : bs.asks){
+        append_pair(out, prefix, "BOOK ASK ", pl.price, pl.qty);
+    }
+}
@@ -0,0 +1,253 @@
+/**
+event_journal.cpp
+--------------
+Implements varint/delta encoding and decoding of the binary event journal
+ */
+
+#include "event_journal.hpp"
+
+EventJournal::EventJournal(OutputBuffer& buffer) : out(&buffer) {
+    out->text().append(journal_magic);
+    out->commit();
+}
+
+void EventJournal::put_varint(std::uint64_t value){
+    std::string& data = out->text();
+    while (value >= 0x80){
+        data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<char>(value));
+}
+
+// zigzag: small magnitudes of either sign get short varints
+void EventJournal::put_signed(std::int64_t value){
+    put_varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+void EventJournal::put_tag(JournalTag tag, std::uint8_t flag){
+    out->text().push_back(static_cast<char>(static_cast<std::uint8_t>(tag) | (flag << 4)));
+}
+
+void EventJournal::put_id(int id){
+    put_signed(id - last_id);
+    last_id = id;
+}
+
+void EventJournal::put_price(int price){
+    put_signed(price - last_price);
+    last_price = price;
+}
+
+void EventJournal::select(Symbol book){
+    if (book == symbol) return;
+    symbol = book;
+    put_tag(JournalTag::Symbol);
+    put_varint(book);
+}
+
+void EventJournal::ack(int order_id){
+    put_tag(JournalTag::Ack);
+    put_id(order_id);
+    ++event_count;
+    out->commit();
+}
+
+void EventJournal::reject(int order_id, RejectReason rr){
+    put_tag(JournalTag::Reject, static_cast<std::uint8_t>(rr));
+    put_id(order_id);
+    ++event_count;
+    out->commit();
+}
+
+void EventJournal::cancel(int order_id, CancelResult cr){
+    put_tag(JournalTag::Cancel, static_cast<std::uint8_t>(cr));
+    put_id(order_id);
+    ++event_count;
+    out->commit();
+}
+
+void EventJournal::amend(int order_id, AmendResult ar){
+    put_tag(JournalTag::Amend, static_cast<std::uint8_t>(ar));
+    put_id(order_id);
+    ++event_count;
+    out->commit();
+}
+
+void EventJournal::trade(const Trade& trd){
+    put_tag(JournalTag::Trade);
+    put_id(trd.buy_id);
+    put_id(trd.sell_id);
+    put_price(trd.price);
+    put_varint(static_cast<std::uint32_t>(trd.qty));
+    ++event_count;
+    out->commit();
+}
+
+void EventJournal::tob(const TopOfBook& tob){
+    std::uint8_t flag = (tob.best_bid ? 1 : 0) | (tob.best_ask ? 2 : 0);
+    put_tag(JournalTag::Tob, flag);
+    if (tob.best_bid){
+        put_price(tob.best_bid->price);
+        put_varint(static_cast<std::uint32_t>(tob.best_bid->qty));
+    }
+    if (tob.best_ask){
+        put_price(tob.best_ask->price);
+        put_varint(static_cast<std::uint32_t>(tob.best_ask->qty));
+    }
+    ++event_count;
+    out->commit();
+}
+
+void EventJournal::book(const BookSnapshot& bs){
+    put_tag(JournalTag::Book);
+    put_varint(bs.bids.size());
+    put_varint(bs.asks.size());
+    for (const PriceLevel& pl : bs.bids){
+        put_price(pl.price);
+        put_varint(static_cast<std::uint32_t>(pl.qty));
+    }
+    for (const PriceLevel& pl : bs.asks){
+        put_price(pl.price);
+        put_varint(static_cast<std::uint32_t>(pl.qty));
+    }
+    ++event_count;
+    out->commit();
+}
+
+JournalDecoder::JournalDecoder(std::string_view journal){
+    if (journal.substr(0, journal_magic.size()) == journal_magic){
+        rest = journal.substr(journal_magic.size());
+    }
+    else {
+        corrupt = true;
+    }
+}
+
+bool JournalDecoder::get_varint(std::uint64_t& value){
+    value = 0;
+    for (int shift = 0; shift < 64 && !rest.empty(); shift += 7){
+        std::uint8_t byte = static_cast<std::uint8_t>(rest[0]);
+        rest.remove_prefix(1);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    corrupt = true;
+    return false;
+}
+
+bool JournalDecoder::get_signed(std::int64_t& value){
+    std::uint64_t raw;
+    if (!get_varint(raw)) return false;
+    value = static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+    return true;
+}
+
+bool JournalDecoder::get_id(int& id){
+    std::int64_t delta;
+    if (!get_signed(delta)) return false;
+    last_id += delta;
+    id = static_cast<int>(last_id);
+    return true;
+}
+
+bool JournalDecoder::get_price(int& price){
+    std::int64_t delta;
+    if (!get_signed(delta)) return false;
+    last_price += delta;
+    price = static_cast<int>(last_price);
+    return true;
+}
+
+bool JournalDecoder::get_qty(int& qty){
+    std::uint64_t raw;
+    if (!get_varint(raw)) return false;
+    qty = static_cast<int>(static_cast<std::uint32_t>(raw));
+    return true;
+}
+
+bool JournalDecoder::next(IEventListener& target){
+    while (!corrupt && !rest.empty()){
+        std::uint8_t tag_byte = static_cast<std::uint8_t>(rest[0]);
+        rest.remove_prefix(1);
+        std::uint8_t flag = tag_byte >> 4;
+
+        switch (static_cast<JournalTag>(tag_byte & 0x0F)){
+            case JournalTag::Symbol: {
+                std::uint64_t book_symbol;
+                if (!get_varint(book_symbol)) return false;
+                symbol = book_symbol;
+                continue;
+            }
+            case JournalTag::Ack: {
+                int id;
+                if (!get_id(id)) return false;
+                target.on_ack(id);
+                return true;
+            }
+            case JournalTag::Reject: {
+                int id;
+                if (!get_id(id)) return false;
+                target.on_reject(id, static_cast<RejectReason>(flag));
+                return true;
+            }
+            case JournalTag::Cancel: {
+                int id;
+                if (!get_id(id)) return false;
+                target.on_cancel(id, static_cast<CancelResult>(flag));
+                return true;
+            }
+            case JournalTag::Amend: {
+                int id;
+                if (!get_id(id)) return false;
+                target.on_amend(id, static_cast<AmendResult>(flag));
+                return true;
+            }
+            case JournalTag::Trade: {
+                Trade trd;
+                if (!get_id(trd.buy_id) || !get_id(trd.sell_id) || !get_price(trd.price) || !get_qty(trd.qty)){
+                    return false;
+                }
+                target.on_trade(trd);
+                return true;
+            }
+            case JournalTag::Tob: {
+                TopOfBook tob;
+                PriceLevel pl;
+                if (flag & 1){
+                    if (!get_price(pl.price) || !get_qty(pl.qty)) return false;
+                    tob.best_bid = pl;
+                }
+                if (flag & 2){
+                    if (!get_price(pl.price) || !get_qty(pl.qty)) return false;
+                    tob.best_ask = pl;
+                }
+                target.on_tob(tob);
+                return true;
+            }
+            case JournalTag::Book: {
+                std::uint64_t bids, asks;
+                if (!get_varint(bids) || !get_varint(asks)) return false;
+                // every level takes at least two bytes
+                if (bids + asks > rest.size() / 2){
+                    corrupt = true;
+                    return false;
+                }
+                book.bids.resize(bids);
+                book.asks.resize(asks);
+                for (PriceLevel& pl : book.bids){
+                    if (!get_price(pl.price) || !get_qty(pl.qty)) return false;
+                }
+                for (PriceLevel& pl : book.asks){
+                    if (!get_price(pl.price) || !get_qty(pl.qty)) return false;
+                }
+                target.on_book(book);
+                return true;
+            }
+            default:
+                corrupt = true;
+                return false;
+        }
+    }
+    return false;
+}
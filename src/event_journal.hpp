@@ -0,0 +1,146 @@
+/**
+event_journal.hpp
+--------------
+Defines the binary event journal, a compact alternative to text output.
+An 8-byte magic header is followed by one record per event:
+
+  tag byte   low 4 bits event kind, high 4 bits flag
+             (RejectReason, CancelResult, AmendResult, or TOB has-bid/has-ask bits)
+  fields     LEB128 varints. Order ids are zigzag deltas from the previous
+             id in the journal, prices zigzag deltas from the previous price,
+             quantities and counts plain varints.
+
+Symbol records switch the book that later events belong to, so the printers
+of several books can share one journal. JournalDecoder replays a journal
+into any IEventListener; through a PrinterListener with the symbol prefix
+it reproduces the text output exactly.
+ */
+
+#pragma once
+
+#include "command.hpp"
+#include "common.hpp"
+#include "events.hpp"
+#include "output_buffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+constexpr std::string_view journal_magic("EXJRNL1\n", 8);
+
+enum class JournalTag : std::uint8_t {
+    Ack,
+    Reject,
+    Cancel,
+    Trade,
+    Tob,
+    Book,
+    Symbol,
+    Amend
+};
+
+// Encoder state of one journal, shared by the JournalListeners writing to it
+class EventJournal {
+private:
+    OutputBuffer* out;
+    std::int64_t last_id = 0;
+    std::int64_t last_price = 0;
+    Symbol symbol = default_symbol;
+    std::size_t event_count = 0;
+
+    void put_varint(std::uint64_t value);
+    void put_signed(std::int64_t value);
+    void put_tag(JournalTag tag, std::uint8_t flag = 0);
+    void put_id(int id);
+    void put_price(int price);
+
+public:
+    // Writes the journal header to buffer
+    explicit EventJournal(OutputBuffer& buffer);
+
+    // Following events belong to book
+    void select(Symbol book);
+
+    void ack(int order_id);
+    void reject(int order_id, RejectReason rr);
+    void cancel(int order_id, CancelResult cr);
+    void amend(int order_id, AmendResult ar);
+    void trade(const Trade& trd);
+    void tob(const TopOfBook& tob);
+    void book(const BookSnapshot& bs);
+
+    std::size_t events() const { return event_count; }
+};
+
+// Writes the events of one book to a shared journal
+struct JournalListener : IEventListener {
+    EventJournal* journal;
+    Symbol symbol;
+
+    explicit JournalListener(EventJournal& j, Symbol book = default_symbol) : journal(&j), symbol(book) {}
+
+    void on_ack(int order_id) override {
+        journal->select(symbol);
+        journal->ack(order_id);
+    }
+
+    void on_reject(int order_id, RejectReason rr) override {
+        journal->select(symbol);
+        journal->reject(order_id, rr);
+    }
+
+    void on_cancel(int order_id, CancelResult cr) override {
+        journal->select(symbol);
+        journal->cancel(order_id, cr);
+    }
+
+    void on_amend(int order_id, AmendResult ar) override {
+        journal->select(symbol);
+        journal->amend(order_id, ar);
+    }
+
+    void on_trade(const Trade& trd) override {
+        journal->select(symbol);
+        journal->trade(trd);
+    }
+
+    void on_tob(const TopOfBook& tob) override {
+        journal->select(symbol);
+        journal->tob(tob);
+    }
+
+    void on_book(const BookSnapshot& bs) override {
+        journal->select(symbol);
+        journal->book(bs);
+    }
+};
+
+// Reads the events of a journal buffer back
+class JournalDecoder {
+private:
+    std::string_view rest;
+    std::int64_t last_id = 0;
+    std::int64_t last_price = 0;
+    Symbol symbol = default_symbol;
+    bool corrupt = false;
+    BookSnapshot book;
+
+    bool get_varint(std::uint64_t& value);
+    bool get_signed(std::int64_t& value);
+    bool get_id(int& id);
+    bool get_price(int& price);
+    bool get_qty(int& qty);
+
+public:
+    explicit JournalDecoder(std::string_view journal);
+
+    // Replays the next event into target. Returns false at the end of the
+    // journal, or when it is truncated or corrupt (then error() is true).
+    bool next(IEventListener& target);
+
+    // Book of the event last replayed
+    Symbol current_symbol() const { return symbol; }
+
+    bool error() const { return corrupt; }
+};
@@ -0,0 +1,51 @@
+/**
+event_ring.cpp
+--------------
+Implements replay of ring buffer event records into IEventListeners
+ */
+
+#include "event_ring.hpp"
+
+void EventReplayer::replay(const EventRecord& rec, IEventListener& target){
+    switch (rec.type){
+        case EventType::Ack:
+            target.on_ack(rec.v[0]);
+            break;
+        case EventType::Reject:
+            target.on_reject(rec.v[0], static_cast<RejectReason>(rec.flag));
+            break;
+        case EventType::Trade:
+            target.on_trade(Trade{rec.v[0], rec.v[1], rec.v[2], rec.v[3]});
+            break;
+        case EventType::Cancel:
+            target.on_cancel(rec.v[0], static_cast<CancelResult>(rec.flag));
+            break;
+        case EventType::Amend:
+            target.on_amend(rec.v[0], static_cast<AmendResult>(rec.flag));
+            break;
+        case EventType::Tob: {
+            TopOfBook tob;
+            if (rec.flag & 1) tob.best_bid = PriceLevel{rec.v[0], rec.v[1]};
+            if (rec.flag & 2) tob.best_ask = PriceLevel{rec.v[2], rec.v[3]};
+            target.on_tob(tob);
+            break;
+        }
+        case EventType::BookLevel:
+            if (static_cast<Side>(rec.flag) == Side::Buy) book.bids.push_back(PriceLevel{rec.v[0], rec.v[1]});
+            else book.asks.push_back(PriceLevel{rec.v[0], rec.v[1]});
+            break;
+        case EventType::BookEnd:
+            target.on_book(book);
+            book.bids.clear();
+            book.asks.clear();
+            break;
+    }
+}
+
+std::size_t EventReplayer::drain(EventRing& ring, IEventListener& target, std::size_t max){
+    return ring.consume([&](const EventRecord& rec){ replay(rec, target); }, max);
+}
+
+std::size_t EventReplayer::drain(EventRing& ring, const EventTargets& targets, std::size_t max){
+    return ring.consume([&](const EventRecord& rec){ replay(rec, targets[rec.book]); }, max);
+}
@@ -0,0 +1,156 @@
+/**
+event_ring.hpp
+--------------
+Defines the ring buffer output mode of the engine.
+EventRingWriter is a compile-time listener that appends compact tagged
+EventRecords to a preallocated EventRing instead of formatting events,
+and EventReplayer drains the ring in batches into IEventListeners.
+ */
+
+#pragma once
+
+#include "common.hpp"
+#include "events.hpp"
+#include "spsc_ring.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+enum class EventType : std::uint8_t {
+    Ack,
+    Reject,
+    Trade,
+    Cancel,
+    Tob,
+    BookLevel,
+    BookEnd,
+    Amend
+};
+
+// One engine event. Field use by type:
+//   Ack:       v[0] order id
+//   Reject:    v[0] order id, flag RejectReason
+//   Trade:     v[0] buy id, v[1] sell id, v[2] price, v[3] qty
+//   Cancel:    v[0] order id, flag CancelResult
+//   Amend:     v[0] order id, flag AmendResult
+//   Tob:       v[0] bid price, v[1] bid qty, v[2] ask price, v[3] ask qty,
+//              flag bit 0 = has bid, bit 1 = has ask
+//   BookLevel: v[0] price, v[1] qty, flag Side
+//   BookEnd:   ends the BookLevel records of one snapshot
+// book identifies which engine wrote the record when several share a ring. It is 32-bit,
+// as a run may have more books than a 16-bit index could tell apart.
+struct EventRecord {
+    EventType type;
+    std::uint8_t flag;
+    std::uint32_t book;
+    std::int32_t v[4];
+};
+
+using EventRing = SpscRing<EventRecord>;
+
+// Compile-time listener that writes every event into an EventRing.
+// When the ring is full on_full is called to make room (drain it, or wait for
+// the consumer thread) and the push is retried.
+struct EventRingWriter {
+    EventRing* ring = nullptr;
+    std::function<void()> on_full;
+    std::uint32_t book = 0;
+
+    void push(EventType type, std::uint8_t flag, std::int32_t a, std::int32_t b = 0,
+              std::int32_t c = 0, std::int32_t d = 0) {
+        EventRecord rec{type, flag, book, {a, b, c, d}};
+        while (!ring->try_push(rec)) on_full();
+    }
+
+    void on_ack(int order_id) {
+        push(EventType::Ack, 0, order_id);
+    }
+
+    void on_reject(int order_id, RejectReason rr) {
+        push(EventType::Reject, static_cast<std::uint8_t>(rr), order_id);
+    }
+
+    void on_cancel(int order_id, CancelResult cr) {
+        push(EventType::Cancel, static_cast<std::uint8_t>(cr), order_id);
+    }
+
+    void on_amend(int order_id, AmendResult ar) {
+        push(EventType::Amend, static_cast<std::uint8_t>(ar), order_id);
+    }
+
+    void on_trade(const Trade& trd) {
+        push(EventType::Trade, 0, trd.buy_id, trd.sell_id, trd.price, trd.qty);
+    }
+
+    void on_tob(const TopOfBook& tob) {
+        std::uint8_t flag = (tob.best_bid ? 1 : 0) | (tob.best_ask ? 2 : 0);
+        push(EventType::Tob, flag,
+             tob.best_bid ? tob.best_bid->price : 0, tob.best_bid ? tob.best_bid->qty : 0,
+             tob.best_ask ? tob.best_ask->price : 0, tob.best_ask ? tob.best_ask->qty : 0);
+    }
+
+    void on_book(const BookSnapshot& bs) {
+        for (const PriceLevel& pl : bs.bids){
+            push(EventType::BookLevel, static_cast<std::uint8_t>(Side::Buy), pl.price, pl.qty);
+        }
+        for (const PriceLevel& pl : bs.asks){
+            push(EventType::BookLevel, static_cast<std::uint8_t>(Side::Sell), pl.price, pl.qty);
+        }
+        push(EventType::BookEnd, 0, 0);
+    }
+};
+
+// Append-only list of the listeners that replay each book's records, indexed by
+// EventRecord::book. Entries are stored in fixed-size chunks under a directory sized
+// once, so adding a book never moves an entry: a pipeline's output thread may read
+// targets while the engine thread adds books. Each entry is written before any record
+// of its book is pushed, and the ring's release/acquire publishes it with the record.
+class EventTargets {
+private:
+    static constexpr std::size_t chunk_bits = 12;
+    static constexpr std::size_t chunk_size = std::size_t{1} << chunk_bits;
+    static constexpr std::size_t chunk_count = std::size_t{1} << 12;
+
+    std::unique_ptr<std::unique_ptr<IEventListener*[]>[]> chunks;
+    std::size_t count = 0;
+
+public:
+    static constexpr std::size_t max_books = chunk_size * chunk_count;
+
+    EventTargets() : chunks(new std::unique_ptr<IEventListener*[]>[chunk_count]) {}
+
+    // Adds the target of the next book index, false once max_books targets exist
+    bool push_back(IEventListener* target) {
+        if (count == max_books) return false;
+        std::unique_ptr<IEventListener*[]>& chunk = chunks[count >> chunk_bits];
+        if (!chunk) chunk.reset(new IEventListener*[chunk_size]);
+        chunk[count & (chunk_size - 1)] = target;
+        ++count;
+        return true;
+    }
+
+    IEventListener& operator[](std::size_t book) const {
+        return *chunks[book >> chunk_bits][book & (chunk_size - 1)];
+    }
+
+    std::size_t size() const { return count; }
+};
+
+// Replays EventRecords into an IEventListener. Book snapshots are rebuilt from
+// their BookLevel records, which may span several drains. Records from one
+// snapshot are always contiguous, since a book is written by a single engine call.
+class EventReplayer {
+private:
+    BookSnapshot book;
+
+public:
+    void replay(const EventRecord& rec, IEventListener& target);
+
+    // Drains up to max records from ring into target, returns the number replayed
+    std::size_t drain(EventRing& ring, IEventListener& target, std::size_t max = SIZE_MAX);
+
+    // Drains up to max records from ring, each into targets[record.book]
+    std::size_t drain(EventRing& ring, const EventTargets& targets, std::size_t max = SIZE_MAX);
+};
@@ -7,6 +7,7 @@ Defines event listener interface
 #pragma once
 
 #include "common.hpp"
+#include <vector>
 
 struct Trade;
 struct PriceLevel;
@@ -17,9 +18,46 @@ struct IEventListener {
   virtual void on_ack(int) = 0;
   virtual void on_reject(int, RejectReason) = 0;
   virtual void on_cancel(int, CancelResult) = 0;
+  virtual void on_amend(int, AmendResult) = 0;
   virtual void on_trade(const Trade&) = 0;
   virtual void on_tob(const TopOfBook&) = 0;
   virtual void on_book(const BookSnapshot&) = 0;
+  // Level changes are only tracked for listeners that ask for them, so this one is optional.
+  // Listeners that override it also override takes_level_updates to return true.
+  virtual void on_level_update(const LevelUpdate&) {}
+  virtual bool takes_level_updates() const { return false; }
 };
 
-  
\ No newline at end of file
+// Compile-time listener that ignores every event, calls to it compile to nothing.
+// It has no on_level_update, so engines using it do not track level changes.
+struct NullListener {
+  void on_ack(int) {}
+  void on_reject(int, RejectReason) {}
+  void on_cancel(int, CancelResult) {}
+  void on_amend(int, AmendResult) {}
+  void on_trade(const Trade&) {}
+  void on_tob(const TopOfBook&) {}
+  void on_book(const BookSnapshot&) {}
+};
+
+// Compile-time listener that forwards every event to listeners registered at runtime.
+// Level changes are only collected once one of them takes level updates.
+struct ListenerList {
+  std::vector<IEventListener*> listeners;
+  bool level_updates = false;
+
+  void add(IEventListener* l) {
+    listeners.push_back(l);
+    level_updates = level_updates || l->takes_level_updates();
+  }
+  bool takes_level_updates() const { return level_updates; }
+
+  void on_ack(int order_id) { for (auto* l : listeners) l->on_ack(order_id); }
+  void on_reject(int order_id, RejectReason rr) { for (auto* l : listeners) l->on_reject(order_id, rr); }
+  void on_cancel(int order_id, CancelResult cr) { for (auto* l : listeners) l->on_cancel(order_id, cr); }
+  void on_amend(int order_id, AmendResult ar) { for (auto* l : listeners) l->on_amend(order_id, ar); }
+  void on_trade(const Trade& trd) { for (auto* l : listeners) l->on_trade(trd); }
+  void on_tob(const TopOfBook& tob) { for (auto* l : listeners) l->on_tob(tob); }
+  void on_book(const BookSnapshot& bs) { for (auto* l : listeners) l->on_book(bs); }
+  void on_level_update(const LevelUpdate& lu) { for (auto* l : listeners) l->on_level_update(lu); }
+};
@@ -0,0 +1,84 @@
+/**
+hot_path_profile.cpp
+--------------
+Implements TSC calibration, per-thread profiles and the breakdown printed at exit
+ */
+
+#include "hot_path_profile.hpp"
+#include <iostream>
+#include <mutex>
+
+namespace {
+
+const char* stage_names[] = {"validate", "match", "rest", "cancel", "amend", "dispatch"};
+
+// Profile of the whole process: threads merge into it as they exit and it is
+// printed to stderr when the process exits, if anything was recorded
+struct ProcessProfile {
+    std::mutex lock;
+    HotPathProfile total;
+
+    ~ProcessProfile() {
+        if (total.command_ticks().empty()) return;
+        total.report(std::cerr, TscClock::ns_per_tick());
+    }
+};
+
+ProcessProfile& process_profile(){
+    static ProcessProfile profile;
+    return profile;
+}
+
+// Constructed on a thread's first profiled command. The process profile is
+// created first, so it outlives every thread's profile (including main's).
+struct ThreadProfile {
+    ProcessProfile& owner;
+    HotPathProfile profile;
+
+    ThreadProfile() : owner(process_profile()) {}
+
+    ~ThreadProfile() {
+        std::lock_guard<std::mutex> guard(owner.lock);
+        owner.total.merge(profile);
+    }
+};
+
+}
+
+double TscClock::ns_per_tick(){
+    static const double value = []{
+        using std::chrono::steady_clock;
+        steady_clock::time_point start = steady_clock::now();
+        std::uint64_t first = now();
+        while (steady_clock::now() - start < std::chrono::milliseconds(20)) {}
+        std::uint64_t last = now();
+        double ns = std::chrono::duration<double, std::nano>(steady_clock::now() - start).count();
+        return last > first ? ns / static_cast<double>(last - first) : 1.0;
+    }();
+    return value;
+}
+
+void HotPathProfile::report(std::ostream& os, double ns_per_tick) const {
+    double all_stages = 0;
+    for (const LatencyHistogram& h : stages) all_stages += h.mean() * h.count();
+
+    os << "=== Hot Path Profile (" << commands.count() << " commands, "
+       << 1 / ns_per_tick << " ticks/ns) ===\n";
+    os << "command: mean " << commands.mean() * ns_per_tick << " ns, p50 "
+       << commands.percentile(50) * ns_per_tick << " ns, p99 "
+       << commands.percentile(99) * ns_per_tick << " ns\n";
+    for (std::size_t i = 0; i < stages.size(); ++i){
+        const LatencyHistogram& h = stages[i];
+        if (h.empty()) continue;
+        os << "stage " << stage_names[i] << ": " << h.count() << " commands, mean "
+           << h.mean() * ns_per_tick << " ns, p50 " << h.percentile(50) * ns_per_tick
+           << " ns, p99 " << h.percentile(99) * ns_per_tick << " ns, p99.9 "
+           << h.percentile(99.9) * ns_per_tick << " ns, max " << h.max() * ns_per_tick << " ns, "
+           << (all_stages > 0 ? 100 * h.mean() * h.count() / all_stages : 0) << "% of stage time\n";
+    }
+}
+
+HotPathProfile& HotPathProfile::local(){
+    thread_local ThreadProfile profile;
+    return profile.profile;
+}
@@ -0,0 +1,118 @@
+/**
+hot_path_profile.hpp
+--------------
+Defines optional cycle-level instrumentation of the matching hot path.
+Building with EXCHANGE_PROFILE defined (cmake -DEXCHANGE_PROFILE=ON) makes
+BasicMatchingEngine timestamp each stage of an order, cancel or amend with the TSC
+and add the per-command stage times to a per-thread HotPathProfile. Profiles
+are merged when their thread exits, and the merged breakdown is written to
+stderr at process exit. Without EXCHANGE_PROFILE the PROFILE_* macros expand
+to nothing and the engine contains no timing code at all.
+ */
+
+#pragma once
+
+#include "latency_histogram.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Stages of a command as seen by the engine
+enum class ProfileStage : std::uint8_t {
+    Validate,   // duplicate id and price/qty checks
+    Match,      // crossing the opposite side and building trades
+    Rest,       // add_limit of the unfilled remainder
+    Cancel,     // removing the order from the book
+    Amend,      // changing a resting order in place or moving it
+    Dispatch,   // listener callbacks: ack, trades, cancels, level updates, BBO
+    Count
+};
+
+// Cheap timestamp counter. Reads the TSC on x86 (no serialising fence, so a
+// stage may be off by a few cycles of reordering) and steady_clock elsewhere.
+struct TscClock {
+    static std::uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // Nanoseconds per tick, measured once against steady_clock over about 20 ms
+    static double ns_per_tick();
+};
+
+// Per-stage tick histograms of one thread's commands. Each command adds one
+// sample to every stage it went through (summed when a stage runs several times).
+class HotPathProfile {
+private:
+    std::array<LatencyHistogram, static_cast<std::size_t>(ProfileStage::Count)> stages;
+    LatencyHistogram commands;
+
+public:
+    void record(ProfileStage stage, std::uint64_t ticks) {
+        stages[static_cast<std::size_t>(stage)].record(ticks);
+    }
+
+    void record_command(std::uint64_t ticks) { commands.record(ticks); }
+
+    const LatencyHistogram& stage(ProfileStage s) const { return stages[static_cast<std::size_t>(s)]; }
+    const LatencyHistogram& command_ticks() const { return commands; }
+
+    void merge(const HotPathProfile& other) {
+        for (std::size_t i = 0; i < stages.size(); ++i) stages[i].merge(other.stages[i]);
+        commands.merge(other.commands);
+    }
+
+    // One line per stage: commands through it, mean/p50/p99/p99.9/max ns and share of all stage time
+    void report(std::ostream& os, double ns_per_tick) const;
+
+    // The calling thread's profile, merged into the process profile when the thread exits
+    static HotPathProfile& local();
+};
+
+// Times consecutive stages of one command: each lap() charges the ticks since
+// the previous lap to a stage, and the destructor records the totals.
+class StageLaps {
+private:
+    std::array<std::uint64_t, static_cast<std::size_t>(ProfileStage::Count)> ticks{};
+    std::uint32_t visited = 0;
+    std::uint64_t start;
+    std::uint64_t last;
+
+public:
+    StageLaps() : start(TscClock::now()), last(start) {}
+
+    StageLaps(const StageLaps&) = delete;
+    StageLaps& operator=(const StageLaps&) = delete;
+
+    void lap(ProfileStage stage) {
+        std::uint64_t t = TscClock::now();
+        ticks[static_cast<std::size_t>(stage)] += t - last;
+        visited |= 1u << static_cast<unsigned>(stage);
+        last = t;
+    }
+
+    ~StageLaps() {
+        HotPathProfile& profile = HotPathProfile::local();
+        for (std::size_t i = 0; i < ticks.size(); ++i){
+            if (visited & (1u << i)) profile.record(static_cast<ProfileStage>(i), ticks[i]);
+        }
+        profile.record_command(last - start);
+    }
+};
+
+#ifdef EXCHANGE_PROFILE
+#define PROFILE_COMMAND() StageLaps profile_laps
+#define PROFILE_LAP(stage) profile_laps.lap(ProfileStage::stage)
+#else
+#define PROFILE_COMMAND() ((void)0)
+#define PROFILE_LAP(stage) ((void)0)
+#endif
@@ -1,9 +1,28 @@
 #include <iostream>
 #include <fstream>
 #include "matching_engine.hpp"
+#include "event_ring.hpp"
 #include "printer_listener.hpp"
 #include "parser.hpp"
+#include "symbol_router.hpp"
+#include "sharded_engine.hpp"
+#include "mapped_file.hpp"
+#include "binary_command.hpp"
+#include "output_buffer.hpp"
+#include "event_journal.hpp"
+#include "pipeline.hpp"
+#include "command_wal.hpp"
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
 
 using std::cin;
 using std::cout;
@@ -15,55 +34,559 @@ using std::ofstream;
 using std::ostream;
 using std::getline;
 using std::string;
+using std::string_view;
 
-void process_commands(istream& input, MatchingEngine& engine, PrinterListener& printer) {
-    string line;
-    while (getline(input, line)) {
-        if (line == "X") break;
-        
-        auto cmd = parse_command(line);
-        switch (cmd.type) {
-            case CommandType::New:
-                engine.process_new_order(cmd.order_id, cmd.side, cmd.price, cmd.qty);
-                break;
-            case CommandType::Reject:
-                printer.on_reject(cmd.order_id, cmd.reject_reason);
-                break;
-            case CommandType::Cancel:
-                engine.cancel_order(cmd.order_id);
-                break;
-            case CommandType::PrintTopOfBook:
-                engine.top_of_book();
-                break;
-            case CommandType::PrintFullBook:
-                engine.print_book();
-                break;
-            case CommandType::Exit:
-                return;
-            default:
-                break;
+// Files are memory-mapped by default, --read=stream reads them like stdin
+enum class InputMode {
+    Mapped,
+    Stream
+};
+
+// Events go to the printer synchronously, or through an event ring drained in batches
+enum class EventOutput {
+    Direct,
+    Ring
+};
+
+// Events are printed as text lines, or written as a binary event journal
+enum class OutputFormat {
+    Text,
+    Journal
+};
+
+// Upper bound of --shards, each shard is a worker thread
+constexpr std::size_t max_shards = 1024;
+
+struct Options {
+    BookConfig config;
+    EventOutput events = EventOutput::Direct;
+    OutputFormat format = OutputFormat::Text;
+    std::size_t shards = 0;        // 0 = run every symbol on the main thread
+    bool pin_threads = false;
+    InputMode input = InputMode::Mapped;
+    bool timing = false;
+    bool flush_on_query = false;
+    bool bbo_feed = false;         // print the top of book whenever it changes
+    bool pipeline = false;         // read, match and output on separate threads
+    const char* snapshot_path = nullptr;   // books are saved here after the input is processed
+    const char* restore_path = nullptr;    // books are restored from here before it
+    const char* wal_path = nullptr;        // write-ahead journal of commands, replayed on startup
+    WalSync wal_sync = WalSync::Group;
+    std::size_t wal_group = 256;
+    const char* input_path = nullptr;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Startup-to-first-event time and replay throughput, reported on stderr by --timing
+struct RunTiming {
+    Clock::time_point start = Clock::now();
+    Clock::time_point first_command;
+    std::size_t lines = 0;
+    std::size_t bytes = 0;
+
+    void count(std::size_t input_bytes) {
+        if (lines++ == 0) first_command = Clock::now();
+        bytes += input_bytes;
+    }
+
+    void report(const char* mode) const {
+        auto end = Clock::now();
+        double total = std::chrono::duration<double>(end - start).count();
+        double first = lines ? std::chrono::duration<double, std::micro>(first_command - start).count() : 0;
+        cerr << "input: " << mode << "\n"
+             << "startup to first event: " << first << " us\n"
+             << "commands: " << lines << " in " << total << " s ("
+             << lines / total << " commands/sec, " << bytes / total / (1 << 20) << " MB/s)" << endl;
+    }
+};
+
+// Output lines of a symbol's events start with the symbol, default symbol lines are unchanged
+string line_prefix(Symbol symbol) {
+    return symbol == default_symbol ? "" : symbol_name(symbol) + " ";
+}
+
+// Creates the engine of one book, configured by the options
+template <typename Engine, typename Listener>
+std::unique_ptr<Engine> make_engine(const Options& options, Listener listener) {
+    auto engine = std::make_unique<Engine>(options.config, std::move(listener));
+    engine->set_bbo_feed(options.bbo_feed);
+    return engine;
+}
+
+// Commands parsed from the lines of a text LineReader, up to an "X" line
+template <typename LineReader>
+struct TextCommands {
+    LineReader& lines;
+    std::size_t last_size = 0;
+
+    bool next(Command& cmd) {
+        string_view line;
+        if (!lines.next(line) || line == "X") return false;
+        cmd = parse_command_view(line);
+        last_size = line.size() + 1;
+        return true;
+    }
+};
+
+// Commands decoded from binary records
+struct BinaryCommands {
+    BinaryCommandReader records;
+    std::size_t last_size = binary_record_size;
+
+    bool next(Command& cmd) { return records.next(cmd); }
+};
+
+// Command source of the pipeline's reader thread, counting input for --timing there
+template <typename Commands>
+struct PipelineSource {
+    Commands& input;
+    RunTiming& timing;
+
+    bool next(Command& cmd) {
+        if (!input.next(cmd)) return false;
+        timing.count(input.last_size);
+        return true;
+    }
+};
+
+// Router wrapper that logs each command to the write-ahead journal before running it.
+// Stops processing (like Exit) once the journal cannot be written.
+template <typename Router>
+struct LoggedRouter {
+    Router& router;
+    CommandWal* wal;
+
+    bool process_command(const Command& cmd) {
+        if (wal && cmd.type != CommandType::Exit && !wal->append(cmd)) return false;
+        return router.process_command(cmd);
+    }
+};
+
+// Runs every command of input, after_command is called once per processed command
+template <typename Commands, typename Engine, typename AfterCommand>
+void process_commands(Commands& input, Engine& engine, RunTiming& timing, AfterCommand after_command) {
+    Command cmd;
+    while (input.next(cmd)) {
+        if (!engine.process_command(cmd)) return;
+        timing.count(input.last_size);
+        after_command();
+    }
+}
+
+// Shard mode: symbols are split across worker threads, each writing into its own buffer.
+// Buffers are written whole, so lines of one symbol stay in order but symbols interleave.
+template <typename Commands>
+void run_sharded(Commands& input, const Options& options, RunTiming& timing) {
+    std::mutex output_mutex;
+    std::vector<std::unique_ptr<OutputBuffer>> outputs;
+    for (std::size_t shard = 0; shard < options.shards; ++shard){
+        outputs.push_back(std::make_unique<OutputBuffer>(STDOUT_FILENO, 1 << 16, &output_mutex));
+    }
+
+    using Engine = BasicMatchingEngine<PrinterListener>;
+    ShardedEngine<Engine> sharded(options.shards,
+        [&](std::size_t shard, Symbol symbol){
+            return make_engine<Engine>(options,
+                PrinterListener(*outputs[shard], line_prefix(symbol), options.flush_on_query));
+        },
+        {}, 1 << 14, options.pin_threads);
+
+    Command cmd;
+    while (input.next(cmd)) {
+        if (cmd.type == CommandType::Exit) break;
+        sharded.submit(cmd);
+        timing.count(input.last_size);
+    }
+    sharded.finish();
+    for (auto& output : outputs) output->flush();
+}
+
+// Snapshot file: snapshot_magic, u32 book count, then per book its u64 symbol and engine snapshot
+template <typename Router>
+bool save_snapshot(Router& router, const char* path) {
+    SnapshotWriter out;
+    out.put_bytes(snapshot_magic);
+    out.put_u32(static_cast<std::uint32_t>(router.size()));
+    router.for_each([&](Symbol symbol, const auto& engine){
+        out.put_u64(symbol);
+        engine.save_snapshot(out);
+    });
+
+    std::FILE* file = std::fopen(path, "wb");
+    if (!file) return false;
+    bool written = std::fwrite(out.bytes().data(), 1, out.size(), file) == out.size();
+    // synced, since a write-ahead journal is emptied once the snapshot is saved
+    written = written && std::fflush(file) == 0 && ::fsync(fileno(file)) == 0;
+    return std::fclose(file) == 0 && written;
+}
+
+// Creates and restores every book of a snapshot file before any command runs
+template <typename Router>
+bool restore_snapshot(Router& router, const char* path) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+    SnapshotReader in(file.contents());
+    if (!in.expect(snapshot_magic)) return false;
+    std::uint32_t books = in.get_u32();
+    for (std::uint32_t i = 0; i < books && !in.failed(); ++i){
+        Symbol symbol = in.get_u64();
+        if (!router.engine_for(symbol).load_snapshot(in)) return false;
+    }
+    return !in.failed() && in.remaining() == 0;
+}
+
+// Rebuilds books from the snapshot and the commands of the write-ahead journal, replayed
+// with their events discarded (they were printed by the run that logged them)
+template <typename Router>
+bool recover_journal(Router& router, const Options& options) {
+    using QuietEngine = BasicMatchingEngine<NullListener>;
+    SymbolRouter<QuietEngine> quiet([&](Symbol){
+        return std::make_unique<QuietEngine>(options.config, NullListener{});
+    });
+    if (options.restore_path && !restore_snapshot(quiet, options.restore_path)){
+        cerr << "Could not restore snapshot " << options.restore_path << endl;
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(options.wal_path)) return false;
+    BinaryCommandReader records(file.contents());
+    Command cmd;
+    while (records.next(cmd)) quiet.process_command(cmd);
+
+    bool ok = true;
+    quiet.for_each([&](Symbol symbol, const QuietEngine& engine){
+        SnapshotWriter out;
+        engine.save_snapshot(out);
+        SnapshotReader in(out.bytes());
+        ok = router.engine_for(symbol).load_snapshot(in) && ok;
+    });
+    return ok;
+}
+
+// Restores books before processing and saves them afterwards, as the options ask.
+// With a journal, its commands are replayed on top of the restored books, and it is
+// emptied once a snapshot covering them has been written.
+// Returns false (after reporting on stderr) if restoring or saving fails.
+template <typename Router, typename Process>
+bool with_snapshots(Router& router, const Options& options, CommandWal* wal, Process process) {
+    if (wal){
+        if (!recover_journal(router, options)){
+            cerr << "Could not recover from journal " << options.wal_path << endl;
+            return false;
         }
     }
+    else if (options.restore_path && !restore_snapshot(router, options.restore_path)){
+        cerr << "Could not restore snapshot " << options.restore_path << endl;
+        return false;
+    }
+    process();
+    if (wal && !wal->commit()){
+        cerr << "Could not write journal " << options.wal_path << endl;
+        return false;
+    }
+    if (options.snapshot_path && !save_snapshot(router, options.snapshot_path)){
+        cerr << "Could not write snapshot " << options.snapshot_path << endl;
+        return false;
+    }
+    if (wal && options.snapshot_path && !wal->reset()){
+        cerr << "Could not reset journal " << options.wal_path << endl;
+        return false;
+    }
+    return true;
+}
+
+// Direct mode: each book's engine calls its listener synchronously
+template <typename Listener, typename Commands, typename MakeListener>
+bool run_direct(Commands& input, const Options& options, RunTiming& timing, OutputBuffer& output,
+                CommandWal* wal, bool interactive, MakeListener make_listener) {
+    using Engine = BasicMatchingEngine<Listener>;
+    SymbolRouter<Engine> router([&](Symbol symbol){
+        return make_engine<Engine>(options, make_listener(symbol));
+    });
+    LoggedRouter<SymbolRouter<Engine>> logged{router, wal};
+    return with_snapshots(router, options, wal, [&]{
+        process_commands(input, logged, timing, [&]{
+            if (interactive) output.flush();
+        });
+    });
+}
+
+// Interactive input flushes output after every line, files only when the buffer fills
+// (or on P/B with --flush-on-query)
+template <typename Commands>
+bool run(Commands& input, const Options& options, RunTiming& timing, bool interactive) {
+    if (options.shards > 0){
+        run_sharded(input, options, timing);
+        return true;
+    }
+
+    // declared before output, whose final flush commits the journal
+    std::unique_ptr<CommandWal> wal;
+    if (options.wal_path){
+        wal = std::make_unique<CommandWal>(options.wal_sync, options.wal_group);
+        if (!wal->open(options.wal_path)){
+            cerr << "Could not open journal " << options.wal_path << endl;
+            return false;
+        }
+    }
+
+    OutputBuffer output(STDOUT_FILENO);
+    // output is only written once the commands behind it are in the journal
+    // (a failed commit drops the output, and the journal stops the run at the next command)
+    if (wal) output.set_before_write([&]{ return wal->commit(); });
+    std::unique_ptr<EventJournal> journal;
+    if (options.format == OutputFormat::Journal) journal = std::make_unique<EventJournal>(output);
+
+    if (options.events == EventOutput::Direct && !options.pipeline){
+        if (journal){
+            return run_direct<JournalListener>(input, options, timing, output, wal.get(), interactive, [&](Symbol symbol){
+                return JournalListener(*journal, symbol);
+            });
+        }
+        return run_direct<PrinterListener>(input, options, timing, output, wal.get(), interactive, [&](Symbol symbol){
+            return PrinterListener(output, line_prefix(symbol), options.flush_on_query);
+        });
+    }
+
+    // ring and pipeline modes: engines only append records, tagged with their book index,
+    // and the printers (or journal writers) format them when the ring is drained
+    EventRing ring(1 << 16);
+    std::vector<std::unique_ptr<IEventListener>> listeners;
+    // books are added while the pipeline's output thread reads targets, whose entries never move
+    EventTargets targets;
+    auto add_target = [&](Symbol symbol){
+        if (journal) listeners.push_back(std::make_unique<JournalListener>(*journal, symbol));
+        else listeners.push_back(std::make_unique<PrinterListener>(output, line_prefix(symbol), options.flush_on_query));
+        if (!targets.push_back(listeners.back().get())){
+            cerr << "Too many symbols for ring output (at most " << EventTargets::max_books << ")" << endl;
+            std::exit(1);
+        }
+        return static_cast<std::uint32_t>(targets.size() - 1);
+    };
+    using Engine = BasicMatchingEngine<EventRingWriter>;
+
+    if (options.pipeline){
+        CommandPipeline pipeline(ring, targets);
+        SymbolRouter<Engine> router([&](Symbol symbol){
+            EventRingWriter writer{&ring, [&]{ pipeline.wait_for_output(); }, add_target(symbol)};
+            return make_engine<Engine>(options, writer);
+        });
+        PipelineSource<Commands> source{input, timing};
+        bool ok = with_snapshots(router, options, nullptr, [&]{
+            pipeline.run(source, router, [&]{
+                if (interactive) output.flush();
+            });
+        });
+        if (options.timing) pipeline.report(cerr);
+        return ok;
+    }
+
+    EventReplayer replayer;
+    auto drain = [&]{ replayer.drain(ring, targets); };
+    SymbolRouter<Engine> router([&](Symbol symbol){
+        EventRingWriter writer{&ring, drain, add_target(symbol)};
+        return make_engine<Engine>(options, writer);
+    });
+    LoggedRouter<SymbolRouter<Engine>> logged{router, wal.get()};
+    return with_snapshots(router, options, wal.get(), [&]{
+        process_commands(input, logged, timing, [&]{
+            if (interactive){
+                drain();
+                output.flush();
+            }
+        });
+        drain();
+    });
+}
+
+void print_usage(const char* program) {
+    cerr << "Usage: " << program << " [--book=map|ladder] [--order-capacity=N] [--order-id-capacity=N]"
+         << " [--events=direct|ring] [--shards=N [--pin-threads]] [--read=mmap|stream] [--timing]"
+         << " [--flush-on-query] [--bbo] [--output=text|journal] [--pipeline]"
+         << " [--snapshot=FILE] [--restore=FILE]"
+         << " [--wal=FILE [--wal-sync=none|group|always] [--wal-group=N]]"
+         << " [input_file]" << endl;
+}
+
+// Parses the N of a --option=N argument into out, returning false unless it is
+// a plain decimal number from min to max
+bool parse_count(string_view text, std::size_t min, std::size_t max, std::size_t& out) {
+    std::size_t value = 0;
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr != end || value < min || value > max) return false;
+    out = value;
+    return true;
 }
 
 int main(int argc, char* argv[]){
-    MatchingEngine engine;
-    PrinterListener printer;
-    engine.add_listener(&printer);
+    RunTiming timing;
+    Options options;
 
-    if (argc > 1){
-        ifstream input_file(argv[1]);
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if (arg == "--book=map"){
+            options.config.backend = BookBackend::Map;
+        }
+        else if (arg == "--book=ladder"){
+            options.config.backend = BookBackend::Ladder;
+        }
+        else if (arg.rfind("--order-capacity=", 0) == 0){
+            // pool handles are 32-bit, with one value kept as the null handle
+            if (!parse_count(string_view(arg).substr(17), 0, null_order, options.config.order_capacity)){
+                cerr << "Invalid order capacity " << arg.substr(17) << endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg.rfind("--order-id-capacity=", 0) == 0){
+            // order ids are 32-bit, so there are never more distinct ones than that
+            if (!parse_count(string_view(arg).substr(20), 0, std::size_t{1} << 32, options.config.order_id_capacity)){
+                cerr << "Invalid order id capacity " << arg.substr(20) << endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--events=direct"){
+            options.events = EventOutput::Direct;
+        }
+        else if (arg == "--events=ring"){
+            options.events = EventOutput::Ring;
+        }
+        else if (arg.rfind("--shards=", 0) == 0){
+            if (!parse_count(string_view(arg).substr(9), 0, max_shards, options.shards)){
+                cerr << "Invalid shard count " << arg.substr(9) << endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--pin-threads"){
+            options.pin_threads = true;
+        }
+        else if (arg == "--read=mmap"){
+            options.input = InputMode::Mapped;
+        }
+        else if (arg == "--read=stream"){
+            options.input = InputMode::Stream;
+        }
+        else if (arg == "--timing"){
+            options.timing = true;
+        }
+        else if (arg == "--flush-on-query"){
+            options.flush_on_query = true;
+        }
+        else if (arg == "--bbo"){
+            options.bbo_feed = true;
+        }
+        else if (arg == "--pipeline"){
+            options.pipeline = true;
+        }
+        else if (arg.rfind("--snapshot=", 0) == 0){
+            options.snapshot_path = argv[i] + 11;
+        }
+        else if (arg.rfind("--restore=", 0) == 0){
+            options.restore_path = argv[i] + 10;
+        }
+        else if (arg.rfind("--wal=", 0) == 0){
+            options.wal_path = argv[i] + 6;
+        }
+        else if (arg == "--wal-sync=none"){
+            options.wal_sync = WalSync::None;
+        }
+        else if (arg == "--wal-sync=group"){
+            options.wal_sync = WalSync::Group;
+        }
+        else if (arg == "--wal-sync=always"){
+            options.wal_sync = WalSync::Always;
+        }
+        else if (arg.rfind("--wal-group=", 0) == 0){
+            if (!parse_count(string_view(arg).substr(12), 1, SIZE_MAX, options.wal_group)){
+                cerr << "Invalid journal group size " << arg.substr(12) << endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--output=text"){
+            options.format = OutputFormat::Text;
+        }
+        else if (arg == "--output=journal"){
+            options.format = OutputFormat::Journal;
+        }
+        else if (arg.rfind("--", 0) == 0){
+            cerr << "Unknown option " << arg << endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+        else {
+            options.input_path = argv[i];
+        }
+    }
+
+    // shard buffers are written in independent chunks, which a single journal cannot interleave
+    if (options.format == OutputFormat::Journal && options.shards > 0){
+        cerr << "--output=journal cannot be combined with --shards" << endl;
+        return 1;
+    }
+
+    if (options.pipeline && options.shards > 0){
+        cerr << "--pipeline cannot be combined with --shards" << endl;
+        return 1;
+    }
+    // shard engines live on their worker threads
+    if ((options.snapshot_path || options.restore_path) && options.shards > 0){
+        cerr << "--snapshot and --restore cannot be combined with --shards" << endl;
+        return 1;
+    }
+
+    // the journal is written by the thread that runs the engines, before their output
+    if (options.wal_path && (options.shards > 0 || options.pipeline)){
+        cerr << "--wal cannot be combined with --shards or --pipeline" << endl;
+        return 1;
+    }
+
+    const char* mode = "stdin";
+    bool ok = true;
+    // only regular files can be mapped, anything else (e.g. a pipe) is read as a stream
+    if (options.input_path && options.input == InputMode::Mapped && is_regular_file(options.input_path)){
+        MappedFile file;
+        if (!file.open(options.input_path)){
+            cerr << "Could not open input file " << options.input_path << endl;
+            return 1;
+        }
+        // process commands straight from the mapping
+        if (is_binary_commands(file.contents())){
+            BinaryCommands commands{BinaryCommandReader(file.contents())};
+            ok = run(commands, options, timing, false);
+            mode = "mmap, binary";
+        }
+        else {
+            MappedLineReader reader(file.contents());
+            TextCommands<MappedLineReader> commands{reader};
+            ok = run(commands, options, timing, false);
+            mode = "mmap";
+        }
+    }
+    else if (options.input_path){
+        ifstream input_file(options.input_path);
         if (!input_file.is_open()){
-            cerr << "Could not open input file " << argv[1] << endl;
+            cerr << "Could not open input file " << options.input_path << endl;
             return 1;
         }
         // process commands from file
-        process_commands(input_file, engine, printer);
+        StreamLineReader reader(input_file);
+        TextCommands<StreamLineReader> commands{reader};
+        ok = run(commands, options, timing, false);
         input_file.close();
+        mode = "stream";
     }
     else {
         // read line by line from stdin
-        process_commands(cin, engine, printer);
+        StreamLineReader reader(cin);
+        TextCommands<StreamLineReader> commands{reader};
+        ok = run(commands, options, timing, true);
     }
-    return 0;  
+    if (options.timing) timing.report(mode);
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,56 @@
+/**
+mapped_file.cpp
+--------------
+Implements read-only memory mapping of input files
+ */
+
+#include "mapped_file.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+bool MappedFile::open(const char* path){
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        ::close(fd);
+        return false;
+    }
+
+    // an empty file cannot be mapped but is a valid, empty input
+    length = static_cast<std::size_t>(st.st_size);
+    if (length == 0){
+        ::close(fd);
+        return true;
+    }
+
+    void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file referenced after the descriptor is closed
+    ::close(fd);
+    if (p == MAP_FAILED){
+        length = 0;
+        return false;
+    }
+    madvise(p, length, MADV_SEQUENTIAL);
+    mapping = static_cast<const char*>(p);
+    return true;
+}
+
+bool is_regular_file(const char* path){
+    struct stat st;
+    return ::stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+void MappedFile::close(){
+    if (mapping) munmap(const_cast<char*>(mapping), length);
+    mapping = nullptr;
+    length = 0;
+}
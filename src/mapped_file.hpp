@@ -0,0 +1,80 @@
+/**
+mapped_file.hpp
+--------------
+Defines line sources for command input.
+MappedFile maps a whole input file read-only (with sequential access hints),
+MappedLineReader yields its lines as views straight from the mapping, and
+StreamLineReader yields the lines of a stream (e.g. stdin) through getline.
+Both readers split lines exactly the way getline does.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+
+class MappedFile {
+private:
+    const char* mapping = nullptr;
+    std::size_t length = 0;
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps path read-only, returns false if it cannot be opened or mapped
+    bool open(const char* path);
+
+    void close();
+
+    std::string_view contents() const { return std::string_view(mapping, length); }
+    std::size_t size() const { return length; }
+};
+
+// Returns whether path names a regular file, the only kind of input MappedFile can map
+// (pipes, FIFOs and terminals have to be read as streams)
+bool is_regular_file(const char* path);
+
+// Lines of a buffer, each view points into the buffer
+class MappedLineReader {
+private:
+    std::string_view rest;
+
+public:
+    explicit MappedLineReader(std::string_view buffer) : rest(buffer) {}
+
+    bool next(std::string_view& line) {
+        if (rest.empty()) return false;
+        std::size_t end = rest.find('\n');
+        if (end == std::string_view::npos){
+            line = rest;
+            rest = std::string_view();
+        }
+        else {
+            line = rest.substr(0, end);
+            rest.remove_prefix(end + 1);
+        }
+        return true;
+    }
+};
+
+// Lines of a stream, each view is valid until the next call
+class StreamLineReader {
+private:
+    std::istream& input;
+    std::string buffer;
+
+public:
+    explicit StreamLineReader(std::istream& in) : input(in) {}
+
+    bool next(std::string_view& line) {
+        if (!std::getline(input, buffer)) return false;
+        line = buffer;
+        return true;
+    }
+};
@@ -6,85 +6,378 @@ and ability to add limit orders
  */
 
 #include "order_book.hpp"
-#include <iterator>
+#include <algorithm>
+#include <climits>
 
 using std::vector;
 
+// BookSide constructor, the ladder is allocated up front so the hot path never resizes it
+// unless prices drift outside of the configured range
+BookSide::BookSide(Side s, const BookConfig& config)
+    : side(s), backend(config.backend) {
+    if (backend == BookBackend::Ladder){
+        int ticks = config.ladder_ticks > 64 ? config.ladder_ticks : 64;
+        max_ticks = config.ladder_max_ticks > ticks ? config.ladder_max_ticks : ticks;
+        ladder.resize(ticks);
+        occupied.assign((ticks + 63) / 64, 0);
+        // an unset base leaves every price out of range, so the first order centres the ladder
+        base_price = config.ladder_base_price != 0 ? config.ladder_base_price : unset_base_price;
+    }
+}
+
+// BookSide query function that returns whether there are no price levels
+bool BookSide::empty() const {
+    return levels.empty() && ladder_levels == 0;
+}
+
+// BookSide query function that returns the number of price levels
+std::size_t BookSide::level_count() const {
+    return levels.size() + ladder_levels;
+}
+
+// BookSide query function that returns the best price (side must not be empty)
+int BookSide::best_price() const {
+    if (backend == BookBackend::Map || overflow_best()){
+        return side == Side::Buy ? levels.rbegin()->first : levels.begin()->first;
+    }
+    return static_cast<int>(base_price + best_index);
+}
+
+// BookSide query function that returns the best level (side must not be empty)
+Level& BookSide::best_level() {
+    if (backend == BookBackend::Map || overflow_best()){
+        return side == Side::Buy ? levels.rbegin()->second : levels.begin()->second;
+    }
+    return ladder[best_index];
+}
+
+const Level& BookSide::best_level() const {
+    if (backend == BookBackend::Map || overflow_best()){
+        return side == Side::Buy ? levels.rbegin()->second : levels.begin()->second;
+    }
+    return ladder[best_index];
+}
+
+// BookSide function that returns the level at price, or nullptr if there is none
+Level* BookSide::find(int price) {
+    if (backend == BookBackend::Map){
+        auto it = levels.find(price);
+        return it == levels.end() ? nullptr : &it->second;
+    }
+    if (!in_ladder(price)){
+        auto it = levels.find(price);
+        return it == levels.end() ? nullptr : &it->second;
+    }
+    int index = static_cast<int>(price - base_price);
+    if (!(occupied[index >> 6] & (std::uint64_t{1} << (index & 63)))) return nullptr;
+    return &ladder[index];
+}
+
+// BookSide function that returns the level at price, creating an empty one if needed
+Level& BookSide::find_or_create(int price) {
+    if (backend == BookBackend::Map){
+        return levels[price];
+    }
+    // a price the ladder cannot reach without growing past max_ticks goes to the map
+    if (!in_ladder(price) && !recentre(price)) return levels[price];
+
+    int index = static_cast<int>(price - base_price);
+    if (!(occupied[index >> 6] & (std::uint64_t{1} << (index & 63)))) occupy(index);
+    return ladder[index];
+}
+
+// BookSide function that marks an empty ladder index as a level, moving the touch if it is better
+void BookSide::occupy(int index) {
+    mark_occupied(index);
+    ++ladder_levels;
+    if (best_index < 0
+        || (side == Side::Buy && index > best_index)
+        || (side == Side::Sell && index < best_index)){
+        best_index = index;
+    }
+}
+
+// BookSide query function that returns whether the best level is in the overflow map
+// rather than the ladder (ladder backend, side must not be empty)
+bool BookSide::overflow_best() const {
+    if (levels.empty()) return false;
+    if (best_index < 0) return true;
+    std::int64_t ladder_best = base_price + best_index;
+    return side == Side::Buy ? levels.rbegin()->first > ladder_best : levels.begin()->first < ladder_best;
+}
+
+// BookSide function that removes an empty level at price
+void BookSide::remove(int price) {
+    if (backend == BookBackend::Map){
+        levels.erase(price);
+        return;
+    }
+    if (!in_ladder(price)){
+        levels.erase(price);
+        return;
+    }
+    int index = static_cast<int>(price - base_price);
+    clear_occupied(index);
+    --ladder_levels;
+    if (index != best_index) return;
+
+    // walk away from the touch to the next populated level
+    best_index = side == Side::Buy ? prev_occupied(index - 1) : next_occupied(index + 1);
+}
+
+bool BookSide::in_ladder(int price) const {
+    std::int64_t offset = static_cast<std::int64_t>(price) - base_price;
+    return offset >= 0 && offset < static_cast<std::int64_t>(ladder.size());
+}
+
+void BookSide::mark_occupied(int index) {
+    occupied[index >> 6] |= std::uint64_t{1} << (index & 63);
+}
+
+void BookSide::clear_occupied(int index) {
+    occupied[index >> 6] &= ~(std::uint64_t{1} << (index & 63));
+}
+
+int BookSide::next_occupied(int from) const {
+    int size = static_cast<int>(ladder.size());
+    if (from < 0) from = 0;
+    if (from >= size) return -1;
+
+    std::size_t word = from >> 6;
+    std::uint64_t bits = occupied[word] & (~std::uint64_t{0} << (from & 63));
+    while (true){
+        if (bits) return static_cast<int>(word * 64 + __builtin_ctzll(bits));
+        if (++word == occupied.size()) return -1;
+        bits = occupied[word];
+    }
+}
+
+int BookSide::prev_occupied(int from) const {
+    if (from < 0) return -1;
+    int size = static_cast<int>(ladder.size());
+    if (from >= size) from = size - 1;
+
+    std::size_t word = from >> 6;
+    int shift = 63 - (from & 63);
+    std::uint64_t bits = occupied[word] & (~std::uint64_t{0} >> shift);
+    while (true){
+        if (bits) return static_cast<int>(word * 64 + 63 - __builtin_clzll(bits));
+        if (word == 0) return -1;
+        bits = occupied[--word];
+    }
+}
+
+// BookSide function that moves the ladder so that price is covered.
+// The window is recentred over the populated levels plus the new price,
+// and doubled in size whenever that span no longer fits in half of it.
+// Returns false, leaving the ladder as it is, if that would take more than max_ticks;
+// otherwise overflow map levels that now fall in the window move into the ladder.
+bool BookSide::recentre(int price) {
+    std::int64_t ticks = static_cast<std::int64_t>(ladder.size());
+
+    if (ladder_levels == 0){
+        base_price = static_cast<std::int64_t>(price) - ticks / 2;
+    } else {
+        std::int64_t low = base_price + next_occupied(0);
+        std::int64_t high = base_price + prev_occupied(static_cast<int>(ticks) - 1);
+        if (price < low) low = price;
+        if (price > high) high = price;
+        std::int64_t span = high - low + 1;
+
+        std::int64_t new_ticks = ticks;
+        while (span > new_ticks / 2 && new_ticks < max_ticks) new_ticks *= 2;
+        if (new_ticks > max_ticks) new_ticks = max_ticks;
+        if (span > new_ticks) return false;
+        std::int64_t new_base = low - (new_ticks - span) / 2;
+
+        std::vector<Level> new_ladder(new_ticks);
+        std::vector<std::uint64_t> new_occupied((new_ticks + 63) / 64, 0);
+        for (int i = next_occupied(0); i >= 0; i = next_occupied(i + 1)){
+            std::int64_t new_index = base_price + i - new_base;
+            new_ladder[new_index] = std::move(ladder[i]);
+            new_occupied[new_index >> 6] |= std::uint64_t{1} << (new_index & 63);
+        }
+        best_index = static_cast<int>(base_price + best_index - new_base);
+        base_price = new_base;
+        ladder.swap(new_ladder);
+        occupied.swap(new_occupied);
+    }
+
+    // keep the map to prices outside the window
+    auto first = levels.lower_bound(static_cast<int>(std::max<std::int64_t>(base_price, INT_MIN)));
+    auto last = first;
+    for (; last != levels.end() && in_ladder(last->first); ++last){
+        int index = static_cast<int>(last->first - base_price);
+        ladder[index] = std::move(last->second);
+        occupy(index);
+    }
+    levels.erase(first, last);
+    return true;
+}
+
+// OrderPool function that takes a node from the free list, or grows the slab when it is empty
+OrderHandle OrderPool::allocate(Order o) {
+    OrderHandle h;
+    if (free_head != null_order){
+        h = free_head;
+        free_head = nodes[h].next;
+        nodes[h] = OrderNode{o, null_order, null_order};
+    }
+    else {
+        h = static_cast<OrderHandle>(nodes.size());
+        nodes.push_back(OrderNode{o, null_order, null_order});
+    }
+    if (++live > high_water) high_water = live;
+    return h;
+}
+
+// OrderPool function that returns a node to the free list
+void OrderPool::release(OrderHandle h) {
+    nodes[h].next = free_head;
+    free_head = h;
+    --live;
+}
+
+// OrderPool function that appends a new order to the back of a level's queue
+OrderHandle OrderPool::push_back(Level& level, Order o) {
+    OrderHandle h = allocate(o);
+    nodes[h].prev = level.tail;
+    if (level.tail != null_order) nodes[level.tail].next = h;
+    else level.head = h;
+    level.tail = h;
+    level.total_qty += o.qty_remaining;
+    return h;
+}
+
+// OrderPool function that removes an order from anywhere in a level's queue and frees it
+void OrderPool::unlink(Level& level, OrderHandle h) {
+    OrderNode& node = nodes[h];
+    level.total_qty -= node.order.qty_remaining;
+    if (node.prev != null_order) nodes[node.prev].next = node.next;
+    else level.head = node.next;
+    if (node.next != null_order) nodes[node.next].prev = node.prev;
+    else level.tail = node.prev;
+    release(h);
+}
+
+// OrderPool function that splices a level's whole queue onto the free list
+void OrderPool::release_queue(Level& level, std::size_t count) {
+    if (level.empty()) return;
+    nodes[level.tail].next = free_head;
+    free_head = level.head;
+    live -= count;
+    level = Level{};
+}
+
+OrderPoolStats OrderPool::stats() const {
+    return OrderPoolStats{live, high_water, nodes.capacity()};
+}
+
+OrderBook::OrderBook(const BookConfig& config)
+    : asks(Side::Sell, config), bids(Side::Buy, config), orders(config.order_id_capacity) {
+    pool.reserve(config.order_capacity);
+}
+
+// OrderBook function that reloads the cached touch of one side from its best level
+void OrderBook::refresh_touch(Side side) {
+    const BookSide& book_side = side == Side::Buy ? bids : asks;
+    std::optional<PriceLevel>& best = touch_of(side);
+    if (book_side.empty()) best.reset();
+    else best = PriceLevel{book_side.best_price(), book_side.best_level().total_qty};
+}
+
 // OrderBook query function that returns whether there is a best ask
 bool OrderBook::has_best_ask() const {
-    return !asks.empty();
+    return touch.best_ask.has_value();
 }
 
 // OrderBook query function that returns whether there is a best bid
 bool OrderBook::has_best_bid() const {
-    return !bids.empty();
+    return touch.best_bid.has_value();
 }
 
 // Orderbook query function that returns the best bid price
 int OrderBook::best_bid_price() const {
-    return bids.begin()->first;
+    return touch.best_bid->price;
 }
 
 // Orderbook query function that returns the best ask price
 int OrderBook::best_ask_price() const {
-    return asks.begin()->first;
+    return touch.best_ask->price;
 }
 
 // Orderbook query function that returns the best bid quantity
 int OrderBook::best_bid_quantity() const {
-    return bids.begin()->second.total_qty;
+    return touch.best_bid->qty;
 }
 
 // Orderbook query function that returns the best ask quantity
 int OrderBook::best_ask_quantity() const {
-    return asks.begin()->second.total_qty;
+    return touch.best_ask->qty;
 }
 
 // Orderbook query function that returns the earliest best ask
 const Order& OrderBook::best_ask_front() const {
-    return asks.begin()->second.orders.front();
+    return pool[asks.best_level().head].order;
 }
 
 // Orderbook query function that returns the earliest best bid
 const Order& OrderBook::best_bid_front() const {
-    return bids.begin()->second.orders.front();
+    return pool[bids.best_level().head].order;
 }
 
 // Orderbook query function that returns whether an order_id can be added
 bool OrderBook::has_order(int id) const {
-    return seen_ids.count(id);
+    return orders.find(id) != nullptr;
 }
 
-// Orderbook function to "execute" a specified qty of the best ask
-// returns list of orders filled/partially filled
-vector<Fill> OrderBook::consume_best_ask(int qty){
-    vector<Fill> fills;
-    if (!has_best_ask()) return fills;
-    auto asks_it = asks.begin();
-    auto order_it = asks_it->second.orders.begin();
+// Orderbook function to size the order id index for capacity distinct ids
+void OrderBook::reserve_order_ids(std::size_t capacity) {
+    orders.reserve(capacity);
+}
+
+// Orderbook function to "execute" a specified qty of the best level of one side
+// appends orders filled/partially filled to fills
+void OrderBook::consume_best(BookSide& book_side, int qty, vector<Fill>& fills, vector<LevelUpdate>* updates){
+    if (book_side.empty()) return;
+    int price = book_side.best_price();
+    Level& level = book_side.best_level();
+    Side side = &book_side == &bids ? Side::Buy : Side::Sell;
+
+    // while there is still qty to consume and there are orders at the best price
+    while (qty > 0 && !level.empty()){
+        OrderHandle h = level.head;
+        Order& resting = pool[h].order;
 
-    // while there is still qty to consume and there are orders at the best ask price
-    while (qty > 0 && order_it != asks_it->second.orders.end()){
-        
         // if qty >= qty of the first order
-        if (qty >= order_it->qty_remaining){
-            fills.push_back(Fill{order_it->order_id, order_it-> qty_remaining});
-            qty -= order_it->qty_remaining;
-            asks_it->second.total_qty -= order_it->qty_remaining;
-            live_orders.erase(order_it->order_id);
-            order_it = asks_it->second.orders.erase(order_it);
-            if (asks_it->second.orders.empty()){
-                asks.erase(asks_it);
-                break;
+        if (qty >= resting.qty_remaining){
+            fills.push_back(Fill{resting.order_id, resting.qty_remaining});
+            qty -= resting.qty_remaining;
+            orders.find(resting.order_id)->live = false;
+            pool.unlink(level, h);
+            if (level.empty()){
+                book_side.remove(price);
+                refresh_touch(side);
+                if (updates) updates->push_back(LevelUpdate{side, price, 0});
+                return;
             }
         }
         else {
-            fills.push_back(Fill{order_it->order_id, qty});
-            order_it->qty_remaining -= qty;
-            asks_it->second.total_qty -= qty;
+            fills.push_back(Fill{resting.order_id, qty});
+            resting.qty_remaining -= qty;
+            level.total_qty -= qty;
             qty = 0;
         }
     }
+    touch_of(side)->qty = level.total_qty;
+    if (updates) updates->push_back(LevelUpdate{side, price, level.total_qty});
+}
+
+// Orderbook function to "execute" a specified qty of the best ask
+// returns list of orders filled/partially filled
+vector<Fill> OrderBook::consume_best_ask(int qty){
+    vector<Fill> fills;
+    consume_best(asks, qty, fills, nullptr);
     return fills;
 }
 
@@ -92,131 +385,234 @@ vector<Fill> OrderBook::consume_best_ask(int qty){
 // returns list of orders filled/partially filled
 vector<Fill> OrderBook::consume_best_bid(int qty){
     vector<Fill> fills;
-    if (!has_best_bid()) return fills;
+    consume_best(bids, qty, fills, nullptr);
+    return fills;
+}
 
-    auto bids_it = bids.begin();
-    auto order_it = bids_it->second.orders.begin();
+void OrderBook::consume_best_ask(int qty, vector<Fill>& fills, vector<LevelUpdate>* updates){
+    consume_best(asks, qty, fills, updates);
+}
 
-    // while there is still qty to consume and there are orders at the best ask price
-    while (qty > 0 && order_it != bids_it->second.orders.end()){
-        
-        // if qty >= qty of the first order
-        if (qty >= order_it->qty_remaining){
-            fills.push_back(Fill{order_it->order_id, order_it-> qty_remaining});
-            qty -= order_it->qty_remaining;
-            bids_it->second.total_qty -= order_it->qty_remaining;
-            live_orders.erase(order_it->order_id);
-            order_it = bids_it->second.orders.erase(order_it);
-            if (bids_it->second.orders.empty()){
-                bids.erase(bids_it);
-                break;
-            }
-        }
-        else {
-            fills.push_back(Fill{order_it->order_id, qty});
-            order_it->qty_remaining -= qty;
-            bids_it->second.total_qty -= qty;
-            qty = 0;
-        }
-    }
-    return fills;
+void OrderBook::consume_best_bid(int qty, vector<Fill>& fills, vector<LevelUpdate>* updates){
+    consume_best(bids, qty, fills, updates);
 }
 
 
 // OrderBook function to add a new limit order to the orderbook
-AddResult OrderBook::add_limit(int order_id, Side side, int price, int qty){
+AddResult OrderBook::add_limit(int order_id, Side side, int price, int qty, vector<LevelUpdate>* updates){
 
-    if (seen_ids.count(order_id)){
+    // one probe sequence both detects duplicates and claims the slot
+    auto [entry, inserted] = orders.insert(order_id);
+    if (!inserted){
         return AddResult::Duplicate;
     }
-    seen_ids.insert(order_id);
-    Order o{order_id, qty};
-    if (side == Side::Buy){
-        if (bids.count(price)){
-            bids[price].orders.push_back(o);
-            auto it = std::prev(bids[price].orders.end());
-            bids[price].total_qty+=qty;
+    rest(*entry, order_id, side, price, qty, updates);
+    return AddResult::Added;
+}
 
-            live_orders.insert({order_id, Location{side, price, it}});
-            return AddResult::Added;
-        }
-        Level l(o);
-        bids.insert({price, l});
-        auto it = bids[price].orders.begin();
-        live_orders.insert({order_id, Location{side, price, it}});
-        return AddResult::Added;
+// Orderbook function that queues an order at the back of its price level
+void OrderBook::rest(IndexedOrder& entry, int order_id, Side side, int price, int qty, vector<LevelUpdate>* updates){
+    BookSide& book_side = side == Side::Buy ? bids : asks;
+    Level& level = book_side.find_or_create(price);
+    OrderHandle h = pool.push_back(level, Order{order_id, qty});
+    entry.live = true;
+    entry.loc = Location{side, price, h};
+
+    // the order is at the touch if its price is at least as good as the cached best
+    std::optional<PriceLevel>& best = touch_of(side);
+    if (!best || best->price == price || (side == Side::Buy) == (price > best->price)){
+        best = PriceLevel{price, level.total_qty};
     }
-    else {
-        if (asks.count(price)){
-            asks[price].orders.push_back(o);
-            asks[price].total_qty +=qty;
+    if (updates) updates->push_back(LevelUpdate{side, price, level.total_qty});
+}
+
+// Orderbook function to return aggregate bid/ask data
+BookSnapshot OrderBook::print_book() const{
+    BookSnapshot bs;
+    bs.bids.reserve(bids.level_count());
+    bs.asks.reserve(asks.level_count());
+    bids.for_each_level([&](int price, const Level& level){
+        bs.bids.push_back(PriceLevel{price, level.total_qty});
+    });
+    asks.for_each_level([&](int price, const Level& level){
+        bs.asks.push_back(PriceLevel{price, level.total_qty});
+    });
+    return bs;
+}
 
-            auto it = std::prev(asks[price].orders.end());
-            live_orders.insert({order_id, Location{side, price, it}});
-            return AddResult::Added;
+// Orderbook function to return aggregate data of the best depth levels into reused storage
+void OrderBook::print_book(std::size_t depth, BookSnapshot& out) const{
+    out.bids.clear();
+    out.asks.clear();
+    bids.for_each_level([&](int price, const Level& level){
+        out.bids.push_back(PriceLevel{price, level.total_qty});
+    }, depth);
+    asks.for_each_level([&](int price, const Level& level){
+        out.asks.push_back(PriceLevel{price, level.total_qty});
+    }, depth);
+}
+
+// Orderbook function to cancel an order by id in O(1)
+CancelResult OrderBook::cancel(int id, vector<LevelUpdate>* updates){
+    IndexedOrder* entry = orders.find(id);
+    if (!entry || !resting(id, *entry)) return CancelResult::Unknown;
+
+    entry->live = false;
+    unlink_order(entry->loc, updates);
+    return CancelResult::Cancelled;
+}
+
+// Orderbook function to cancel every order of side in a price range, level by level.
+// Each order's node is read once for its id, which is then cleared so the order's index
+// entry no longer counts as resting; the nodes are freed with their queue.
+void OrderBook::mass_cancel(Side side, int min_price, int max_price, vector<int>& cancelled,
+                            vector<LevelUpdate>* updates){
+    BookSide& book_side = side == Side::Buy ? bids : asks;
+    book_side.remove_levels(min_price, max_price, [&](int price, Level& level){
+        std::size_t count = 0;
+        for (OrderHandle h = level.head; h != null_order; h = pool[h].next){
+            cancelled.push_back(pool[h].order.order_id);
+            pool[h].order.qty_remaining = 0;
+            ++count;
         }
-        Level l(o);
-        asks.insert({price, l});
-        auto it = asks[price].orders.begin();
-        live_orders.insert({order_id, Location{side, price, it}});
-        return AddResult::Added;
+        pool.release_queue(level, count);
+        if (updates) updates->push_back(LevelUpdate{side, price, 0});
+    });
+    refresh_touch(side);
+}
+
+// Orderbook function that removes a resting order from its level and frees its node
+void OrderBook::unlink_order(const Location& loc, vector<LevelUpdate>* updates){
+    BookSide& book_side = loc.side == Side::Buy ? bids : asks;
+    Level* level = book_side.find(loc.price);
+    pool.unlink(*level, loc.handle);
+    int remaining = level->total_qty;
+    if (level->empty()){
+        book_side.remove(loc.price);
     }
+    std::optional<PriceLevel>& best = touch_of(loc.side);
+    if (best->price == loc.price){
+        if (remaining == 0) refresh_touch(loc.side);
+        else best->qty = remaining;
+    }
+    if (updates) updates->push_back(LevelUpdate{loc.side, loc.price, remaining});
 }
 
-// OrderBook debugging function to return the top ask and bid
-TopOfBook OrderBook::top_of_book() const{
-    TopOfBook tob;
+// Orderbook function to change the price and quantity of a resting order.
+// Cutting quantity at the same price only touches the order's node and its level total.
+AmendOutcome OrderBook::amend(int id, int price, int qty, vector<LevelUpdate>* updates){
+    IndexedOrder* entry = orders.find(id);
+    if (!entry || !resting(id, *entry)) return AmendOutcome{AmendAction::Unknown, Side::Buy};
 
-    if (has_best_bid()){
-        PriceLevel bl{best_bid_price(), best_bid_quantity()};
-        tob.best_bid = bl;
+    Location loc = entry->loc;
+    Order& order = pool[loc.handle].order;
+    if (price == loc.price && qty <= order.qty_remaining){
+        if (qty == order.qty_remaining) return AmendOutcome{AmendAction::Reduced, loc.side};
+        Level* level = (loc.side == Side::Buy ? bids : asks).find(price);
+        level->total_qty -= order.qty_remaining - qty;
+        order.qty_remaining = qty;
+        std::optional<PriceLevel>& best = touch_of(loc.side);
+        if (best->price == price) best->qty = level->total_qty;
+        if (updates) updates->push_back(LevelUpdate{loc.side, price, level->total_qty});
+        return AmendOutcome{AmendAction::Reduced, loc.side};
     }
 
-    if (has_best_ask()){
-        PriceLevel al{best_ask_price(), best_ask_quantity()};
-        tob.best_ask = al;
+    unlink_order(loc, updates);
+    const std::optional<PriceLevel>& other = loc.side == Side::Buy ? touch.best_ask : touch.best_bid;
+    if (other && (loc.side == Side::Buy ? price >= other->price : price <= other->price)){
+        entry->live = false;
+        return AmendOutcome{AmendAction::Pulled, loc.side};
     }
+    rest(*entry, id, loc.side, price, qty, updates);
+    return AmendOutcome{AmendAction::Requeued, loc.side};
+}
 
-    return tob;
+// Orderbook function to rest the unmatched part of an order amend pulled off the book
+void OrderBook::rest_pulled(int id, Side side, int price, int qty, vector<LevelUpdate>* updates){
+    IndexedOrder* entry = orders.find(id);
+    if (!entry || entry->live) return;
+    rest(*entry, id, side, price, qty, updates);
 }
 
-// Orderbook function to return aggregate bid/ask data
-BookSnapshot OrderBook::print_book() const{
-    BookSnapshot bs;
-    for (const auto& pl : bids){
-        bs.bids.push_back(PriceLevel{pl.first, pl.second.total_qty});
-    }
-    for (const auto& pl : asks){
-        bs.asks.push_back(PriceLevel{pl.first, pl.second.total_qty});
-    }
-    return bs;
+// Orderbook query function that returns order pool usage, for sizing order_capacity
+OrderPoolStats OrderBook::order_pool_stats() const {
+    return pool.stats();
 }
 
-// Orderbook function to cancel an order by id in O(1)
-CancelResult OrderBook::cancel(int id){
-    auto live_orders_it = live_orders.find(id);
-    if (live_orders_it != live_orders.end()){
-        auto loc_it = live_orders.find(id);
-        if (loc_it == live_orders.end()) return CancelResult::Unknown;
-
-        Location loc = loc_it->second;
-        if (loc.side == Side::Buy){
-            bids[loc.price].total_qty -= loc.order_it->qty_remaining;
-            bids[loc.price].orders.erase(loc.order_it);
-            if (bids[loc.price].orders.empty()){
-                bids.erase(loc.price);
+// Snapshot layout of one book:
+//   u64 count of dead ids, u64 count of resting orders, then each dead id (i32)
+//   bids then asks: u32 level count, then per level best first:
+//     i32 price, u32 order count, then (i32 id, i32 qty) per order in time priority
+void OrderBook::save(SnapshotWriter& out) const {
+    std::size_t live = pool.stats().live;
+    std::size_t dead = orders.size() - live;
+    out.reserve(out.size() + 16 + 4 * dead + 8 * live + 8 * (bids.level_count() + asks.level_count()) + 8);
+    out.put_u64(dead);
+    out.put_u64(live);
+    orders.for_each([&](int id, const IndexedOrder& entry){
+        if (!resting(id, entry)) out.put_i32(id);
+    });
+
+    for (const BookSide* book_side : {&bids, &asks}){
+        out.put_u32(static_cast<std::uint32_t>(book_side->level_count()));
+        book_side->for_each_level([&](int price, const Level& level){
+            out.put_i32(price);
+            std::size_t count_at = out.size();
+            out.put_u32(0);
+            std::uint32_t count = 0;
+            for (OrderHandle h = level.head; h != null_order; h = pool[h].next){
+                out.put_i32(pool[h].order.order_id);
+                out.put_i32(pool[h].order.qty_remaining);
+                ++count;
             }
-            live_orders.erase(id);
-            return CancelResult::Cancelled;
-        } else {
-            asks[loc.price].total_qty -= loc.order_it->qty_remaining;
-            asks[loc.price].orders.erase(loc.order_it);
-            if (asks[loc.price].orders.empty()){
-                asks.erase(loc.price);
+            out.patch_u32(count_at, count);
+        });
+    }
+}
+
+// OrderBook function to rebuild levels and ids from a snapshot, skipping the matching path
+bool OrderBook::load(SnapshotReader& in){
+    constexpr std::uint32_t prefetch_distance = 16;
+    if (orders.size() != 0) return false;
+
+    std::uint64_t dead = in.get_u64();
+    std::uint64_t live = in.get_u64();
+    // ids take 4 bytes and orders 8, which bounds counts read from a corrupt file
+    if (dead > in.remaining() / 4 || live > in.remaining() / 8) return false;
+    orders.reserve(dead + live);
+    pool.reserve(live);
+    for (std::uint64_t i = 0; i < dead; ++i){
+        auto [entry, inserted] = orders.insert(in.get_i32());
+        if (!inserted) return false;
+        entry->live = false;
+    }
+
+    for (Side side : {Side::Buy, Side::Sell}){
+        BookSide& book_side = side == Side::Buy ? bids : asks;
+        std::uint32_t level_count = in.get_u32();
+        if (level_count > in.remaining() / 8) return false;
+        for (std::uint32_t l = 0; l < level_count; ++l){
+            int price = in.get_i32();
+            std::uint32_t order_count = in.get_u32();
+            if (price <= 0 || order_count == 0 || order_count > in.remaining() / 8) return false;
+            if (book_side.find(price)) return false;
+
+            Level& level = book_side.find_or_create(price);
+            for (std::uint32_t o = 0; o < order_count; ++o){
+                // ids sit 8 bytes apart, so the index slot of an id a few orders ahead can be fetched early
+                if (o + prefetch_distance < order_count) orders.prefetch(in.peek_i32(8 * prefetch_distance));
+                int id = in.get_i32();
+                int qty = in.get_i32();
+                if (qty <= 0) return false;
+                auto [entry, inserted] = orders.insert(id);
+                if (!inserted) return false;
+                OrderHandle h = pool.push_back(level, Order{id, qty});
+                entry->live = true;
+                entry->loc = Location{side, price, h};
             }
-            live_orders.erase(id);
-            return CancelResult::Cancelled;
         }
     }
-    return CancelResult::Unknown;
+    refresh_touch(Side::Buy);
+    refresh_touch(Side::Sell);
+    return !in.failed() && pool.stats().live == live;
 }
@@ -7,13 +7,16 @@ Implements FIFO order queues per price level
 
 #pragma once
 #include <map>
-#include <unordered_map>
-#include <unordered_set>
-#include <list>
-#include <functional>
+#include <optional>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
 #include "common.hpp"
+#include "order_index.hpp"
+#include "snapshot.hpp"
 
-struct Fill { 
+struct Fill {
     int resting_order_id;
     int qty_filled;
 };
@@ -23,46 +26,229 @@ struct Order {
     int qty_remaining;
 };
 
+// 32-bit index of an order node in the OrderPool
+using OrderHandle = std::uint32_t;
+constexpr OrderHandle null_order = UINT32_MAX;
+
+// Resting order with intrusive links to its neighbours in the level's FIFO queue
+struct OrderNode {
+    Order order;
+    OrderHandle prev = null_order;
+    OrderHandle next = null_order;
+};
+
+// FIFO queue of orders at one price, linked through the OrderPool
 struct Level {
     int total_qty = 0;
-    std::list<Order> orders;
+    OrderHandle head = null_order;
+    OrderHandle tail = null_order;
 
-    Level() = default;
-
-    Level(Order o){
-        orders.push_back(o);
-        total_qty+= o.qty_remaining;
-    }
+    bool empty() const { return head == null_order; }
 };
 
 struct Location {
     Side side;
     int price;
-    std::list<Order>::iterator order_it;
+    OrderHandle handle;
 };
 
-enum class CancelResult {
-    Cancelled,
-    Unknown
+// Order id index entry: every id ever added has one, live is set while it rests.
+// Mass cancels leave live set and zero the quantity in the freed node instead (see OrderBook::resting).
+struct IndexedOrder {
+    bool live = false;
+    Location loc{};
 };
 
-enum class AddResult { 
+struct OrderPoolStats {
+    std::size_t live;          // nodes currently holding a resting order
+    std::size_t high_water;    // most nodes ever live at once
+    std::size_t capacity;      // nodes available without touching the allocator
+};
+
+// Slab of fixed-size order nodes with a free list.
+// Handles stay valid while the slab grows, so Locations never dangle.
+class OrderPool {
+private:
+    std::vector<OrderNode> nodes;
+    OrderHandle free_head = null_order;
+    std::size_t live = 0;
+    std::size_t high_water = 0;
+
+public:
+    void reserve(std::size_t capacity) { nodes.reserve(capacity); }
+
+    OrderNode& operator[](OrderHandle h) { return nodes[h]; }
+    const OrderNode& operator[](OrderHandle h) const { return nodes[h]; }
+
+    OrderHandle allocate(Order o);
+    void release(OrderHandle h);
+
+    // Queue operations on a level whose orders live in this pool
+    OrderHandle push_back(Level& level, Order o);
+    void unlink(Level& level, OrderHandle h);
+
+    // Frees a whole queue of count orders at once, leaving level empty
+    void release_queue(Level& level, std::size_t count);
+
+    OrderPoolStats stats() const;
+};
+
+enum class AddResult {
     Added,
     Duplicate
 };
 
+// What OrderBook::amend did with an order
+enum class AmendAction {
+    Unknown,    // no resting order has that id
+    Reduced,    // same price and no more quantity: changed in place, time priority kept
+    Requeued,   // new price or more quantity: moved to the back of the queue at its price
+    Pulled      // new price reaches the other side: taken off the book for the caller to
+                // match, its id stays in use and rest_pulled rests any remainder
+};
+
+struct AmendOutcome {
+    AmendAction action;
+    Side side;          // side of the order, unless action is Unknown
+};
+
+// Storage used for the price levels of each side of the book.
+// Map:    std::map keyed by price, O(log n) per level lookup.
+// Ladder: contiguous array indexed by tick offset from a base price,
+//         O(1) per level lookup, recentred/grown when prices drift out of range.
+//         Prices too far apart for a ladder of at most ladder_max_ticks are
+//         kept in a std::map beside it.
+enum class BookBackend {
+    Map,
+    Ladder
+};
+
+struct BookConfig {
+    BookBackend backend = BookBackend::Map;
+
+    // Ladder backend only: first price covered by the ladder (0 = centre the
+    // ladder on the first order seen) and the initial number of ticks.
+    int ladder_base_price = 0;
+    int ladder_ticks = 4096;
+
+    // Ladder backend only: the ladder never grows past this many ticks (or
+    // ladder_ticks, if larger). Levels outside its window go to an overflow map.
+    int ladder_max_ticks = 1 << 20;
+
+    // Number of resting orders the order pool is sized for up front
+    std::size_t order_capacity = 0;
+
+    // Number of distinct order ids the order index is sized for up front
+    std::size_t order_id_capacity = 0;
+};
+
+// Price levels of one side of the book, ordered best first
+// (highest price for bids, lowest price for asks).
+class BookSide {
+private:
+    Side side;
+    BookBackend backend;
+
+    // Map backend: every level. Ladder backend: the levels priced outside the ladder window.
+    std::map<int, Level> levels;
+
+    // Ladder backend
+    std::vector<Level> ladder;
+    std::vector<std::uint64_t> occupied;   // one bit per ladder index
+    std::int64_t base_price = 0;
+    int best_index = -1;
+    std::size_t ladder_levels = 0;
+    std::int64_t max_ticks = 0;
+
+    static constexpr std::int64_t unset_base_price = INT64_MIN / 2;
+
+    bool in_ladder(int price) const;
+    bool recentre(int price);
+    void occupy(int index);
+    bool overflow_best() const;
+    void mark_occupied(int index);
+    void clear_occupied(int index);
+    int next_occupied(int from) const;      // first set bit at index >= from, -1 if none
+    int prev_occupied(int from) const;      // last set bit at index <= from, -1 if none
+
+public:
+    BookSide(Side side, const BookConfig& config);
+
+    bool empty() const;
+    std::size_t level_count() const;
+
+    int best_price() const;
+    Level& best_level();
+    const Level& best_level() const;
+
+    Level* find(int price);
+    Level& find_or_create(int price);
+
+    // Starts loading the ladder entry of price into cache. The map backend has no
+    // fixed slot to fetch, so there it does nothing.
+    void prefetch(int price) const {
+        if (backend != BookBackend::Ladder) return;
+        std::int64_t offset = static_cast<std::int64_t>(price) - base_price;
+        if (offset < 0 || offset >= static_cast<std::int64_t>(ladder.size())) return;
+        __builtin_prefetch(&ladder[offset], 1);
+        __builtin_prefetch(&occupied[offset >> 6], 1);
+    }
+    void remove(int price);
+
+    // Calls f(price, level) for every level from best to worst, or for the first limit levels.
+    template <typename F>
+    void for_each_level(F&& f, std::size_t limit = SIZE_MAX) const;
+
+    // Calls f(price, level) for every level priced from min_price to max_price, best first,
+    // then removes them together. f must leave each level empty.
+    template <typename F>
+    void remove_levels(int min_price, int max_price, F&& f);
+};
+
 class OrderBook {
 private:
-    std::map<int, Level> asks;
-    std::map<int, Level, std::greater<int>> bids;
-    std::unordered_map<int, Location> live_orders;
-    std::unordered_set<int> seen_ids;
+    BookSide asks;
+    BookSide bids;
+    OrderPool pool;
+    OrderIndex<IndexedOrder> orders;
+
+    // best level of each side, kept current by every function that changes a level,
+    // so the touch is read without walking either side
+    TopOfBook touch;
+
+    std::optional<PriceLevel>& touch_of(Side side) { return side == Side::Buy ? touch.best_bid : touch.best_ask; }
+    void refresh_touch(Side side);
+
+    // True if entry, the index entry of id, is a resting order: live and its node still holds
+    // id with quantity left. Mass cancels free nodes without a random probe of the index per
+    // order, zeroing their quantity, which no resting order has, so any id (0 included) works.
+    bool resting(int id, const IndexedOrder& entry) const {
+        const Order& order = pool[entry.loc.handle].order;
+        return entry.live && order.order_id == id && order.qty_remaining > 0;
+    }
+
+    // Queues qty at the back of price for an id already in the index
+    void rest(IndexedOrder& entry, int order_id, Side side, int price, int qty, std::vector<LevelUpdate>* updates);
+
+    // Takes a resting order out of its level, leaving its id entry alone
+    void unlink_order(const Location& loc, std::vector<LevelUpdate>* updates);
+
+    void consume_best(BookSide& book_side, int qty, std::vector<Fill>& fills, std::vector<LevelUpdate>* updates);
 
 public:
-    AddResult add_limit(int order_id, Side side, int price, int qty);
-    TopOfBook top_of_book() const;
+    explicit OrderBook(const BookConfig& config = BookConfig{});
+
+    // Functions that change a level's quantity append its new quantity to updates when it is given
+
+    AddResult add_limit(int order_id, Side side, int price, int qty, std::vector<LevelUpdate>* updates = nullptr);
+    // Best bid and ask, cached so the query never walks the book
+    const TopOfBook& top_of_book() const { return touch; }
     BookSnapshot print_book() const;
 
+    // Fills out with at most depth levels of each side, best first. out's vectors are
+    // cleared and refilled, so reusing one snapshot does not allocate once it is warm.
+    void print_book(std::size_t depth, BookSnapshot& out) const;
+
     bool has_best_ask() const;
     bool has_best_bid() const;
 
@@ -77,7 +263,123 @@ public:
     std::vector<Fill> consume_best_ask(int qty);
     std::vector<Fill> consume_best_bid(int qty);
 
+    // Append fills to a caller-owned buffer, so matching does not allocate once it is warm
+    void consume_best_ask(int qty, std::vector<Fill>& fills, std::vector<LevelUpdate>* updates = nullptr);
+    void consume_best_bid(int qty, std::vector<Fill>& fills, std::vector<LevelUpdate>* updates = nullptr);
+
     bool has_order(int id) const;
+    void reserve_order_ids(std::size_t capacity);
+
+    // Cache hints for a command about to run, see BasicMatchingEngine::process_batch.
+    // prefetch_order starts loading the index slot of id; prefetch_resting, issued once that
+    // slot has arrived, loads the node and level of id if it rests; prefetch_level loads the
+    // level an order at price would join.
+    void prefetch_order(int id) const { orders.prefetch(id); }
+    void prefetch_resting(int id) const {
+        const IndexedOrder* entry = orders.find(id);
+        if (!entry || !entry->live) return;
+        __builtin_prefetch(&pool[entry->loc.handle], 1);
+        prefetch_level(entry->loc.side, entry->loc.price);
+    }
+    void prefetch_level(Side side, int price) const {
+        (side == Side::Buy ? bids : asks).prefetch(price);
+    }
+
+    CancelResult cancel(int order_id, std::vector<LevelUpdate>* updates = nullptr);
+
+    // Cancels every resting order of side priced from min_price to max_price, appending
+    // their ids to cancelled best level first and in time priority within a level. Levels
+    // are visited once and their queues freed whole, without a per-order unlink or index lookup.
+    void mass_cancel(Side side, int min_price, int max_price, std::vector<int>& cancelled,
+                     std::vector<LevelUpdate>* updates = nullptr);
+
+    // Changes a resting order to price and qty, keeping its side and id. A quantity cut at
+    // the same price keeps time priority; a new price or a larger quantity loses it.
+    AmendOutcome amend(int order_id, int price, int qty, std::vector<LevelUpdate>* updates = nullptr);
+
+    // Rests what is left of an order after amend returned Pulled and the caller matched it
+    void rest_pulled(int order_id, Side side, int price, int qty, std::vector<LevelUpdate>* updates = nullptr);
 
-    CancelResult cancel(int order_id);
+    OrderPoolStats order_pool_stats() const;
+
+    // Writes the resting orders of both sides, level by level in time priority,
+    // and every order id seen so far (ids of filled or cancelled orders stay duplicates)
+    void save(SnapshotWriter& out) const;
+
+    // Restores a book written by save into this empty book.
+    // Returns false, leaving the book unusable, if the snapshot is malformed.
+    bool load(SnapshotReader& in);
 };
+
+template <typename F>
+void BookSide::for_each_level(F&& f, std::size_t limit) const {
+    auto visit = [&](int price, const Level& level){
+        if (limit == 0) return false;
+        --limit;
+        f(price, level);
+        return true;
+    };
+    // map levels beyond the ladder window on the best side come before the ladder,
+    // the rest after it (the map backend has no ladder, so this is one pass)
+    std::int64_t window_low = base_price;
+    std::int64_t window_high = base_price + static_cast<std::int64_t>(ladder.size()) - 1;
+    if (side == Side::Buy){
+        auto it = levels.rbegin();
+        for (; it != levels.rend() && it->first > window_high && visit(it->first, it->second); ++it) {}
+        for (int i = best_index; i >= 0 && visit(static_cast<int>(base_price + i), ladder[i]); i = prev_occupied(i - 1)) {}
+        for (; it != levels.rend() && visit(it->first, it->second); ++it) {}
+    } else {
+        auto it = levels.begin();
+        for (; it != levels.end() && it->first < window_low && visit(it->first, it->second); ++it) {}
+        for (int i = best_index; i >= 0 && visit(static_cast<int>(base_price + i), ladder[i]); i = next_occupied(i + 1)) {}
+        for (; it != levels.end() && visit(it->first, it->second); ++it) {}
+    }
+}
+
+template <typename F>
+void BookSide::remove_levels(int min_price, int max_price, F&& f) {
+    if (min_price > max_price) return;
+
+    // the ladder part of the range, as ladder indexes (low > high when there is none)
+    std::int64_t low = static_cast<std::int64_t>(min_price) - base_price;
+    std::int64_t high = static_cast<std::int64_t>(max_price) - base_price;
+    if (low < 0) low = 0;
+    if (high >= static_cast<std::int64_t>(ladder.size())) high = static_cast<std::int64_t>(ladder.size()) - 1;
+    if (ladder_levels == 0) high = -1;
+
+    auto take = [&](int i){
+        f(static_cast<int>(base_price + i), ladder[i]);
+        ladder[i] = Level{};
+        clear_occupied(i);
+        --ladder_levels;
+    };
+    auto remove_ladder_part = [&]{
+        if (low > high) return;
+        if (side == Side::Buy){
+            for (int i = prev_occupied(static_cast<int>(high)); i >= low; i = prev_occupied(i - 1)) take(i);
+        } else {
+            for (int i = next_occupied(static_cast<int>(low)); i >= 0 && i <= high; i = next_occupied(i + 1)) take(i);
+        }
+        if (best_index >= low && best_index <= high){
+            best_index = side == Side::Buy ? prev_occupied(static_cast<int>(low) - 1) : next_occupied(static_cast<int>(high) + 1);
+        }
+    };
+
+    // map levels beyond the ladder window on the best side come before the ladder, the rest after it
+    auto first = levels.lower_bound(min_price);
+    auto last = levels.upper_bound(max_price);
+    if (side == Side::Buy){
+        std::int64_t window_high = base_price + static_cast<std::int64_t>(ladder.size()) - 1;
+        auto it = last;
+        for (; it != first && std::prev(it)->first > window_high; --it) f(std::prev(it)->first, std::prev(it)->second);
+        remove_ladder_part();
+        for (; it != first; --it) f(std::prev(it)->first, std::prev(it)->second);
+    } else {
+        std::int64_t window_low = base_price;
+        auto it = first;
+        for (; it != last && it->first < window_low; ++it) f(it->first, it->second);
+        remove_ladder_part();
+        for (; it != last; ++it) f(it->first, it->second);
+    }
+    levels.erase(first, last);
+}
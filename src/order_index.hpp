@@ -0,0 +1,152 @@
+/**
+order_index.hpp
+--------------
+Defines OrderIndex, a flat open-addressing hash map keyed by order id.
+Uses Robin Hood probing with backward-shift deletion, so lookups are one
+probe sequence through a contiguous array and erase leaves no tombstones.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+template <typename Value>
+class OrderIndex {
+private:
+    struct Slot {
+        int key;
+        std::uint32_t probe;   // distance from the home slot + 1, 0 = empty
+        Value value;
+    };
+
+    std::vector<Slot> slots;
+    std::size_t mask = 0;
+    std::size_t count = 0;
+    int shift = 64;
+
+    // slots are kept at most 7/8 full
+    static std::size_t capacity_for(std::size_t entries) {
+        std::size_t capacity = 16;
+        while (capacity - capacity / 8 < entries) capacity *= 2;
+        return capacity;
+    }
+
+    // Fibonacci hashing spreads sequential ids across the table
+    std::size_t home(int key) const {
+        return static_cast<std::size_t>(
+            (static_cast<std::uint64_t>(static_cast<std::uint32_t>(key)) * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(capacity, Slot{0, 0, Value{}});
+        mask = capacity - 1;
+        shift = 64 - __builtin_ctzll(capacity);
+        count = 0;
+        for (Slot& s : old){
+            if (s.probe) place(s.key, std::move(s.value));
+        }
+    }
+
+    // Robin Hood insert of a key known to be absent, returns the slot it landed in
+    Slot* place(int key, Value value) {
+        Slot carry{key, 1, std::move(value)};
+        Slot* landed = nullptr;
+        std::size_t pos = home(key);
+        while (true){
+            Slot& s = slots[pos];
+            if (s.probe == 0){
+                s = std::move(carry);
+                ++count;
+                return landed ? landed : &s;
+            }
+            if (s.probe < carry.probe){
+                std::swap(s, carry);
+                if (!landed) landed = &s;
+            }
+            ++carry.probe;
+            pos = (pos + 1) & mask;
+        }
+    }
+
+public:
+    explicit OrderIndex(std::size_t capacity = 0) {
+        rehash(capacity_for(capacity));
+    }
+
+    // Grows the table so that capacity entries fit without rehashing
+    void reserve(std::size_t capacity) {
+        std::size_t needed = capacity_for(capacity);
+        if (needed > slots.size()) rehash(needed);
+    }
+
+    std::size_t size() const { return count; }
+
+    // Starts loading the home slot of key into cache ahead of an insert or find
+    void prefetch(int key) const {
+        __builtin_prefetch(&slots[home(key)], 1);
+    }
+
+    // Calls f(key, value) for every entry, in table order
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const Slot& s : slots){
+            if (s.probe) f(s.key, s.value);
+        }
+    }
+    std::size_t capacity() const { return slots.size() - slots.size() / 8; }
+
+    // Returns the value stored for key, or nullptr if key is absent
+    Value* find(int key) {
+        std::size_t pos = home(key);
+        for (std::uint32_t probe = 1; ; ++probe){
+            Slot& s = slots[pos];
+            if (s.probe < probe) return nullptr;
+            if (s.key == key) return &s.value;
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    const Value* find(int key) const {
+        return const_cast<OrderIndex*>(this)->find(key);
+    }
+
+    // Returns the value for key and whether it was inserted (false if key was present).
+    // The pointer is valid until the next insert.
+    std::pair<Value*, bool> insert(int key) {
+        std::size_t pos = home(key);
+        for (std::uint32_t probe = 1; ; ++probe){
+            Slot& s = slots[pos];
+            if (s.probe < probe) break;
+            if (s.key == key) return {&s.value, false};
+            pos = (pos + 1) & mask;
+        }
+        if (count + 1 > capacity()) rehash(slots.size() * 2);
+        return {&place(key, Value{})->value, true};
+    }
+
+    // Removes key by shifting the rest of its cluster back one slot
+    bool erase(int key) {
+        std::size_t pos = home(key);
+        for (std::uint32_t probe = 1; ; ++probe){
+            Slot& s = slots[pos];
+            if (s.probe < probe) return false;
+            if (s.key == key) break;
+            pos = (pos + 1) & mask;
+        }
+        std::size_t next = (pos + 1) & mask;
+        while (slots[next].probe > 1){
+            slots[pos] = std::move(slots[next]);
+            --slots[pos].probe;
+            pos = next;
+            next = (next + 1) & mask;
+        }
+        slots[pos].probe = 0;
+        --count;
+        return true;
+    }
+};
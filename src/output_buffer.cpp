@@ -0,0 +1,54 @@
+/**
+output_buffer.cpp
+--------------
+Implements writing buffered output to a file descriptor or stream
+ */
+
+#include "output_buffer.hpp"
+#include <cerrno>
+#include <unistd.h>
+
+OutputBuffer::OutputBuffer(int out_fd, std::size_t buffer_capacity, std::mutex* lock)
+    : capacity(buffer_capacity), fd(out_fd), write_lock(lock) {
+    // room for the line that crosses the threshold
+    data.reserve(capacity + 4096);
+}
+
+OutputBuffer::OutputBuffer(std::ostream& os, std::size_t buffer_capacity)
+    : capacity(buffer_capacity), stream(&os) {
+    data.reserve(capacity + 4096);
+}
+
+OutputBuffer::~OutputBuffer(){
+    flush();
+}
+
+void OutputBuffer::write_out(){
+    if (!blocked && before_write && !before_write()) blocked = true;
+    if (blocked){
+        data.clear();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock;
+    if (write_lock) lock = std::unique_lock<std::mutex>(*write_lock);
+
+    if (stream){
+        stream->write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    else {
+        const char* p = data.data();
+        std::size_t left = data.size();
+        while (left > 0){
+            ssize_t n = ::write(fd, p, left);
+            if (n < 0){
+                if (errno == EINTR) continue;
+                break;   // output closed (e.g. EPIPE), drop what is left
+            }
+            p += n;
+            left -= static_cast<std::size_t>(n);
+        }
+    }
+    written += data.size();
+    data.clear();
+}
@@ -0,0 +1,68 @@
+/**
+output_buffer.hpp
+--------------
+Defines OutputBuffer, a large reusable byte buffer that collects formatted
+output lines and hands them to a file descriptor (with write(2)) or to an
+ostream in one call when it fills up or when flushed explicitly.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+class OutputBuffer {
+private:
+    std::string data;
+    std::size_t capacity;
+    int fd = -1;
+    std::ostream* stream = nullptr;
+    std::mutex* write_lock = nullptr;
+    std::size_t written = 0;
+    std::function<bool()> before_write;
+    bool blocked = false;
+
+    void write_out();
+
+public:
+    // Writes to fd. Buffers sharing an fd across threads pass a common write_lock,
+    // so each flush lands whole.
+    explicit OutputBuffer(int out_fd, std::size_t buffer_capacity = 1 << 16, std::mutex* lock = nullptr);
+
+    // Writes to os, e.g. an ostringstream in tests
+    explicit OutputBuffer(std::ostream& os, std::size_t buffer_capacity = 1 << 16);
+
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    // Runs hook before each write of buffered output, e.g. to make the commands
+    // that produced it durable first. Once hook returns false, pending and later
+    // output is dropped instead of written.
+    void set_before_write(std::function<bool()> hook) { before_write = std::move(hook); }
+
+    // Formatters append whole lines here, then call commit()
+    std::string& text() { return data; }
+
+    // Flushes once a full buffer's worth of lines is pending
+    void commit() {
+        if (data.size() >= capacity) flush();
+    }
+
+    void flush() {
+        if (!data.empty()) write_out();
+    }
+
+    std::size_t pending() const { return data.size(); }
+
+    // Bytes handed to the fd or stream so far
+    std::size_t bytes_written() const { return written; }
+
+    // Whether the before-write hook has failed, so output is being dropped
+    bool failed() const { return blocked; }
+};
@@ -7,6 +7,8 @@ No I/O or outputs performed.
  */
 
 #include "parser.hpp"
+#include <charconv>
+#include <climits>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -14,6 +16,7 @@ No I/O or outputs performed.
 
 using std::vector;
 using std::string;
+using std::string_view;
 using std::istringstream;
 using std::stoi;
 using std::size_t;
@@ -85,10 +88,108 @@ Command parse_new_command(const vector<string> &tokens){
     }
 }
 
+// Helper function to process an amend command "A <order_id> <price (ticks)> <qty>"
+Command parse_amend_command(const vector<string> &tokens){
+    if (tokens.size() != 4) return reject_command();
+    try {
+        size_t pos = 0;
+        int order_id = stoi(tokens[1], &pos);
+        if (order_id <= 0 || pos != tokens[1].size()) return reject_command();
+
+        pos = 0;
+        int price = stoi(tokens[2], &pos);
+        if (price <= 0 || pos != tokens[2].size()) return reject_command(order_id);
+
+        pos = 0;
+        int qty = stoi(tokens[3], &pos);
+        if (qty <= 0 || pos != tokens[3].size()) return reject_command(order_id);
+
+        Command c{CommandType::Amend, order_id};
+        c.price = price;
+        c.qty = qty;
+        return c;
+    }
+    catch (const invalid_argument& e) {
+        return reject_command();
+    } catch (const out_of_range& e) {
+        return reject_command();
+    }
+}
+
+// Helper function to process a limited depth book command "B <levels>"
+Command parse_depth_command(const vector<string> &tokens){
+    if (tokens.size() != 2) return reject_command();
+    try {
+        size_t pos = 0;
+        int depth = stoi(tokens[1], &pos);
+        if (depth <= 0 || pos != tokens[1].size()) return reject_command();
+        Command c{CommandType::PrintFullBook};
+        c.qty = depth;
+        return c;
+    }
+    catch (const invalid_argument& e) {
+        return reject_command();
+    } catch (const out_of_range& e) {
+        return reject_command();
+    }
+}
+
+// Helper function to process a mass cancel "M", "M <side>" or "M <side> <min price> <max price>"
+Command parse_mass_cancel_command(const vector<string> &tokens){
+    if (tokens.size() == 1) return Command{CommandType::MassCancel};
+    if (tokens.size() != 2 && tokens.size() != 4) return reject_command();
+    if (tokens[1] != "B" && tokens[1] != "S") return reject_command();
+    Command c{CommandType::MassCancelSide};
+    c.side = tokens[1] == "B" ? Side::Buy : Side::Sell;
+    c.price = 1;
+    c.qty = INT_MAX;
+    if (tokens.size() == 2) return c;
+    try {
+        size_t pos = 0;
+        c.price = stoi(tokens[2], &pos);
+        if (c.price <= 0 || pos != tokens[2].size()) return reject_command();
+
+        pos = 0;
+        c.qty = stoi(tokens[3], &pos);
+        if (c.qty < c.price || pos != tokens[3].size()) return reject_command();
+        return c;
+    }
+    catch (const invalid_argument& e) {
+        return reject_command();
+    } catch (const out_of_range& e) {
+        return reject_command();
+    }
+}
+
+// Number of tokens of each command when it names no symbol, 0 for commands that never take one.
+size_t command_arity(char op){
+    switch (op){
+        case 'N': return 5;
+        case 'C': return 2;
+        case 'A': return 4;
+        case 'P': return 1;
+        case 'B': return 1;
+        case 'M': return 1;
+        default: return 0;
+    }
+}
+
+// True if a command with count tokens, second of them second, has a symbol right after its op.
+// B takes an optional depth, so it may have one token more than its arity. M takes an
+// optional side and price range; a lone B or S after it is the side, not a symbol.
+bool names_symbol(char op, size_t count, string_view second){
+    size_t arity = command_arity(op);
+    if (arity == 0) return false;
+    if (op == 'M') return count == 3 || count == 5 || (count == 2 && second != "B" && second != "S");
+    return count == arity + 1 || (op == 'B' && count == arity + 2);
+}
 
 // Parses a single input line into a Command.
 // This function never throws and always returns a Command.
 // Malformed or invalid input results in a Reject(BAD) command.
+// N, C, A, P, B and M may name a symbol right after the op: "N AAPL 1 B 100 10".
+// B may limit the levels printed per side: "B 5", "B AAPL 5".
+// M may limit the orders cancelled to a side and price range: "M B", "M AAPL S 100 105".
 Command parse_command(const string& line){
     vector<string> tokens = tokenize_input(line);
     if (tokens.size() == 0){
@@ -101,15 +202,27 @@ Command parse_command(const string& line){
         return reject_command();
     }
 
-    // op must be a single character (N, C, P, B, or X).
-    switch (op[0]){
+    Symbol symbol = default_symbol;
+    if (names_symbol(op[0], tokens.size(), tokens.size() > 1 ? tokens[1] : "") && parse_symbol(tokens[1], symbol)){
+        tokens.erase(tokens.begin() + 1);
+    }
+
+    Command c = parse_unqualified_command(op[0], tokens);
+    c.symbol = symbol;
+    return c;
+}
+
+// Parses the tokens of a command whose symbol (if any) has been removed.
+Command parse_unqualified_command(char op, const vector<string>& tokens){
+    // op must be a single character (N, C, A, P, B, M, or X).
+    switch (op){
         case 'P':
             if (tokens.size() == 1) return Command{CommandType::PrintTopOfBook};
             return reject_command();
             break;
         case 'B':
             if (tokens.size() == 1) return Command{CommandType::PrintFullBook};
-            return reject_command();
+            return parse_depth_command(tokens);
             break;
         case 'X':
             if (tokens.size() == 1) return Command{CommandType::Exit};
@@ -121,6 +234,12 @@ Command parse_command(const string& line){
         case 'N':
             return parse_new_command(tokens);
             break;
+        case 'A':
+            return parse_amend_command(tokens);
+            break;
+        case 'M':
+            return parse_mass_cancel_command(tokens);
+            break;
         default:
             return reject_command();
     }
@@ -136,3 +255,191 @@ vector<Command> parse_commands(const string& batch){
     }
     return commands;
 }
+
+
+// Whitespace as seen by istringstream's operator>> in the C locale
+static bool is_space(char ch){
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\v' || ch == '\f' || ch == '\r';
+}
+
+// Tokens of one line as views into it. Only the first max_tokens are kept,
+// count keeps counting so over-long lines are still recognised as such.
+struct TokenViews {
+    static constexpr size_t max_tokens = 6;
+    string_view tokens[max_tokens];
+    size_t count = 0;
+};
+
+static TokenViews tokenize_view(string_view line){
+    TokenViews tv;
+    size_t i = 0;
+    while (i < line.size()){
+        while (i < line.size() && is_space(line[i])) ++i;
+        if (i == line.size()) break;
+        size_t start = i;
+        while (i < line.size() && !is_space(line[i])) ++i;
+        if (tv.count < TokenViews::max_tokens) tv.tokens[tv.count] = line.substr(start, i - start);
+        ++tv.count;
+    }
+    return tv;
+}
+
+// Outcome of converting a token the way stoi does
+enum class IntParse {
+    Ok,         // whole token is an int
+    Trailing,   // stoi would stop before the end of the token
+    Throws      // stoi would throw (no digits, or out of int range)
+};
+
+static IntParse parse_int(string_view token, int& value){
+    const char* first = token.data();
+    const char* last = token.data() + token.size();
+    // from_chars takes no '+', stoi takes one in front of the digits
+    if (first != last && *first == '+'){
+        ++first;
+        if (first == last || *first < '0' || *first > '9') return IntParse::Throws;
+    }
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec != std::errc()) return IntParse::Throws;
+    return ptr == last ? IntParse::Ok : IntParse::Trailing;
+}
+
+// "C <order_id>", mirrors parse_cancel_command
+static Command parse_cancel_view(const string_view* tokens, size_t count){
+    if (count != 2) return reject_command();
+    int order_id = 0;
+    if (parse_int(tokens[1], order_id) != IntParse::Ok || order_id <= 0) return reject_command();
+    return Command{CommandType::Cancel, order_id};
+}
+
+// "B <levels>", mirrors parse_depth_command
+static Command parse_depth_view(const string_view* tokens, size_t count){
+    if (count != 2) return reject_command();
+    int depth = 0;
+    if (parse_int(tokens[1], depth) != IntParse::Ok || depth <= 0) return reject_command();
+    Command c{CommandType::PrintFullBook};
+    c.qty = depth;
+    return c;
+}
+
+// "A <order_id> <price (ticks)> <qty>", mirrors parse_amend_command
+static Command parse_amend_view(const string_view* tokens, size_t count){
+    if (count != 4) return reject_command();
+    int order_id = 0;
+    if (parse_int(tokens[1], order_id) != IntParse::Ok || order_id <= 0) return reject_command();
+
+    int price = 0;
+    IntParse result = parse_int(tokens[2], price);
+    if (result == IntParse::Throws) return reject_command();
+    if (result == IntParse::Trailing || price <= 0) return reject_command(order_id);
+
+    int qty = 0;
+    result = parse_int(tokens[3], qty);
+    if (result == IntParse::Throws) return reject_command();
+    if (result == IntParse::Trailing || qty <= 0) return reject_command(order_id);
+
+    Command c{CommandType::Amend, order_id};
+    c.price = price;
+    c.qty = qty;
+    return c;
+}
+
+// "M [<side> [<min price> <max price>]]", mirrors parse_mass_cancel_command
+static Command parse_mass_cancel_view(const string_view* tokens, size_t count){
+    if (count == 1) return Command{CommandType::MassCancel};
+    if (count != 2 && count != 4) return reject_command();
+    if (tokens[1] != "B" && tokens[1] != "S") return reject_command();
+    Command c{CommandType::MassCancelSide};
+    c.side = tokens[1] == "B" ? Side::Buy : Side::Sell;
+    c.price = 1;
+    c.qty = INT_MAX;
+    if (count == 2) return c;
+    if (parse_int(tokens[2], c.price) != IntParse::Ok || c.price <= 0) return reject_command();
+    if (parse_int(tokens[3], c.qty) != IntParse::Ok || c.qty < c.price) return reject_command();
+    return c;
+}
+
+// "N <order_id> <side> <price (ticks)> <qty>", mirrors parse_new_command.
+// Fields that stoi would throw on reject without the order id, as the exception path does.
+static Command parse_new_view(const string_view* tokens, size_t count){
+    if (count != 5) return reject_command();
+    int order_id = 0;
+    if (parse_int(tokens[1], order_id) != IntParse::Ok || order_id <= 0) return reject_command();
+
+    if (tokens[2].size() != 1 || (tokens[2][0] != 'B' && tokens[2][0] != 'S')) return reject_command(order_id);
+    Side side = tokens[2][0] == 'B' ? Side::Buy : Side::Sell;
+
+    int price = 0;
+    IntParse result = parse_int(tokens[3], price);
+    if (result == IntParse::Throws) return reject_command();
+    if (result == IntParse::Trailing || price <= 0) return reject_command(order_id);
+
+    int qty = 0;
+    result = parse_int(tokens[4], qty);
+    if (result == IntParse::Throws) return reject_command();
+    if (result == IntParse::Trailing || qty <= 0) return reject_command(order_id);
+
+    return Command{CommandType::New, order_id, side, price, qty};
+}
+
+// Parses a single input line into a Command without copying it.
+Command parse_command_view(string_view line){
+    TokenViews tv = tokenize_view(line);
+    if (tv.count == 0 || tv.tokens[0].size() != 1){
+        return reject_command();
+    }
+    char op = tv.tokens[0][0];
+    const string_view* tokens = tv.tokens;
+    size_t count = tv.count;
+
+    // a symbol is dropped by treating the op as if it sat in its place
+    string_view shifted[TokenViews::max_tokens];
+    Symbol symbol = default_symbol;
+    if (names_symbol(op, count, count > 1 ? tokens[1] : string_view()) && parse_symbol(tokens[1], symbol)){
+        shifted[0] = tokens[0];
+        for (size_t i = 2; i < count; ++i) shifted[i - 1] = tokens[i];
+        tokens = shifted;
+        --count;
+    }
+
+    Command c;
+    switch (op){
+        case 'P':
+            c = count == 1 ? Command{CommandType::PrintTopOfBook} : reject_command();
+            break;
+        case 'B':
+            c = count == 1 ? Command{CommandType::PrintFullBook} : parse_depth_view(tokens, count);
+            break;
+        case 'X':
+            c = count == 1 ? Command{CommandType::Exit} : reject_command();
+            break;
+        case 'C':
+            c = parse_cancel_view(tokens, count);
+            break;
+        case 'N':
+            c = parse_new_view(tokens, count);
+            break;
+        case 'A':
+            c = parse_amend_view(tokens, count);
+            break;
+        case 'M':
+            c = parse_mass_cancel_view(tokens, count);
+            break;
+        default:
+            c = reject_command();
+    }
+    c.symbol = symbol;
+    return c;
+}
+
+// Parses a batch of input lines, split the way getline splits them.
+vector<Command> parse_commands_view(string_view batch){
+    vector<Command> commands;
+    while (!batch.empty()){
+        size_t end = batch.find('\n');
+        if (end == string_view::npos) end = batch.size();
+        commands.push_back(parse_command_view(batch.substr(0, end)));
+        batch.remove_prefix(end == batch.size() ? end : end + 1);
+    }
+    return commands;
+}
@@ -1,45 +1,37 @@
 /*
 parser.hpp
 -----------------
-Defines the Command data model and parser interface.
+Defines the parser interface.
 */
 
 #pragma once
 
+#include "command.hpp"
 #include "common.hpp"
 #include <cstdint>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
-enum class CommandType {
-    New,
-    Cancel,
-    PrintTopOfBook,
-    PrintFullBook,
-    Exit,
-    Reject
-};
-
-struct Command {
-    CommandType type;
-
-    std::int64_t order_id = 0;
-    
-    Side side = Side::Buy;
-    std::int32_t price = 0;
-    std::int32_t qty = 0;
-
-    RejectReason reject_reason = RejectReason::BAD; 
-};
-
 
 std::vector<std::string> tokenize_input(const std::string& line);
 Command reject_command(int order_id);
 Command parse_cancel_command(const std::vector<std::string> &tokens);
 Command parse_new_command(const std::vector<std::string> &tokens);
+Command parse_amend_command(const std::vector<std::string> &tokens);
+Command parse_depth_command(const std::vector<std::string> &tokens);
+Command parse_mass_cancel_command(const std::vector<std::string> &tokens);
+std::size_t command_arity(char op);
+bool names_symbol(char op, std::size_t count, std::string_view second);
+Command parse_unqualified_command(char op, const std::vector<std::string>& tokens);
 Command parse_command(const std::string& line);
 std::vector<Command> parse_commands(const std::string& batch);
 
+// Same results as parse_command / parse_commands, but tokenizes views of the
+// input in place and converts numbers with from_chars: no allocation, no exceptions.
+Command parse_command_view(std::string_view line);
+std::vector<Command> parse_commands_view(std::string_view batch);
+
 
 
@@ -0,0 +1,154 @@
+/**
+pipeline.hpp
+--------------
+Defines CommandPipeline, which runs the simulator as three threads:
+
+  read/parse  --SpscRing<Command>-->  match  --EventRing-->  output
+
+The reader turns input into Commands, the matcher runs them through the
+engines (whose EventRingWriters append event records), and the output
+stage replays the records into printers or journal writers. Both rings
+are bounded, and a full ring makes its producer wait, so memory stays
+fixed and the slowest stage sets the pace. Every stage records how long
+it waited on its input and on its output, which gives its utilization.
+Output is byte-identical to the serial path since each ring preserves order.
+ */
+
+#pragma once
+
+#include "command.hpp"
+#include "event_ring.hpp"
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+class CommandPipeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stage {
+        const char* name;
+        double total_seconds = 0;
+        double input_wait_seconds = 0;     // waiting for work from the previous stage
+        double output_wait_seconds = 0;    // waiting for room in the next stage's ring
+        std::size_t items = 0;
+
+        // fraction of total_seconds
+        double share(double seconds) const {
+            return total_seconds > 0 ? seconds / total_seconds : 0;
+        }
+
+        double utilization() const {
+            return share(total_seconds - input_wait_seconds - output_wait_seconds);
+        }
+    };
+
+private:
+    SpscRing<Command> commands;
+    EventRing& events;
+    const EventTargets& targets;
+    EventReplayer replayer;
+    std::atomic<bool> input_done{false};
+    std::atomic<bool> match_done{false};
+
+    Stage reader{"read/parse"};
+    Stage matcher{"match"};
+    Stage output{"output"};
+
+    static double seconds_since(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+public:
+    // targets[book] receives the events of each book, as in EventReplayer::drain.
+    // Books may be added to targets while the pipeline runs.
+    CommandPipeline(EventRing& event_ring, const EventTargets& event_targets,
+                    std::size_t command_capacity = 1 << 14)
+        : commands(command_capacity), events(event_ring), targets(event_targets) {}
+
+    // on_full callback of the engines' EventRingWriters: lets the output stage catch up
+    void wait_for_output() {
+        auto start = Clock::now();
+        std::this_thread::yield();
+        matcher.output_wait_seconds += seconds_since(start);
+    }
+
+    // Runs input through router until input ends or an Exit command is processed.
+    // input.next(Command&) runs on the reader thread, after_drain on the output
+    // thread after every batch of replayed events.
+    template <typename Commands, typename Router, typename AfterDrain>
+    void run(Commands& input, Router& router, AfterDrain after_drain) {
+        std::thread read_thread([&]{
+            auto start = Clock::now();
+            Command cmd;
+            while (input.next(cmd)){
+                if (!commands.try_push(cmd)){
+                    auto wait_start = Clock::now();
+                    while (!commands.try_push(cmd)) std::this_thread::yield();
+                    reader.output_wait_seconds += seconds_since(wait_start);
+                }
+                ++reader.items;
+                // the matcher stops at Exit, so nothing after it would be consumed
+                if (cmd.type == CommandType::Exit) break;
+            }
+            input_done.store(true, std::memory_order_release);
+            reader.total_seconds = seconds_since(start);
+        });
+
+        std::thread output_thread([&]{
+            auto start = Clock::now();
+            while (true){
+                std::size_t n = replayer.drain(events, targets, 4096);
+                if (n != 0){
+                    output.items += n;
+                    after_drain();
+                    continue;
+                }
+                // match_done is set after the last push, so an empty ring now means done
+                if (match_done.load(std::memory_order_acquire) && events.empty()) break;
+                auto wait_start = Clock::now();
+                std::this_thread::yield();
+                output.input_wait_seconds += seconds_since(wait_start);
+            }
+            output.total_seconds = seconds_since(start);
+        });
+
+        auto start = Clock::now();
+        bool exited = false;
+        while (!exited){
+            std::size_t n = commands.consume([&](const Command& cmd){
+                if (exited) return;
+                ++matcher.items;
+                if (!router.process_command(cmd)) exited = true;
+            }, 256);
+            if (n != 0) continue;
+            if (input_done.load(std::memory_order_acquire) && commands.empty()) break;
+            auto wait_start = Clock::now();
+            std::this_thread::yield();
+            matcher.input_wait_seconds += seconds_since(wait_start);
+        }
+        matcher.total_seconds = seconds_since(start);
+        match_done.store(true, std::memory_order_release);
+
+        read_thread.join();
+        output_thread.join();
+    }
+
+    const Stage& read_stage() const { return reader; }
+    const Stage& match_stage() const { return matcher; }
+    const Stage& output_stage() const { return output; }
+
+    // One line per stage: items, busy share of its run time, and where it waited
+    void report(std::ostream& os) const {
+        for (const Stage* stage : {&reader, &matcher, &output}){
+            os << "stage " << stage->name << ": " << stage->items << " items, "
+               << 100 * stage->utilization() << "% busy, "
+               << 100 * stage->share(stage->input_wait_seconds) << "% waiting for input, "
+               << 100 * stage->share(stage->output_wait_seconds) << "% waiting for output\n";
+        }
+    }
+};
@@ -2,61 +2,62 @@
 printer_listener.hpp
 --------------
 Defines PrinterListener for outputting events to stdout
+(or another OutputBuffer), optionally prefixing each line with a symbol.
+Lines are formatted into the buffer and written when it fills up;
+printers of several books may share one buffer to keep lines in order.
  */
 
 #pragma once
 
 #include "events.hpp"
 #include "common.hpp"
-#include <iostream>
-
-using std::cout;
-using std::endl;
+#include "event_format.hpp"
+#include "output_buffer.hpp"
+#include <string>
+#include <utility>
 
 struct PrinterListener : IEventListener {
-    
+    OutputBuffer* out;
+    std::string prefix;
+    bool flush_on_query;   // write TOB and BOOK answers out immediately (interactive use)
+
+    explicit PrinterListener(OutputBuffer& buffer, std::string line_prefix = "", bool flush_queries = false)
+        : out(&buffer), prefix(std::move(line_prefix)), flush_on_query(flush_queries) {}
+
     void on_ack(int order_id) override {
-        cout << "ACK " << order_id << endl;
+        append_ack(out->text(), prefix, order_id);
+        out->commit();
     }
 
     void on_reject(int order_id, RejectReason rr) override{
-        if (rr == RejectReason::BAD){
-            cout << "REJ " << order_id << " BAD" << endl;
-        }
-        else if (rr == RejectReason::DUP){
-            cout << "REJ " << order_id << " DUP" << endl;
-        }
+        append_reject(out->text(), prefix, order_id, rr);
+        out->commit();
     }
 
     void on_trade(const Trade& trd) override{
-        cout << "TRD " << trd.buy_id << " " << trd.sell_id << " " << trd.price << " " << trd.qty << endl;
+        append_trade(out->text(), prefix, trd);
+        out->commit();
     }
 
     void on_cancel(int order_id, CancelResult cr) override {
-        if (cr == CancelResult::Cancelled){
-            cout << "CXL " << order_id << endl;
-        }
-        if (cr == CancelResult::Unknown){
-            cout << "REJ " << order_id << " UNK" << endl;
-        }
+        append_cancel(out->text(), prefix, order_id, cr);
+        out->commit();
+    }
+
+    void on_amend(int order_id, AmendResult ar) override {
+        append_amend(out->text(), prefix, order_id, ar);
+        out->commit();
     }
 
     void on_tob(const TopOfBook& tob) override {
-        if (tob.best_bid.has_value()){
-            cout << "TOB BID " << tob.best_bid.value().price << " " << tob.best_bid.value().qty << endl;
-        }
-        if (tob.best_ask.has_value()){
-            cout << "TOB ASK " << tob.best_ask.value().price << " " << tob.best_ask.value().qty << endl;
-        }
+        append_tob(out->text(), prefix, tob);
+        if (flush_on_query) out->flush();
+        else out->commit();
     }
 
     void on_book(const BookSnapshot& bs) override{
-        for (auto pl : bs.bids){
-            cout << "BOOK BID " << pl.price << " " << pl.qty << endl;
-        }
-        for (auto pl : bs.asks){
-            cout << "BOOK ASK " << pl.price << " " << pl.qty << endl;
-        }
+        append_book(out->text(), prefix, bs);
+        if (flush_on_query) out->flush();
+        else out->commit();
     }
 };
-
@@ -0,0 +1,127 @@
+/**
+sharded_engine.hpp
+--------------
+Defines ShardedEngine, which splits symbols across worker threads.
+Every symbol is owned by exactly one shard (chosen by hashing the symbol),
+and each shard is a worker thread with its own SymbolRouter fed through a
+single-producer/single-consumer ring. Commands of one symbol are therefore
+processed in submission order on one thread, which keeps per-symbol output
+deterministic while different symbols run in parallel.
+ */
+
+#pragma once
+
+#include "command.hpp"
+#include "spsc_ring.hpp"
+#include "symbol_router.hpp"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+template <typename Engine>
+class ShardedEngine {
+public:
+    // Creates the engine of symbol inside shard (called on that shard's thread)
+    using Factory = std::function<std::unique_ptr<Engine>(std::size_t shard, Symbol symbol)>;
+
+    // Called on a shard's thread after each batch of commands it processed
+    using BatchHook = std::function<void(std::size_t shard)>;
+
+private:
+    struct Shard {
+        SpscRing<Command> queue;
+        SymbolRouter<Engine> router;
+        std::atomic<bool> stopping{false};
+        std::thread worker;
+
+        Shard(std::size_t queue_capacity, typename SymbolRouter<Engine>::Factory f)
+            : queue(queue_capacity), router(std::move(f)) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    BatchHook after_batch;
+    bool finished = false;
+
+    void run(std::size_t index) {
+        Shard& shard = *shards[index];
+        while (true){
+            std::size_t n = shard.queue.consume([&](const Command& cmd){
+                shard.router.process_command(cmd);
+            });
+            if (n != 0){
+                if (after_batch) after_batch(index);
+                continue;
+            }
+            // stopping is set after the last push, so an empty queue now means done
+            if (shard.stopping.load(std::memory_order_acquire) && shard.queue.empty()) break;
+            std::this_thread::yield();
+        }
+        if (after_batch) after_batch(index);
+    }
+
+    static void pin_to_cpu(std::thread& t, std::size_t cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % std::thread::hardware_concurrency(), &set);
+        pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+        (void)t;
+        (void)cpu;
+#endif
+    }
+
+public:
+    ShardedEngine(std::size_t shard_count, Factory factory, BatchHook hook = {},
+                  std::size_t queue_capacity = 1 << 14, bool pin_threads = false)
+        : after_batch(std::move(hook)) {
+        if (shard_count == 0) shard_count = 1;
+        for (std::size_t i = 0; i < shard_count; ++i){
+            shards.push_back(std::make_unique<Shard>(queue_capacity, [factory, i](Symbol symbol){
+                return factory(i, symbol);
+            }));
+        }
+        for (std::size_t i = 0; i < shard_count; ++i){
+            shards[i]->worker = std::thread([this, i]{ run(i); });
+            if (pin_threads) pin_to_cpu(shards[i]->worker, i);
+        }
+    }
+
+    ShardedEngine(const ShardedEngine&) = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+    ~ShardedEngine() {
+        finish();
+    }
+
+    // Shard that owns symbol when there are shard_count shards
+    static std::size_t shard_of(Symbol symbol, std::size_t shard_count) {
+        return static_cast<std::size_t>((symbol * 0x9E3779B97F4A7C15ull) >> 32) % shard_count;
+    }
+
+    std::size_t shard_count() const { return shards.size(); }
+
+    // Queues cmd on the shard that owns its symbol, waiting while that shard's ring is full.
+    // Must be called from a single producer thread.
+    void submit(const Command& cmd) {
+        Shard& shard = *shards[shard_of(cmd.symbol, shards.size())];
+        while (!shard.queue.try_push(cmd)) std::this_thread::yield();
+    }
+
+    // Processes everything submitted so far and stops the workers
+    void finish() {
+        if (finished) return;
+        finished = true;
+        for (auto& shard : shards) shard->stopping.store(true, std::memory_order_release);
+        for (auto& shard : shards) shard->worker.join();
+    }
+};
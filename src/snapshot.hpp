@@ -0,0 +1,96 @@
+/**
+snapshot.hpp
+--------------
+Defines SnapshotWriter and SnapshotReader, the fixed-width binary encoding
+used to save and restore engine state. Integers are written in native byte
+order; a snapshot file starts with snapshot_magic. OrderBook::save/load
+define the layout of one book.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+constexpr std::string_view snapshot_magic("EXSNAP1\n", 8);
+
+class SnapshotWriter {
+private:
+    std::string data;
+
+    template <typename T>
+    void put(T value) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        data.append(bytes, sizeof(T));
+    }
+
+public:
+    void put_i32(std::int32_t value) { put(value); }
+    void put_u32(std::uint32_t value) { put(value); }
+    void put_u64(std::uint64_t value) { put(value); }
+    void put_bytes(std::string_view bytes) { data.append(bytes); }
+
+    // Overwrites a u32 written earlier at offset, for counts known only afterwards
+    void patch_u32(std::size_t offset, std::uint32_t value) {
+        std::memcpy(&data[offset], &value, sizeof(value));
+    }
+
+    void reserve(std::size_t bytes) { data.reserve(bytes); }
+    std::size_t size() const { return data.size(); }
+    const std::string& bytes() const { return data; }
+};
+
+// Reads values back in the order they were written. Reading past the end
+// sets failed() and yields zeros, so callers can check once at the end.
+class SnapshotReader {
+private:
+    std::string_view rest;
+    bool failed_read = false;
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (rest.size() < sizeof(T)){
+            failed_read = true;
+            rest = std::string_view();
+            return value;
+        }
+        std::memcpy(&value, rest.data(), sizeof(T));
+        rest.remove_prefix(sizeof(T));
+        return value;
+    }
+
+public:
+    explicit SnapshotReader(std::string_view bytes) : rest(bytes) {}
+
+    std::int32_t get_i32() { return get<std::int32_t>(); }
+    std::uint32_t get_u32() { return get<std::uint32_t>(); }
+    std::uint64_t get_u64() { return get<std::uint64_t>(); }
+
+    // Reads an i32 offset bytes ahead without consuming anything, 0 past the end
+    std::int32_t peek_i32(std::size_t offset) const {
+        std::int32_t value = 0;
+        if (offset + sizeof(value) <= rest.size()) std::memcpy(&value, rest.data() + offset, sizeof(value));
+        return value;
+    }
+
+    // Consumes expected if the input starts with it
+    bool expect(std::string_view expected) {
+        if (rest.substr(0, expected.size()) != expected){
+            failed_read = true;
+            return false;
+        }
+        rest.remove_prefix(expected.size());
+        return true;
+    }
+
+    // Marks the snapshot as malformed
+    void fail() { failed_read = true; }
+
+    std::size_t remaining() const { return rest.size(); }
+    bool failed() const { return failed_read; }
+};
@@ -0,0 +1,87 @@
+/**
+spsc_ring.hpp
+--------------
+Defines SpscRing, a bounded lock-free single-producer/single-consumer queue.
+Capacity is rounded up to a power of two and allocated once. The producer
+and consumer indices live on separate cache lines and each side keeps a
+cached copy of the other's index, so the common case touches no shared line.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+template <typename T>
+class SpscRing {
+private:
+    std::vector<T> buffer;
+    std::size_t mask;
+
+    alignas(64) std::atomic<std::size_t> head{0};   // next slot to read, written by the consumer
+    alignas(64) std::atomic<std::size_t> tail{0};   // next slot to write, written by the producer
+    alignas(64) std::size_t producer_head = 0;      // producer's cached copy of head
+    alignas(64) std::size_t consumer_tail = 0;      // consumer's cached copy of tail
+
+    static std::size_t round_up(std::size_t n) {
+        std::size_t capacity = 2;
+        while (capacity < n) capacity *= 2;
+        return capacity;
+    }
+
+public:
+    explicit SpscRing(std::size_t capacity)
+        : buffer(round_up(capacity)), mask(buffer.size() - 1) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return buffer.size(); }
+
+    std::size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // Producer: appends item, returns false if the ring is full
+    bool try_push(const T& item) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - producer_head == buffer.size()){
+            producer_head = head.load(std::memory_order_acquire);
+            if (t - producer_head == buffer.size()) return false;
+        }
+        buffer[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: removes the oldest item into out, returns false if the ring is empty
+    bool try_pop(T& out) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == consumer_tail){
+            consumer_tail = tail.load(std::memory_order_acquire);
+            if (h == consumer_tail) return false;
+        }
+        out = buffer[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: calls f(item) on up to max available items in order and releases
+    // them in one step, returns the number consumed
+    template <typename F>
+    std::size_t consume(F&& f, std::size_t max = SIZE_MAX) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        consumer_tail = tail.load(std::memory_order_acquire);
+        std::size_t n = consumer_tail - h;
+        if (n > max) n = max;
+        for (std::size_t i = 0; i < n; ++i){
+            f(buffer[(h + i) & mask]);
+        }
+        if (n) head.store(h + n, std::memory_order_release);
+        return n;
+    }
+};
@@ -0,0 +1,59 @@
+/**
+symbol_router.hpp
+--------------
+Defines SymbolRouter, which owns one engine per symbol and routes each
+Command to the engine of the symbol it names. Engines are created on first
+use by a factory, so each can have its own listeners (e.g. a printer with
+the symbol as line prefix).
+ */
+
+#pragma once
+
+#include "command.hpp"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+template <typename Engine>
+class SymbolRouter {
+public:
+    using Factory = std::function<std::unique_ptr<Engine>(Symbol)>;
+
+private:
+    Factory factory;
+    std::unordered_map<Symbol, std::unique_ptr<Engine>> engines;
+
+    // consecutive commands usually name the same symbol
+    Symbol last_symbol = default_symbol;
+    Engine* last_engine = nullptr;
+
+public:
+    explicit SymbolRouter(Factory f) : factory(std::move(f)) {}
+
+    // Returns the engine of symbol, creating it on first use
+    Engine& engine_for(Symbol symbol) {
+        if (last_engine && symbol == last_symbol) return *last_engine;
+        auto it = engines.find(symbol);
+        if (it == engines.end()){
+            it = engines.emplace(symbol, factory(symbol)).first;
+        }
+        last_symbol = symbol;
+        last_engine = it->second.get();
+        return *last_engine;
+    }
+
+    // Runs cmd on the engine of its symbol, returns false when the command is Exit
+    bool process_command(const Command& cmd) {
+        return engine_for(cmd.symbol).process_command(cmd);
+    }
+
+    std::size_t size() const { return engines.size(); }
+
+    // Calls f(symbol, engine) for every engine created so far
+    template <typename F>
+    void for_each(F&& f) {
+        for (auto& entry : engines) f(entry.first, *entry.second);
+    }
+};
@@ -1,72 +1,56 @@
 /**
 test_listener.hpp
 --------------
-Defines TestListener for outputting events to a stringstream
+Defines TestListener for collecting event output in a string,
+formatted exactly as PrinterListener prints it
  */
 
 #pragma once
 #include "events.hpp"
-#include <sstream>
+#include "event_format.hpp"
 #include <string>
 
-using std::ostringstream;
-using std::endl;
 using std::string;
 
 
 class TestListener : public IEventListener {
 private:
-    ostringstream output;
+    string output;
     
 public:
     void on_ack(int order_id) override {
-        output << "ACK " << order_id << endl;
+        append_ack(output, "", order_id);
     }
     
     void on_reject(int order_id, RejectReason rr) override {
-        if (rr == RejectReason::BAD) {
-            output << "REJ " << order_id << " BAD" << endl;
-        } else if (rr == RejectReason::DUP) {
-            output << "REJ " << order_id << " DUP" << endl;
-        }
+        append_reject(output, "", order_id, rr);
     }
     
     void on_trade(const Trade& trd) override {
-        output << "TRD " << trd.buy_id << " " << trd.sell_id << " " << trd.price << " " << trd.qty << endl;
+        append_trade(output, "", trd);
     }
     
     void on_cancel(int order_id, CancelResult cr) override {
-        if (cr == CancelResult::Cancelled) {
-            output << "CXL " << order_id << endl;
-        } else if (cr == CancelResult::Unknown) {
-            output << "REJ " << order_id << " UNK" << endl;
-        }
+        append_cancel(output, "", order_id, cr);
+    }
+    
+    void on_amend(int order_id, AmendResult ar) override {
+        append_amend(output, "", order_id, ar);
     }
     
     void on_tob(const TopOfBook& tob) override {
-        if (tob.best_bid.has_value()) {
-            output << "TOB BID " << tob.best_bid.value().price << " " << tob.best_bid.value().qty << endl;
-        }
-        if (tob.best_ask.has_value()) {
-            output << "TOB ASK " << tob.best_ask.value().price << " " << tob.best_ask.value().qty << endl;
-        }
+        append_tob(output, "", tob);
     }
     
     void on_book(const BookSnapshot& bs) override {
-        for (const auto& pl : bs.bids) {
-            output << "BOOK BID " << pl.price << " " << pl.qty << endl;
-        }
-        for (const auto& pl : bs.asks) {
-            output << "BOOK ASK " << pl.price << " " << pl.qty << endl;
-        }
+        append_book(output, "", bs);
     }
     
     string get_output() const {
-        return output.str();
+        return output;
     }
     
     void clear() {
-        output.str("");
         output.clear();
     }
-};
\ No newline at end of file
+};
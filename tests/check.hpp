@@ -0,0 +1,19 @@
+/**
+check.hpp
+--------------
+Defines CHECK, which the tests use in place of assert. It is not compiled
+out by NDEBUG, so Release builds of the tests still run every checked call
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)){                                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            std::abort();                                                                   \
+        }                                                                                   \
+    } while (0)
@@ -0,0 +1,333 @@
+/**
+microbench.cpp
+--------------
+Microbenchmarks of single order book and engine operations.
+Each case builds small batches of books of a given depth (price levels) and
+orders per level outside of the timed region, then times one primitive on
+each book of the batch while they are still in cache. Every case runs
+warm-up rounds and then repeated measured rounds, and results are printed
+as a table or, with --json, as JSON.
+ */
+
+#include "basic_matching_engine.hpp"
+#include "parser.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+using Clock = std::chrono::steady_clock;
+
+struct Params {
+    BookBackend backend = BookBackend::Map;
+    int depth = 0;        // price levels per side
+    int per_level = 0;    // orders at each level
+};
+
+struct Options {
+    vector<int> depths = {1, 10, 100};
+    vector<int> per_levels = {1, 10, 100};
+    int warmup = 1;
+    int reps = 5;
+    std::size_t min_ops = 10000;        // timed operations per round, when setup allows
+    std::size_t max_setup = 50000;      // resting orders built per round
+    std::size_t max_batch = 64;         // books timed together, few enough to stay in cache
+    string filter;
+    bool json = false;
+};
+
+struct Result {
+    string name;
+    Params params;
+    std::size_t ops = 0;                // operations per measured round
+    vector<double> ns_per_op;           // one per measured round
+};
+
+// Keeps results of untimed-away work observable
+static volatile long long sink = 0;
+
+const char* backend_name(BookBackend backend){
+    return backend == BookBackend::Map ? "map" : "ladder";
+}
+
+BookConfig config_for(const Params& p){
+    BookConfig config;
+    config.backend = p.backend;
+    // wide enough for every benchmark price without recentring, small enough to batch books
+    config.ladder_ticks = 1024;
+    return config;
+}
+
+// Id of the order at position in the queue of level (0 = best) of a book built by add_side
+int order_id(const Params& p, int level, int position){
+    return 1 + level * p.per_level + position;
+}
+
+// Rests depth levels of per_level orders of qty 1 on one side of a book. Bid levels sit at
+// even prices going down from 100000, ask levels at even prices going up from 100002, so
+// odd prices between them are free for new levels.
+void add_side(OrderBook& book, const Params& p, Side side){
+    for (int level = 0; level < p.depth; ++level){
+        int price = side == Side::Buy ? 100000 - 2 * level : 100002 + 2 * level;
+        for (int position = 0; position < p.per_level; ++position){
+            book.add_limit(order_id(p, level, position), side, price, 1);
+        }
+    }
+}
+
+// Runs one case. setup() returns a fixture, run(fixture) performs ops_per_fixture operations
+// on it. A round builds and times batches of fixtures until it has timed min_ops operations
+// or built max_setup resting orders.
+template <typename Setup, typename Run>
+void measure(const Options& options, vector<Result>& results, const string& name, const Params& p,
+             std::size_t ops_per_fixture, std::size_t orders_per_fixture, Setup setup, Run run){
+    if (!options.filter.empty() && name.find(options.filter) == string::npos) return;
+
+    std::size_t batch = std::max<std::size_t>(1, options.min_ops / ops_per_fixture);
+    batch = std::min(batch, options.max_batch);
+    if (orders_per_fixture > 0) batch = std::min(batch, std::max<std::size_t>(1, options.max_setup / orders_per_fixture));
+
+    Result result{name, p, 0, {}};
+    vector<decltype(setup())> prepared;
+    prepared.reserve(batch);
+    for (int round = 0; round < options.warmup + options.reps; ++round){
+        std::size_t ops = 0;
+        std::size_t orders = 0;
+        double ns = 0;
+        while (ops < options.min_ops && (ops == 0 || orders < options.max_setup)){
+            prepared.clear();
+            for (std::size_t i = 0; i < batch; ++i) prepared.push_back(setup());
+
+            auto start = Clock::now();
+            for (auto& fixture : prepared) run(*fixture);
+            auto end = Clock::now();
+
+            ns += std::chrono::duration<double, std::nano>(end - start).count();
+            ops += batch * ops_per_fixture;
+            orders += batch * orders_per_fixture;
+        }
+        if (round >= options.warmup){
+            result.ops = ops;
+            result.ns_per_op.push_back(ns / ops);
+        }
+    }
+    results.push_back(std::move(result));
+}
+
+// Book fixture with bids only, plus a reusable fill buffer
+struct BookFixture {
+    OrderBook book;
+    vector<Fill> fills;
+
+    explicit BookFixture(const BookConfig& config) : book(config) {}
+};
+
+void run_book_cases(const Options& options, const Params& p, vector<Result>& results){
+    std::size_t orders = static_cast<std::size_t>(p.depth) * p.per_level;
+    std::size_t levels = static_cast<std::size_t>(p.depth);
+    auto bids = [&]{
+        auto f = std::make_unique<BookFixture>(config_for(p));
+        add_side(f->book, p, Side::Buy);
+        return f;
+    };
+    auto asks = [&]{
+        auto f = std::make_unique<BookFixture>(config_for(p));
+        add_side(f->book, p, Side::Sell);
+        f->fills.reserve(p.per_level);
+        return f;
+    };
+    int fresh_id = static_cast<int>(orders) + 1;
+
+    // one order at a new price between every pair of levels
+    measure(options, results, "add_limit_new_level", p, levels, orders, bids, [&](BookFixture& f){
+        for (int level = 0; level < p.depth; ++level){
+            f.book.add_limit(fresh_id + level, Side::Buy, 100000 - 2 * level - 1, 1);
+        }
+    });
+
+    // one order joining the back of every existing level
+    measure(options, results, "add_limit_existing_level", p, levels, orders, bids, [&](BookFixture& f){
+        for (int level = 0; level < p.depth; ++level){
+            f.book.add_limit(fresh_id + level, Side::Buy, 100000 - 2 * level, 1);
+        }
+    });
+
+    // every id already in the book again
+    measure(options, results, "add_limit_duplicate", p, orders, orders, bids, [&](BookFixture& f){
+        for (int id = 1; id <= static_cast<int>(orders); ++id){
+            sink += f.book.add_limit(id, Side::Buy, 100000, 1) == AddResult::Duplicate;
+        }
+    });
+
+    // one cancel per level at the front, middle or back of its queue
+    const std::pair<const char*, int> positions[] = {
+        {"cancel_front", 0}, {"cancel_middle", p.per_level / 2}, {"cancel_back", p.per_level - 1}};
+    for (const auto& [name, position] : positions){
+        measure(options, results, name, p, levels, orders, bids, [&, position = position](BookFixture& f){
+            for (int level = 0; level < p.depth; ++level){
+                f.book.cancel(order_id(p, level, position));
+            }
+        });
+    }
+
+    // each call fills every order of the best level (per_level orders) and removes it
+    measure(options, results, "consume_best_ask_level", p, levels, orders, asks, [&](BookFixture& f){
+        for (int level = 0; level < p.depth; ++level){
+            f.fills.clear();
+            f.book.consume_best_ask(p.per_level, f.fills);
+        }
+        sink += static_cast<long long>(f.fills.size());
+    });
+
+    // best 10 levels of each side into a reused snapshot
+    auto both = [&]{
+        auto f = std::make_unique<BookFixture>(config_for(p));
+        add_side(f->book, p, Side::Buy);
+        add_side(f->book, p, Side::Sell);
+        return f;
+    };
+    BookSnapshot snapshot;
+    measure(options, results, "print_book_depth_10", p, 100, 2 * orders, both, [&](BookFixture& f){
+        for (int i = 0; i < 100; ++i){
+            f.book.print_book(10, snapshot);
+            sink += static_cast<long long>(snapshot.bids.size());
+        }
+    });
+}
+
+void run_engine_cases(const Options& options, const Params& p, vector<Result>& results){
+    using Engine = BasicMatchingEngine<NullListener>;
+    std::size_t orders = static_cast<std::size_t>(p.depth) * p.per_level;
+
+    // one buy that fills every resting ask: depth levels, per_level orders each
+    auto asks = [&]{
+        auto engine = std::make_unique<Engine>(config_for(p));
+        for (int level = 0; level < p.depth; ++level){
+            for (int position = 0; position < p.per_level; ++position){
+                engine->process_new_order_view(order_id(p, level, position), Side::Sell, 100002 + 2 * level, 1);
+            }
+        }
+        return engine;
+    };
+    int sweep_id = static_cast<int>(orders) + 1;
+    measure(options, results, "engine_sweep_all_levels", p, 1, orders, asks, [&](Engine& engine){
+        NewOrderView view = engine.process_new_order_view(sweep_id, Side::Buy, 100002 + 2 * p.depth,
+                                                          static_cast<int>(orders));
+        sink += static_cast<long long>(view.trades.size());
+    });
+}
+
+void run_parser_cases(const Options& options, vector<Result>& results){
+    const vector<string> lines = {
+        "N 1234 B 10050 25", "N 1235 S 10060 3", "C 1234", "N AAPL 77 B 101 10", "P", "B 5",
+        "N 1 B x 5", "C 12abc", "N 99999999999 B 1 1", "",
+    };
+    vector<string> batch;
+    for (int i = 0; i < 100; ++i) batch.insert(batch.end(), lines.begin(), lines.end());
+    auto none = []{ return std::make_unique<int>(0); };
+    Params p;
+
+    measure(options, results, "parse_command_view", p, batch.size(), 0, none, [&](int&){
+        for (const string& line : batch) sink += parse_command_view(line).qty;
+    });
+    measure(options, results, "parse_command", p, batch.size(), 0, none, [&](int&){
+        for (const string& line : batch) sink += parse_command(line).qty;
+    });
+}
+
+double median(vector<double> values){
+    std::sort(values.begin(), values.end());
+    std::size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+void print_table(const vector<Result>& results){
+    cout << "case                       backend depth per_level       ops   min ns/op   median ns/op\n";
+    for (const Result& r : results){
+        string backend = r.params.depth ? backend_name(r.params.backend) : "-";
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-26s %-7s %5d %9d %9zu %11.1f %14.1f\n", r.name.c_str(), backend.c_str(),
+                      r.params.depth, r.params.per_level, r.ops,
+                      *std::min_element(r.ns_per_op.begin(), r.ns_per_op.end()), median(r.ns_per_op));
+        cout << line;
+    }
+}
+
+void print_json(const vector<Result>& results, const Options& options){
+    std::ostringstream out;
+    out << "{\n  \"warmup\": " << options.warmup << ",\n  \"repetitions\": " << options.reps
+        << ",\n  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i){
+        const Result& r = results[i];
+        double sum = 0;
+        for (double v : r.ns_per_op) sum += v;
+        out << (i ? "," : "") << "\n    {\"name\": \"" << r.name << "\", \"backend\": \""
+            << (r.params.depth ? backend_name(r.params.backend) : "none") << "\", \"depth\": " << r.params.depth
+            << ", \"per_level\": " << r.params.per_level << ", \"ops\": " << r.ops
+            << ", \"ns_per_op\": {\"min\": " << *std::min_element(r.ns_per_op.begin(), r.ns_per_op.end())
+            << ", \"median\": " << median(r.ns_per_op) << ", \"mean\": " << sum / r.ns_per_op.size()
+            << ", \"max\": " << *std::max_element(r.ns_per_op.begin(), r.ns_per_op.end()) << ", \"samples\": [";
+        for (std::size_t s = 0; s < r.ns_per_op.size(); ++s) out << (s ? ", " : "") << r.ns_per_op[s];
+        out << "]}}";
+    }
+    out << "\n  ]\n}\n";
+    cout << out.str();
+}
+
+// "1,10,100" -> {1, 10, 100}
+vector<int> parse_list(const string& text){
+    vector<int> values;
+    std::istringstream in(text);
+    string item;
+    while (std::getline(in, item, ',')) values.push_back(std::stoi(item));
+    return values;
+}
+
+int main(int argc, char* argv[]){
+    Options options;
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        if (arg.rfind("--depth=", 0) == 0) options.depths = parse_list(arg.substr(8));
+        else if (arg.rfind("--per-level=", 0) == 0) options.per_levels = parse_list(arg.substr(12));
+        else if (arg.rfind("--warmup=", 0) == 0) options.warmup = std::stoi(arg.substr(9));
+        else if (arg.rfind("--reps=", 0) == 0) options.reps = std::stoi(arg.substr(7));
+        else if (arg.rfind("--min-ops=", 0) == 0) options.min_ops = std::max<std::size_t>(1, std::stoul(arg.substr(10)));
+        else if (arg.rfind("--filter=", 0) == 0) options.filter = arg.substr(9);
+        else if (arg == "--json") options.json = true;
+        else {
+            cerr << "Usage: " << argv[0] << " [--depth=1,10,100] [--per-level=1,10,100] [--warmup=N]"
+                 << " [--reps=N] [--min-ops=N] [--filter=SUBSTRING] [--json]" << endl;
+            return 1;
+        }
+    }
+    if (options.reps < 1) options.reps = 1;
+    for (int value : options.depths) if (value < 1) { cerr << "depth must be positive" << endl; return 1; }
+    for (int value : options.per_levels) if (value < 1) { cerr << "per-level must be positive" << endl; return 1; }
+
+    vector<Result> results;
+    for (BookBackend backend : {BookBackend::Map, BookBackend::Ladder}){
+        for (int depth : options.depths){
+            for (int per_level : options.per_levels){
+                Params p{backend, depth, per_level};
+                run_book_cases(options, p, results);
+                run_engine_cases(options, p, results);
+            }
+        }
+    }
+    run_parser_cases(options, results);
+
+    if (options.json) print_json(results, options);
+    else print_table(results);
+    return 0;
+}
@@ -0,0 +1,169 @@
+/**
+test_batch.cpp
+--------------
+Implements unit tests for running commands in batches through process_batch
+ */
+
+#include "matching_engine.hpp"
+#include "test_listener.hpp"
+#include "common.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using std::cout;
+using std::endl;
+
+// Runtime listener writing level updates as text
+struct LevelLog : IEventListener {
+    string output;
+
+    void on_ack(int) override {}
+    void on_reject(int, RejectReason) override {}
+    void on_cancel(int, CancelResult) override {}
+    void on_amend(int, AmendResult) override {}
+    void on_trade(const Trade&) override {}
+    void on_tob(const TopOfBook&) override {}
+    void on_book(const BookSnapshot&) override {}
+    void on_level_update(const LevelUpdate& lu) override {
+        output += (lu.side == Side::Buy ? "B " : "S ") + std::to_string(lu.price) + " " + std::to_string(lu.qty) + "\n";
+    }
+    bool takes_level_updates() const override { return true; }
+};
+
+// Random mix of every command type around price 1000
+vector<Command> random_commands(std::size_t n, unsigned seed){
+    std::mt19937 rng(seed);
+    vector<Command> commands;
+    int next_id = 1;
+    for (std::size_t i = 0; i < n; ++i){
+        unsigned op = rng() % 100;
+        Command cmd{CommandType::New};
+        if (op < 55){
+            cmd.order_id = next_id++;
+            cmd.side = rng() % 2 ? Side::Buy : Side::Sell;
+            cmd.price = 990 + static_cast<int>(rng() % 21);
+            cmd.qty = 1 + static_cast<int>(rng() % 20);
+            if (rng() % 50 == 0) cmd.order_id = 1 + rng() % next_id;    // duplicate
+            if (rng() % 50 == 0) cmd.qty = 0;                           // bad
+        } else if (op < 80){
+            cmd.type = CommandType::Cancel;
+            cmd.order_id = 1 + rng() % next_id;
+        } else if (op < 92){
+            cmd.type = CommandType::Amend;
+            cmd.order_id = 1 + rng() % next_id;
+            cmd.price = 990 + static_cast<int>(rng() % 21);
+            cmd.qty = static_cast<int>(rng() % 20);
+        } else if (op < 94){
+            cmd.type = CommandType::PrintTopOfBook;
+        } else if (op < 96){
+            cmd.type = CommandType::PrintFullBook;
+            cmd.qty = static_cast<int>(rng() % 3);
+        } else if (op < 97){
+            cmd.type = CommandType::Reject;
+            cmd.order_id = next_id;
+        } else if (op < 99){
+            cmd.type = CommandType::MassCancelSide;
+            cmd.side = rng() % 2 ? Side::Buy : Side::Sell;
+            cmd.price = 990 + static_cast<int>(rng() % 21);
+            cmd.qty = cmd.price + static_cast<int>(rng() % 5);
+        } else {
+            cmd.type = CommandType::MassCancel;
+        }
+        commands.push_back(cmd);
+    }
+    return commands;
+}
+
+// Runtime-listener engine recording its text output and level updates
+struct Run {
+    MatchingEngine engine;
+    TestListener out;
+    LevelLog levels;
+
+    Run(const BookConfig& config, bool bbo_feed) : engine(config) {
+        engine.add_listener(&out);
+        engine.add_listener(&levels);
+        engine.set_bbo_feed(bbo_feed);
+    }
+
+    string book() const {
+        TestListener snapshot;
+        BookSnapshot bs = engine.order_book().print_book();
+        snapshot.on_book(bs);
+        return snapshot.get_output();
+    }
+};
+
+void test_matches_single_commands(const BookConfig& config, bool bbo_feed){
+    vector<Command> commands = random_commands(20000, 7);
+    Run single(config, bbo_feed);
+    for (const Command& cmd : commands) single.engine.process_command(cmd);
+
+    // batch sizes shorter and longer than the prefetch distances
+    for (std::size_t batch : {1, 3, 64, 1000, 20000}){
+        Run batched(config, bbo_feed);
+        for (std::size_t i = 0; i < commands.size(); i += batch){
+            std::size_t count = std::min(batch, commands.size() - i);
+            bool running = batched.engine.process_batch(CommandSpan{commands.data() + i, count});
+            CHECK(running);
+        }
+        CHECK(batched.out.get_output() == single.out.get_output());
+        CHECK(batched.levels.output == single.levels.output);
+        CHECK(batched.book() == single.book());
+    }
+
+    // compile-time listeners see the same events
+    BasicMatchingEngine<TestListener> direct(config);
+    direct.set_bbo_feed(bbo_feed);
+    bool running = direct.process_batch(commands);
+    CHECK(running);
+    CHECK(direct.listener<0>().get_output() == single.out.get_output());
+}
+
+int main(){
+    BookConfig ladder;
+    ladder.backend = BookBackend::Ladder;
+    ladder.ladder_ticks = 8;
+    test_matches_single_commands(BookConfig{}, false);
+    test_matches_single_commands(BookConfig{}, true);
+    test_matches_single_commands(ladder, false);
+    test_matches_single_commands(ladder, true);
+
+    // an empty batch does nothing
+    Run run(BookConfig{}, false);
+    bool running = run.engine.process_batch(CommandSpan{});
+    CHECK(running);
+    CHECK(run.out.get_output().empty());
+
+    // a batch stops after Exit
+    vector<Command> commands = {
+        Command{CommandType::New, 1, Side::Sell, 101, 5},
+        Command{CommandType::New, 2, Side::Buy, 101, 2},
+        Command{CommandType::Exit},
+        Command{CommandType::New, 3, Side::Buy, 101, 3},
+    };
+    running = run.engine.process_batch(commands);
+    CHECK(!running);
+    CHECK(run.out.get_output() == "ACK 1\nACK 2\nTRD 2 1 101 2\n");
+    CHECK(run.levels.output == "S 101 5\nS 101 3\n");
+    CHECK(!run.engine.order_book().has_order(3));
+
+    // the engine is still usable after a batch stopped at Exit
+    run.out.clear();
+    run.engine.cancel_order(1);
+    CHECK(run.out.get_output() == "CXL 1\n");
+
+    // an engine without listeners runs batches too
+    MatchingEngine silent;
+    running = silent.process_batch(CommandSpan{commands.data(), 2});
+    CHECK(running);
+    CHECK(silent.top_of_book().best_ask.value().qty == 3);
+
+    cout << "test_batch: PASS" << endl;
+    return 0;
+}
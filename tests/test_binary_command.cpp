@@ -0,0 +1,149 @@
+/**
+test_binary_command.cpp
+--------------
+Implements unit tests for the fixed-width binary command format
+ */
+
+#include "binary_command.hpp"
+#include "matching_engine.hpp"
+#include "parser.hpp"
+#include "test_listener.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+bool same_command(const Command& a, const Command& b){
+    return a.type == b.type && a.order_id == b.order_id && a.side == b.side && a.price == b.price
+        && a.qty == b.qty && a.reject_reason == b.reject_reason && a.symbol == b.symbol;
+}
+
+// Binary buffer holding the records of commands
+string encode_all(const vector<Command>& commands){
+    string encoded(binary_command_magic);
+    for (const Command& cmd : commands){
+        BinaryRecord rec = encode_command(cmd);
+        encoded.append(reinterpret_cast<const char*>(&rec), sizeof(rec));
+    }
+    return encoded;
+}
+
+// Output of running commands until Exit
+string replay(const vector<Command>& commands){
+    MatchingEngine engine;
+    TestListener listener;
+    engine.add_listener(&listener);
+    for (const Command& cmd : commands){
+        if (!engine.process_command(cmd)) break;
+    }
+    return listener.get_output();
+}
+
+int main(){
+    vector<string> lines = {
+        "N 1 B 100 10", "N 2 S 99 4", "C 1", "C 7", "P", "B", "B 1", "B AAPL 2", "N AAPL 3 S 101 7", "C BRK.B 3",
+        "", "N 1 B x 5", "N 4 B 100 0", "N 99999999999 B 1 1", "P extra", "N 1 B 100 1", "X", "N 9 B 1 1",
+        "A 1 100 5", "A AAPL 1 101 3", "A 1 0 5", "A 1 101",
+        "N 5 B 99 3", "N 6 S 120 2", "M B 90 99", "M AAPL", "M S", "M", "M B 5 1",
+    };
+
+    vector<Command> commands;
+    for (const string& line : lines) commands.push_back(parse_command_view(line));
+
+    // records round-trip every field, including rejects
+    string encoded = encode_all(commands);
+    CHECK(is_binary_commands(encoded));
+    CHECK(encoded.size() == binary_command_magic.size() + commands.size() * binary_record_size);
+
+    BinaryCommandReader reader(encoded);
+    vector<Command> decoded;
+    Command cmd;
+    while (reader.next(cmd)) decoded.push_back(cmd);
+    CHECK(decoded.size() == commands.size());
+    for (std::size_t i = 0; i < commands.size(); ++i){
+        CHECK(same_command(commands[i], decoded[i]));
+    }
+
+    // replaying decoded records gives the text output, rejects included
+    string text_output = replay(commands);
+    CHECK(text_output == replay(decoded));
+    CHECK(text_output.find("REJ 4 BAD") != string::npos);
+    CHECK(text_output.find("REJ 1 DUP") != string::npos);
+
+    // a truncated trailing record is ignored
+    BinaryCommandReader truncated(encoded.substr(0, encoded.size() - 5));
+    std::size_t count = 0;
+    while (truncated.next(cmd)) ++count;
+    CHECK(count == commands.size() - 1);
+
+    // corrupt records decode to a BAD reject
+    BinaryRecord corrupt = encode_command(commands[0]);
+    corrupt.type = 42;
+    cmd = decode_command(corrupt);
+    CHECK(cmd.type == CommandType::Reject);
+    CHECK(cmd.reject_reason == RejectReason::BAD);
+
+    // records with fields the text grammar rejects decode like the equivalent lines
+    struct Invalid {
+        Command cmd;
+        const char* line;
+    };
+    Command amend_zero_id{CommandType::Amend, 0};
+    amend_zero_id.price = 100;
+    amend_zero_id.qty = 5;
+    Command amend_zero_price{CommandType::Amend, 4};
+    amend_zero_price.qty = 5;
+    Command amend_zero_qty{CommandType::Amend, 4};
+    amend_zero_qty.price = 100;
+    Command deep_book{CommandType::PrintFullBook};
+    deep_book.qty = -1;
+    Command named_new{CommandType::New, 0, Side::Buy, 100, 5};
+    parse_symbol("AAPL", named_new.symbol);
+    const Invalid invalid[] = {
+        {Command{CommandType::New, 0, Side::Buy, 100, 5}, "N 0 B 100 5"},
+        {Command{CommandType::New, -3, Side::Sell, 100, 5}, "N -3 S 100 5"},
+        {Command{CommandType::New, 4, Side::Buy, 0, 5}, "N 4 B 0 5"},
+        {Command{CommandType::New, 4, Side::Buy, 100, -1}, "N 4 B 100 -1"},
+        {named_new, "N AAPL 0 B 100 5"},
+        {Command{CommandType::Cancel, 0}, "C 0"},
+        {Command{CommandType::Cancel, -2}, "C -2"},
+        {amend_zero_id, "A 0 100 5"},
+        {amend_zero_price, "A 4 0 5"},
+        {amend_zero_qty, "A 4 100 0"},
+        {Command{CommandType::MassCancelSide, 0, Side::Buy, 0, 10}, "M B 0 10"},
+        {Command{CommandType::MassCancelSide, 0, Side::Sell, 10, 5}, "M S 10 5"},
+        {deep_book, "B -1"},
+    };
+    for (const Invalid& c : invalid){
+        Command expected = parse_command_view(c.line);
+        CHECK(expected.type == CommandType::Reject);
+        CHECK(same_command(decode_command(encode_command(c.cmd)), expected));
+    }
+
+    // an id 0 order written straight to a binary file is rejected before the engine sees it
+    vector<Command> zero_id = {
+        Command{CommandType::New, 0, Side::Buy, 100, 5}, Command{CommandType::MassCancel},
+        Command{CommandType::Cancel, 0}, Command{CommandType::Exit},
+    };
+    BinaryCommandReader zero_reader(encode_all(zero_id));
+    vector<Command> zero_decoded;
+    while (zero_reader.next(cmd)) zero_decoded.push_back(cmd);
+    vector<Command> zero_text;
+    for (const char* line : {"N 0 B 100 5", "M", "C 0", "X"}) zero_text.push_back(parse_command_view(line));
+    CHECK(replay(zero_decoded) == replay(zero_text));
+    CHECK(replay(zero_decoded) == "REJ 0 BAD\nREJ 0 BAD\n");
+
+    // text input is not mistaken for binary
+    CHECK(!is_binary_commands("N 1 B 100 10\n"));
+    CHECK(!is_binary_commands(""));
+    BinaryCommandReader not_binary("N 1 B 100 10\n");
+    CHECK(!not_binary.next(cmd));
+
+    cout << "test_binary_command: PASS" << endl;
+    return 0;
+}
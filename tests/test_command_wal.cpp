@@ -0,0 +1,145 @@
+/**
+test_command_wal.cpp
+--------------
+Implements unit tests for the write-ahead command journal
+ */
+
+#include "command_wal.hpp"
+#include "mapped_file.hpp"
+#include "matching_engine.hpp"
+#include "parser.hpp"
+#include "test_listener.hpp"
+#include "check.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// Commands stored in the journal file at path
+vector<Command> read_journal(const string& path){
+    MappedFile file;
+    vector<Command> commands;
+    if (!file.open(path.c_str())) return commands;
+    BinaryCommandReader reader(file.contents());
+    Command cmd;
+    while (reader.next(cmd)) commands.push_back(cmd);
+    return commands;
+}
+
+// Output of running commands on a fresh engine
+string replay(const vector<Command>& commands){
+    MatchingEngine engine;
+    TestListener listener;
+    engine.add_listener(&listener);
+    for (const Command& cmd : commands) engine.process_command(cmd);
+    return listener.get_output();
+}
+
+long file_size(const string& path){
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return static_cast<long>(in.tellg());
+}
+
+int main(){
+    char dir[] = "/tmp/test_command_wal_XXXXXX";
+    CHECK(::mkdtemp(dir));
+    string path = string(dir) + "/commands.wal";
+
+    vector<string> lines = {"N 1 B 100 10", "N 2 S 101 5", "N AAPL 3 S 99 4", "C 2", "N 4 B x 1", "P", "C 9"};
+    vector<Command> commands;
+    for (const string& line : lines) commands.push_back(parse_command_view(line));
+
+    // a new journal gets the header, and every mode stores the same records
+    for (WalSync mode : {WalSync::None, WalSync::Group, WalSync::Always}){
+        std::remove(path.c_str());
+        {
+            CommandWal wal(mode, 3);
+            CHECK(wal.open(path.c_str()));
+            CHECK(wal.recovered_records() == 0);
+            for (const Command& cmd : commands) CHECK(wal.append(cmd));
+            if (mode == WalSync::Always) CHECK(wal.sync_count() == commands.size());
+            if (mode == WalSync::Group) CHECK(wal.sync_count() == 2);
+            if (mode == WalSync::None) CHECK(wal.sync_count() == 0);
+        }
+        vector<Command> stored = read_journal(path);
+        CHECK(stored.size() == commands.size());
+        CHECK(replay(stored) == replay(commands));
+    }
+
+    // records reach the file on commit, before the owner writes output
+    std::remove(path.c_str());
+    {
+        CommandWal wal(WalSync::Group, 1000);
+        CHECK(wal.open(path.c_str()));
+        wal.append(commands[0]);
+        CHECK(file_size(path) == static_cast<long>(binary_command_magic.size()));
+        CHECK(wal.commit());
+        CHECK(file_size(path) == static_cast<long>(binary_command_magic.size() + binary_record_size));
+        CHECK(wal.sync_count() == 1);
+        CHECK(wal.commit());
+        CHECK(wal.sync_count() == 1);
+    }
+
+    // reopening appends after the records already there
+    {
+        CommandWal wal;
+        CHECK(wal.open(path.c_str()));
+        CHECK(wal.recovered_records() == 1);
+        for (std::size_t i = 1; i < commands.size(); ++i) wal.append(commands[i]);
+    }
+    CHECK(replay(read_journal(path)) == replay(commands));
+
+    // a record torn by a crash is cut off, and appending resumes at the last whole record
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << "torn";
+    }
+    {
+        CommandWal wal;
+        CHECK(wal.open(path.c_str()));
+        CHECK(wal.recovered_records() == commands.size());
+        CHECK(file_size(path) == static_cast<long>(binary_command_magic.size() + commands.size() * binary_record_size));
+        wal.append(commands[0]);
+    }
+    vector<Command> stored = read_journal(path);
+    CHECK(stored.size() == commands.size() + 1);
+    CHECK(stored.back().order_id == 1);
+
+    // reset keeps only the header
+    {
+        CommandWal wal;
+        CHECK(wal.open(path.c_str()));
+        CHECK(wal.reset());
+        wal.append(commands[1]);
+    }
+    stored = read_journal(path);
+    CHECK(stored.size() == 1 && stored[0].order_id == 2);
+
+    // files that are not command journals are refused
+    string other = string(dir) + "/other.txt";
+    {
+        std::ofstream out(other);
+        out << "N 1 B 100 10\n";
+    }
+    {
+        CommandWal wal;
+        CHECK(!wal.open(other.c_str()));
+    }
+    {
+        CommandWal wal;
+        CHECK(!wal.open((string(dir) + "/missing/commands.wal").c_str()));
+    }
+
+    std::remove(path.c_str());
+    std::remove(other.c_str());
+    ::rmdir(dir);
+    cout << "test_command_wal: PASS" << endl;
+    return 0;
+}
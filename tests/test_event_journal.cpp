@@ -0,0 +1,138 @@
+/**
+test_event_journal.cpp
+--------------
+Implements unit tests for the binary event journal
+ */
+
+#include "event_journal.hpp"
+#include "matching_engine.hpp"
+#include "parser.hpp"
+#include "test_listener.hpp"
+#include "check.hpp"
+#include <climits>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+using std::cout;
+using std::endl;
+using std::ostringstream;
+using std::string;
+
+// Runs random orders, cancels, amends and queries through an engine with both listeners attached
+void run_random(IEventListener& a, IEventListener& b){
+    MatchingEngine engine;
+    engine.add_listener(&a);
+    engine.add_listener(&b);
+    std::mt19937 rng(3);
+    for (int i = 1; i <= 20000; ++i){
+        switch (rng() % 10){
+            case 0: engine.cancel_order(1 + rng() % i); break;
+            case 1: engine.top_of_book(); break;
+            case 2: engine.print_book(); break;
+            case 3: engine.amend_order(1 + rng() % i, 90 + rng() % 20, 1 + rng() % 50); break;
+            default:
+                engine.process_new_order(i, rng() % 2 ? Side::Buy : Side::Sell, 90 + rng() % 20, 1 + rng() % 50);
+        }
+    }
+}
+
+// Decodes a journal into text
+string decode_text(const string& journal_bytes){
+    TestListener text;
+    JournalDecoder decoder(journal_bytes);
+    while (decoder.next(text)){}
+    CHECK(!decoder.error());
+    return text.get_output();
+}
+
+int main(){
+    // engine events round-trip to the exact text output
+    {
+        ostringstream bytes;
+        OutputBuffer buffer(bytes, 1024);
+        EventJournal journal(buffer);
+        JournalListener writer(journal);
+        TestListener expected;
+        run_random(writer, expected);
+        buffer.flush();
+
+        CHECK(decode_text(bytes.str()) == expected.get_output());
+        // deltas keep records far smaller than text lines
+        CHECK(bytes.str().size() * 3 < expected.get_output().size());
+    }
+
+    // extreme values and empty queries
+    {
+        ostringstream bytes;
+        OutputBuffer buffer(bytes);
+        EventJournal journal(buffer);
+        JournalListener writer(journal);
+        TestListener expected;
+        for (IEventListener* l : {static_cast<IEventListener*>(&writer), static_cast<IEventListener*>(&expected)}){
+            l->on_ack(INT_MAX);
+            l->on_reject(0, RejectReason::BAD);
+            l->on_reject(INT_MIN, RejectReason::DUP);
+            l->on_trade(Trade{INT_MAX, 1, INT_MAX, INT_MAX});
+            l->on_trade(Trade{1, INT_MAX, 1, 1});
+            l->on_cancel(5, CancelResult::Unknown);
+            l->on_amend(INT_MAX, AmendResult::Amended);
+            l->on_amend(7, AmendResult::Unknown);
+            l->on_tob(TopOfBook{});
+            l->on_book(BookSnapshot{});
+        }
+        buffer.flush();
+        CHECK(journal.events() == 10);
+        CHECK(decode_text(bytes.str()) == expected.get_output());
+    }
+
+    // symbol records attach events to their books
+    {
+        ostringstream bytes;
+        OutputBuffer buffer(bytes);
+        EventJournal journal(buffer);
+        Symbol aapl, msft;
+        parse_symbol("AAPL", aapl);
+        parse_symbol("MSFT", msft);
+        JournalListener a(journal, aapl);
+        JournalListener m(journal, msft);
+        a.on_ack(1);
+        a.on_ack(2);
+        m.on_ack(3);
+        a.on_ack(4);
+        buffer.flush();
+
+        string data = bytes.str();
+        JournalDecoder decoder(data);
+        TestListener text;
+        string symbols;
+        while (decoder.next(text)) symbols += symbol_name(decoder.current_symbol()) + ",";
+        CHECK(symbols == "AAPL,AAPL,MSFT,AAPL,");
+        CHECK(text.get_output() == "ACK 1\nACK 2\nACK 3\nACK 4\n");
+    }
+
+    // truncated and foreign input is reported, not misread
+    {
+        ostringstream bytes;
+        OutputBuffer buffer(bytes);
+        EventJournal journal(buffer);
+        journal.trade(Trade{1000, 2000, 300000, 400});
+        buffer.flush();
+        string data = bytes.str();
+
+        TestListener text;
+        string cut = data.substr(0, data.size() - 1);
+        JournalDecoder truncated(cut);
+        CHECK(!truncated.next(text));
+        CHECK(truncated.error());
+
+        JournalDecoder foreign("ACK 1\n");
+        CHECK(!foreign.next(text));
+        CHECK(foreign.error());
+        CHECK(text.get_output().empty());
+    }
+
+    cout << "test_event_journal: PASS" << endl;
+    return 0;
+}
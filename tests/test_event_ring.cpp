@@ -0,0 +1,137 @@
+/**
+test_event_ring.cpp
+--------------
+Implements unit tests for spsc_ring.hpp and the event ring output mode
+ */
+
+#include "event_ring.hpp"
+#include "matching_engine.hpp"
+#include "parser.hpp"
+#include "test_listener.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// push/pop order, full and empty rings
+void test_spsc_ring(){
+    SpscRing<int> ring(3);
+    CHECK(ring.capacity() == 4);
+    CHECK(ring.empty());
+
+    for (int i = 0; i < 4; ++i){
+        bool pushed = ring.try_push(i);
+        CHECK(pushed);
+    }
+    bool pushed = ring.try_push(99);
+    CHECK(!pushed);
+    CHECK(ring.size() == 4);
+
+    int out = -1;
+    bool popped = ring.try_pop(out);
+    CHECK(popped && out == 0);
+    pushed = ring.try_push(4);
+    CHECK(pushed);
+
+    vector<int> seen;
+    std::size_t n = ring.consume([&](int v){ seen.push_back(v); }, 2);
+    CHECK(n == 2);
+    n = ring.consume([&](int v){ seen.push_back(v); });
+    CHECK(n == 2);
+    CHECK((seen == vector<int>{1, 2, 3, 4}));
+    popped = ring.try_pop(out);
+    CHECK(!popped);
+}
+
+// one producer and one consumer thread see every item exactly once, in order
+void test_spsc_ring_threads(){
+    SpscRing<long long> ring(64);
+    const long long count = 200000;
+    long long sum = 0;
+    long long expected_next = 0;
+    bool in_order = true;
+
+    std::thread consumer([&]{
+        long long received = 0;
+        while (received < count){
+            received += ring.consume([&](long long v){
+                in_order = in_order && v == expected_next;
+                ++expected_next;
+                sum += v;
+            });
+        }
+    });
+    for (long long i = 0; i < count; ++i){
+        while (!ring.try_push(i)) std::this_thread::yield();
+    }
+    consumer.join();
+    CHECK(in_order);
+    CHECK(sum == count * (count - 1) / 2);
+}
+
+// ring output replayed into a TestListener matches direct dispatch, including
+// book snapshots split across drains and a ring that fills up mid-command
+void test_ring_replay(){
+    string input =
+        "N 1 B 100 10\nN 2 B 101 5\nN 3 S 103 7\nN 4 S 104 2\nP\nB\n"
+        "N 5 S 100 12\nN 5 B 99 1\nC 3\nC 42\nN 6 B 0 1\nbad line\nB\nP\n"
+        "A 1 100 4\nA 4 102 2\nA 2 104 9\nA 77 1 1\nA 1 0 1\nB\nP\n"
+        "N 7 B 98 1\nN 8 B 97 2\nN 9 S 110 3\nM B 1 98\nM S 200 300\nB\nM\nP\n";
+
+    MatchingEngine direct;
+    TestListener expected;
+    direct.add_listener(&expected);
+
+    EventRing ring(4);
+    EventReplayer replayer;
+    TestListener actual;
+    BasicMatchingEngine<EventRingWriter> ringed(BookConfig{}, EventRingWriter{&ring, [&]{
+        replayer.drain(ring, actual, 1);
+    }});
+
+    for (const Command& cmd : parse_commands(input)){
+        direct.process_command(cmd);
+        ringed.process_command(cmd);
+    }
+    replayer.drain(ring, actual);
+    CHECK(ring.empty());
+    CHECK(actual.get_output() == expected.get_output());
+}
+
+// records of books past the 16-bit range reach their own target
+void test_many_books(){
+    const std::size_t books = 70000;
+    vector<TestListener> listeners(books);
+    EventTargets targets;
+    for (TestListener& l : listeners) CHECK(targets.push_back(&l));
+    CHECK(targets.size() == books);
+
+    EventRing ring(8);
+    EventReplayer replayer;
+    for (std::uint32_t book : {0u, 65535u, 65536u, 69999u}){
+        EventRingWriter writer{&ring, []{}, book};
+        writer.on_ack(static_cast<int>(book) + 1);
+        replayer.drain(ring, targets);
+    }
+    CHECK(listeners[0].get_output() == "ACK 1\n");
+    CHECK(listeners[65535].get_output() == "ACK 65536\n");
+    CHECK(listeners[65536].get_output() == "ACK 65537\n");
+    CHECK(listeners[69999].get_output() == "ACK 70000\n");
+    CHECK(listeners[4463].get_output().empty());
+}
+
+int main(){
+    test_spsc_ring();
+    test_spsc_ring_threads();
+    test_ring_replay();
+    test_many_books();
+
+    cout << "test_event_ring: PASS" << endl;
+    return 0;
+}
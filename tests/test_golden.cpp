@@ -8,10 +8,10 @@ Implements golden tests for order matching functionality
 #include <fstream>
 #include <sstream>
 #include <string>
-#include <cassert>
 #include "matching_engine.hpp"
 #include "test_listener.hpp" 
 #include "parser.hpp"
+#include "check.hpp"
 
 using std::string;
 using std::ifstream;
@@ -52,14 +52,14 @@ void run_test(const string& input_file, const string& expected_file) {
     string input = read_file(input_file);
     if (input.empty()) {
         cerr << "Failed to read input file: " << input_file << endl;
-        assert(false);
+        CHECK(false);
     }
     
     // output file
     string expected = read_file(expected_file);
     if (expected.empty()) {
         cerr << "Failed to read expected file: " << expected_file << endl;
-        assert(false);
+        CHECK(false);
     }
     
     // Setup engine with string listener
@@ -84,6 +84,15 @@ void run_test(const string& input_file, const string& expected_file) {
             case CommandType::Cancel:
                 engine.cancel_order(cmd.order_id);
                 break;
+            case CommandType::Amend:
+                engine.amend_order(cmd.order_id, cmd.price, cmd.qty);
+                break;
+            case CommandType::MassCancel:
+                engine.mass_cancel();
+                break;
+            case CommandType::MassCancelSide:
+                engine.mass_cancel(cmd.side, cmd.price, cmd.qty);
+                break;
             case CommandType::PrintTopOfBook:
                 engine.top_of_book();
                 break;
@@ -99,7 +108,7 @@ void run_test(const string& input_file, const string& expected_file) {
     
     // Compare outputs
     string actual = listener.get_output();
-    assert(compare_outputs(actual, expected));
+    CHECK(compare_outputs(actual, expected));
 }
 
 int main(int argc, char* argv[]) {
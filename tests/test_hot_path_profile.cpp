@@ -0,0 +1,104 @@
+/**
+test_hot_path_profile.cpp
+--------------
+Implements simple unit tests for hot_path_profile.hpp
+ */
+
+#include "hot_path_profile.hpp"
+#include "basic_matching_engine.hpp"
+#include "check.hpp"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using std::cout;
+using std::endl;
+
+int main(){
+
+    // the TSC moves forward and its calibration agrees with steady_clock
+    double ns_per_tick = TscClock::ns_per_tick();
+    CHECK(ns_per_tick > 0);
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t first = TscClock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::uint64_t last = TscClock::now();
+    double measured_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    CHECK(last > first);
+    double tsc_ns = (last - first) * ns_per_tick;
+    CHECK(tsc_ns > measured_ns * 0.5 && tsc_ns < measured_ns * 1.5);
+
+    // laps charge each stage once per command, summing repeated stages
+    HotPathProfile& local = HotPathProfile::local();
+    std::uint64_t commands_before = local.command_ticks().count();
+    std::uint64_t dispatch_before = local.stage(ProfileStage::Dispatch).count();
+    std::uint64_t cancel_before = local.stage(ProfileStage::Cancel).count();
+    {
+        StageLaps laps;
+        laps.lap(ProfileStage::Validate);
+        laps.lap(ProfileStage::Dispatch);
+        laps.lap(ProfileStage::Match);
+        laps.lap(ProfileStage::Dispatch);
+    }
+    CHECK(local.command_ticks().count() == commands_before + 1);
+    CHECK(local.stage(ProfileStage::Dispatch).count() == dispatch_before + 1);
+    CHECK(local.stage(ProfileStage::Cancel).count() == cancel_before);
+
+    // profiles of other threads merge
+    HotPathProfile a, b;
+    a.record(ProfileStage::Match, 100);
+    a.record_command(150);
+    std::thread worker([&b]{
+        b.record(ProfileStage::Match, 300);
+        b.record(ProfileStage::Rest, 50);
+        b.record_command(400);
+    });
+    worker.join();
+    a.merge(b);
+    CHECK(a.stage(ProfileStage::Match).count() == 2);
+    CHECK(a.stage(ProfileStage::Match).max() == 300);
+    CHECK(a.stage(ProfileStage::Rest).count() == 1);
+    CHECK(a.command_ticks().count() == 2);
+
+    // report lists only the stages that ran, with their share of stage time
+    std::ostringstream os;
+    a.report(os, 1.0);
+    std::string text = os.str();
+    CHECK(text.find("2 commands") != std::string::npos);
+    CHECK(text.find("stage match: 2 commands") != std::string::npos);
+    CHECK(text.find("stage rest: 1 commands") != std::string::npos);
+    CHECK(text.find("stage cancel") == std::string::npos);
+    CHECK(text.find("88.8889% of stage time") != std::string::npos);
+
+    // the engine is only instrumented when the build defines EXCHANGE_PROFILE
+    BasicMatchingEngine<NullListener> engine;
+    commands_before = local.command_ticks().count();
+    std::uint64_t match_before = local.stage(ProfileStage::Match).count();
+    std::uint64_t rest_before = local.stage(ProfileStage::Rest).count();
+    cancel_before = local.stage(ProfileStage::Cancel).count();
+    std::uint64_t amend_before = local.stage(ProfileStage::Amend).count();
+    engine.process_new_order(1, Side::Sell, 100, 10);
+    engine.process_new_order(2, Side::Buy, 100, 4);
+    engine.process_new_order(1, Side::Sell, 100, 10);   // duplicate, stops at validation
+    engine.cancel_order(1);
+    engine.process_new_order(3, Side::Buy, 90, 5);
+    engine.amend_order(3, 90, 2);
+#ifdef EXCHANGE_PROFILE
+    CHECK(local.command_ticks().count() == commands_before + 6);
+    CHECK(local.stage(ProfileStage::Match).count() == match_before + 3);
+    CHECK(local.stage(ProfileStage::Rest).count() == rest_before + 2);
+    CHECK(local.stage(ProfileStage::Cancel).count() == cancel_before + 1);
+    CHECK(local.stage(ProfileStage::Amend).count() == amend_before + 1);
+#else
+    CHECK(local.command_ticks().count() == commands_before);
+    CHECK(local.stage(ProfileStage::Match).count() == match_before);
+    CHECK(local.stage(ProfileStage::Rest).count() == rest_before);
+    CHECK(local.stage(ProfileStage::Cancel).count() == cancel_before);
+    CHECK(local.stage(ProfileStage::Amend).count() == amend_before);
+#endif
+
+    cout << "test_hot_path_profile: PASS" << endl;
+    return 0;
+}
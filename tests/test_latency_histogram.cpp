@@ -0,0 +1,119 @@
+/**
+test_latency_histogram.cpp
+--------------
+Implements simple unit tests for latency_histogram.hpp
+ */
+
+#include "latency_histogram.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using std::cout;
+using std::endl;
+
+// Exact percentile of sorted samples, using the same rank rule as LatencyHistogram
+static std::uint64_t exact_percentile(const std::vector<std::uint64_t>& sorted, double percent){
+    std::uint64_t rank = static_cast<std::uint64_t>(percent / 100.0 * sorted.size() + 0.5);
+    rank = std::clamp<std::uint64_t>(rank, 1, sorted.size());
+    return sorted[rank - 1];
+}
+
+// True when reported is within the histogram's precision of exact, never below it
+static bool close_enough(std::uint64_t reported, std::uint64_t exact){
+    return reported >= exact && reported - exact <= exact / LatencyHistogram::sub_bucket_half;
+}
+
+int main(){
+
+    // empty histogram
+    LatencyHistogram empty;
+    CHECK(empty.empty());
+    CHECK(empty.count() == 0);
+    CHECK(empty.percentile(99) == 0);
+    CHECK(empty.max() == 0 && empty.min() == 0);
+    CHECK(empty.mean() == 0.0);
+
+    // bucket boundaries: small values exact, every bucket contiguous with the next
+    for (std::uint64_t v = 0; v < LatencyHistogram::sub_bucket_count; ++v){
+        CHECK(LatencyHistogram::index_of(v) == v);
+    }
+    for (std::size_t i = 0; i + 1 < LatencyHistogram::bucket_count; ++i){
+        CHECK(LatencyHistogram::lowest_of(i) <= LatencyHistogram::highest_of(i));
+        CHECK(LatencyHistogram::highest_of(i) + 1 == LatencyHistogram::lowest_of(i + 1));
+        CHECK(LatencyHistogram::index_of(LatencyHistogram::lowest_of(i)) == i);
+        CHECK(LatencyHistogram::index_of(LatencyHistogram::highest_of(i)) == i);
+    }
+    CHECK(LatencyHistogram::index_of(UINT64_MAX) == LatencyHistogram::bucket_count - 1);
+    CHECK(LatencyHistogram::highest_of(LatencyHistogram::bucket_count - 1) == UINT64_MAX);
+
+    // a few values, exact below 256
+    LatencyHistogram small;
+    for (std::uint64_t v : {5, 1, 3, 2, 4}) small.record(v);
+    CHECK(small.count() == 5);
+    CHECK(small.min() == 1 && small.max() == 5);
+    CHECK(small.mean() == 3.0);
+    CHECK(small.percentile(50) == 3);
+    CHECK(small.percentile(100) == 5);
+    CHECK(small.percentile(0.001) == 1);
+
+    // large values are reported within 1/128, capped at the maximum
+    LatencyHistogram large;
+    large.record(1000000);
+    CHECK(large.percentile(50) == 1000000);
+    large.record(1000001);
+    CHECK(close_enough(large.percentile(50), 1000000));
+
+    // random long-tailed samples against exact sorted percentiles
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> dist(6.0, 1.5);
+    std::vector<std::uint64_t> samples;
+    LatencyHistogram random;
+    for (int i = 0; i < 200000; ++i){
+        std::uint64_t v = static_cast<std::uint64_t>(dist(rng));
+        samples.push_back(v);
+        random.record(v);
+    }
+    std::sort(samples.begin(), samples.end());
+    for (double p : {1.0, 50.0, 90.0, 99.0, 99.9, 99.99, 100.0}){
+        CHECK(close_enough(random.percentile(p), exact_percentile(samples, p)));
+    }
+    CHECK(random.max() == samples.back());
+    CHECK(random.min() == samples.front());
+
+    // per-thread histograms merged afterwards match one histogram of every sample
+    const int threads = 4;
+    std::vector<LatencyHistogram> parts(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t){
+        workers.emplace_back([&parts, &samples, t]{
+            for (std::size_t i = t; i < samples.size(); i += threads) parts[t].record(samples[i]);
+        });
+    }
+    for (auto& w : workers) w.join();
+    LatencyHistogram merged;
+    for (const auto& part : parts) merged.merge(part);
+    CHECK(merged.count() == random.count());
+    CHECK(merged.min() == random.min() && merged.max() == random.max());
+    CHECK(merged.mean() == random.mean());
+    for (double p : {50.0, 90.0, 99.0, 99.9, 99.99}){
+        CHECK(merged.percentile(p) == random.percentile(p));
+    }
+
+    // merging an empty histogram changes nothing
+    merged.merge(LatencyHistogram());
+    CHECK(merged.count() == random.count() && merged.min() == random.min());
+
+    // reset empties the histogram for reuse
+    merged.reset();
+    CHECK(merged.empty() && merged.percentile(50) == 0 && merged.max() == 0);
+    merged.record(7);
+    CHECK(merged.min() == 7 && merged.percentile(50) == 7);
+
+    cout << "test_latency_histogram: PASS" << endl;
+    return 0;
+}
@@ -0,0 +1,193 @@
+/**
+test_level_updates.cpp
+--------------
+Implements unit tests for incremental per-level book updates
+ */
+
+#include "matching_engine.hpp"
+#include "common.hpp"
+#include "test_listener.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+// Depth rebuilt from level updates alone
+struct DepthBuilder {
+    std::map<int, int> bids;
+    std::map<int, int> asks;
+    vector<LevelUpdate> updates;
+
+    void apply(const LevelUpdate& lu) {
+        std::map<int, int>& levels = lu.side == Side::Buy ? bids : asks;
+        if (lu.qty == 0) levels.erase(lu.price);
+        else levels[lu.price] = lu.qty;
+        updates.push_back(lu);
+    }
+
+    // True if the rebuilt depth equals the engine's full book
+    bool matches(const BookSnapshot& bs) const {
+        if (bs.bids.size() != bids.size() || bs.asks.size() != asks.size()) return false;
+        auto bid = bids.rbegin();
+        for (const PriceLevel& pl : bs.bids){
+            if (pl.price != bid->first || pl.qty != bid->second) return false;
+            ++bid;
+        }
+        auto ask = asks.begin();
+        for (const PriceLevel& pl : bs.asks){
+            if (pl.price != ask->first || pl.qty != ask->second) return false;
+            ++ask;
+        }
+        return true;
+    }
+};
+
+// Compile-time listener feeding a DepthBuilder
+struct DepthListener {
+    DepthBuilder* depth;
+
+    void on_ack(int) {}
+    void on_reject(int, RejectReason) {}
+    void on_cancel(int, CancelResult) {}
+    void on_amend(int, AmendResult) {}
+    void on_trade(const Trade&) {}
+    void on_tob(const TopOfBook&) {}
+    void on_book(const BookSnapshot&) {}
+    void on_level_update(const LevelUpdate& lu) { depth->apply(lu); }
+};
+
+// Runtime listener feeding a DepthBuilder
+struct DepthEventListener : IEventListener {
+    DepthBuilder depth;
+
+    void on_ack(int) override {}
+    void on_reject(int, RejectReason) override {}
+    void on_cancel(int, CancelResult) override {}
+    void on_amend(int, AmendResult) override {}
+    void on_trade(const Trade&) override {}
+    void on_tob(const TopOfBook&) override {}
+    void on_book(const BookSnapshot&) override {}
+    void on_level_update(const LevelUpdate& lu) override { depth.apply(lu); }
+    bool takes_level_updates() const override { return true; }
+};
+
+bool same(const LevelUpdate& lu, Side side, int price, int qty){
+    return lu.side == side && lu.price == price && lu.qty == qty;
+}
+
+// Random orders, cancels, amends and mass cancels around a drifting mid; the depth must match print_book() throughout
+void check_random(const BookConfig& config, unsigned seed){
+    DepthBuilder depth;
+    BasicMatchingEngine<DepthListener> engine(config, DepthListener{&depth});
+    std::mt19937 rng(seed);
+    int mid = 1000;
+    int next_id = 1;
+    std::vector<int> prices(1);   // last price of each id
+    for (int i = 0; i < 200000; ++i){
+        if (rng() % 100 == 0) mid += static_cast<int>(rng() % 21) - 10;
+        unsigned op = rng() % 6;
+        if (op < 2 && next_id > 1){
+            engine.cancel_order(1 + static_cast<int>(rng() % next_id));
+        }
+        else if (op == 2 && next_id > 1){
+            // half keep the price (cuts keep priority), half move it, some across the spread
+            int id = 1 + static_cast<int>(rng() % (next_id - 1));
+            int price = rng() % 2 ? prices[id] : mid + static_cast<int>(rng() % 40) - 20;
+            if (engine.amend_order(id, price, 1 + static_cast<int>(rng() % 50)) == AmendResult::Amended){
+                prices[id] = price;
+            }
+        }
+        else if (op == 3 && rng() % 256 == 0){
+            // now and then clear a band of one side, sometimes through the touch
+            int low = mid + static_cast<int>(rng() % 40) - 20;
+            engine.mass_cancel(rng() % 2 ? Side::Buy : Side::Sell, low, low + static_cast<int>(rng() % 10));
+        }
+        else {
+            Side side = rng() % 2 ? Side::Buy : Side::Sell;
+            int offset = static_cast<int>(rng() % 40) - 15;
+            int price = side == Side::Buy ? mid - offset : mid + offset;
+            prices.push_back(price);
+            engine.process_new_order_view(next_id++, side, price, 1 + static_cast<int>(rng() % 50));
+        }
+        if (i % 997 == 0) CHECK(depth.matches(engine.order_book().print_book()));
+    }
+    CHECK(depth.matches(engine.order_book().print_book()));
+}
+
+int main(){
+    static_assert(!wants_level_updates<NullListener>::value, "NullListener must not enable level tracking");
+    static_assert(wants_level_updates<DepthListener>::value, "on_level_update must be detected");
+
+    DepthBuilder depth;
+    BasicMatchingEngine<DepthListener> eng(BookConfig{}, DepthListener{&depth});
+
+    // a resting order reports its level's new total
+    eng.process_new_order(1, Side::Sell, 101, 5);
+    eng.process_new_order(2, Side::Sell, 101, 3);
+    eng.process_new_order(3, Side::Sell, 102, 4);
+    CHECK(depth.updates.size() == 3);
+    CHECK(same(depth.updates[1], Side::Sell, 101, 8));
+    CHECK(same(depth.updates[2], Side::Sell, 102, 4));
+
+    // rejects and unknown cancels change nothing
+    depth.updates.clear();
+    eng.process_new_order(1, Side::Buy, 100, 1);
+    eng.process_new_order(4, Side::Buy, 0, 1);
+    eng.cancel_order(99);
+    CHECK(depth.updates.empty());
+
+    // a sweep reports each level it touched, emptied levels with qty 0
+    eng.process_new_order(5, Side::Buy, 102, 10);
+    CHECK(depth.updates.size() == 2);
+    CHECK(same(depth.updates[0], Side::Sell, 101, 0));
+    CHECK(same(depth.updates[1], Side::Sell, 102, 2));
+    CHECK(depth.matches(eng.order_book().print_book()));
+
+    // the rest of an order that crossed is reported after the levels it consumed
+    depth.updates.clear();
+    eng.process_new_order(6, Side::Buy, 103, 5);
+    CHECK(depth.updates.size() == 2);
+    CHECK(same(depth.updates[0], Side::Sell, 102, 0));
+    CHECK(same(depth.updates[1], Side::Buy, 103, 3));
+
+    // cancels report the level's remaining quantity
+    depth.updates.clear();
+    eng.process_new_order(7, Side::Buy, 103, 4);
+    eng.cancel_order(6);
+    CHECK(depth.updates.size() == 2);
+    CHECK(same(depth.updates[1], Side::Buy, 103, 4));
+    eng.cancel_order(7);
+    CHECK(same(depth.updates.back(), Side::Buy, 103, 0));
+    CHECK(depth.matches(eng.order_book().print_book()));
+
+    // runtime listeners receive the same updates through IEventListener, and the
+    // runtime engine only collects them once such a listener is added
+    MatchingEngine runtime;
+    TestListener text;
+    runtime.add_listener(&text);
+    CHECK(!runtime.listener<0>().takes_level_updates());
+    DepthEventListener listener;
+    runtime.add_listener(&listener);
+    CHECK(runtime.listener<0>().takes_level_updates());
+    runtime.process_new_order(1, Side::Buy, 100, 5);
+    runtime.process_new_order(2, Side::Buy, 100, 5);
+    runtime.process_new_order(3, Side::Sell, 100, 7);
+    CHECK(listener.depth.updates.size() == 3);
+    CHECK(same(listener.depth.updates[2], Side::Buy, 100, 3));
+    CHECK(listener.depth.matches(runtime.print_book()));
+
+    BookConfig map_config;
+    BookConfig ladder_config;
+    ladder_config.backend = BookBackend::Ladder;
+    ladder_config.ladder_ticks = 64;   // small, so the random walk forces recentring
+    check_random(map_config, 1);
+    check_random(ladder_config, 2);
+
+    cout << "test_level_updates: PASS" << endl;
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+test_mapped_file.cpp
+--------------
+Implements unit tests for memory-mapped and stream line readers
+ */
+
+#include "mapped_file.hpp"
+#include "check.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::string_view;
+using std::vector;
+
+template <typename Reader>
+vector<string> read_lines(Reader& reader){
+    vector<string> lines;
+    string_view line;
+    while (reader.next(line)) lines.emplace_back(line);
+    return lines;
+}
+
+// Both readers split text exactly like getline
+void check_same_lines(const string& text){
+    std::istringstream stream(text);
+    StreamLineReader stream_reader(stream);
+    MappedLineReader mapped_reader(text);
+    CHECK(read_lines(stream_reader) == read_lines(mapped_reader));
+}
+
+int main(){
+    check_same_lines("");
+    check_same_lines("\n");
+    check_same_lines("\n\n\n");
+    check_same_lines("N 1 B 100 10\nP\nX\n");
+    check_same_lines("N 1 B 100 10\nP");
+    check_same_lines("N 1 B 100 10\r\n\nC 1\r\n");
+
+    // mapping a file yields its contents
+    string path = "test_mapped_file.tmp";
+    string text = "N 1 B 100 10\nC 1\nP";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << text;
+    }
+    {
+        MappedFile file;
+        CHECK(file.open(path.c_str()));
+        CHECK(file.size() == text.size());
+        CHECK(file.contents() == text);
+        MappedLineReader reader(file.contents());
+        vector<string> lines = read_lines(reader);
+        CHECK(lines.size() == 3);
+        CHECK(lines[2] == "P");
+    }
+
+    // empty files map to an empty input
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    }
+    {
+        MappedFile file;
+        CHECK(file.open(path.c_str()));
+        CHECK(file.size() == 0);
+        CHECK(file.contents().empty());
+    }
+    CHECK(is_regular_file(path.c_str()));
+    std::remove(path.c_str());
+
+    // pipes, devices and directories cannot be mapped
+    CHECK(!is_regular_file("/dev/null"));
+    CHECK(!is_regular_file("."));
+    CHECK(!is_regular_file("does_not_exist.txt"));
+    MappedFile device;
+    CHECK(!device.open("/dev/null"));
+
+    MappedFile missing;
+    CHECK(!missing.open("does_not_exist.txt"));
+
+    cout << "test_mapped_file: PASS" << endl;
+    return 0;
+}
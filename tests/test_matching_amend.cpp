@@ -0,0 +1,99 @@
+/**
+test_matching_amend.cpp
+--------------
+Implements unit tests for amending resting orders through the engine
+ */
+
+#include "matching_engine.hpp"
+#include "test_listener.hpp"
+#include "common.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <string>
+
+using std::string;
+using std::cout;
+using std::endl;
+
+int main(){
+    MatchingEngine eng;
+    TestListener out;
+    eng.add_listener(&out);
+    TopOfBook tob;
+
+    eng.process_new_order(1, Side::Buy, 100, 5);
+    eng.process_new_order(2, Side::Buy, 100, 6);
+    eng.process_new_order(3, Side::Sell, 103, 4);
+    eng.process_new_order(4, Side::Sell, 104, 9);
+    out.clear();
+
+    // a cut keeps time priority: order 1 still fills first
+    CHECK(eng.amend_order(1, 100, 2) == AmendResult::Amended);
+    CHECK(out.get_output() == "AMD 1\n");
+    tob = eng.top_of_book();
+    CHECK(tob.best_bid.value().price == 100);
+    CHECK(tob.best_bid.value().qty == 8);
+
+    // more quantity goes to the back of the queue
+    CHECK(eng.amend_order(1, 100, 7) == AmendResult::Amended);
+    out.clear();
+    eng.process_new_order(5, Side::Sell, 100, 6);
+    CHECK(out.get_output() == "ACK 5\nTRD 2 5 100 6\n");
+
+    // unknown and filled ids are rejected, the book is untouched
+    out.clear();
+    CHECK(eng.amend_order(2, 100, 1) == AmendResult::Unknown);
+    CHECK(eng.amend_order(99, 100, 1) == AmendResult::Unknown);
+    CHECK(out.get_output() == "REJ 2 UNK\nREJ 99 UNK\n");
+
+    // non-positive price or quantity is a bad request
+    out.clear();
+    CHECK(eng.amend_order(1, 0, 3) == AmendResult::Unknown);
+    CHECK(eng.amend_order(1, 100, 0) == AmendResult::Unknown);
+    CHECK(out.get_output() == "REJ 1 BAD\nREJ 1 BAD\n");
+    CHECK(eng.top_of_book().best_bid.value().qty == 7);
+
+    // a re-price through the spread trades at the resting prices, the rest rests
+    out.clear();
+    CHECK(eng.amend_order(1, 104, 15) == AmendResult::Amended);
+    CHECK(out.get_output() == "AMD 1\nTRD 1 3 103 4\nTRD 1 4 104 9\n");
+    tob = eng.top_of_book();
+    CHECK(!tob.best_ask.has_value());
+    CHECK(tob.best_bid.value().price == 104);
+    CHECK(tob.best_bid.value().qty == 2);
+
+    // a sell amended into the bids, filled completely, leaves nothing resting
+    eng.process_new_order(6, Side::Sell, 110, 1);
+    out.clear();
+    CHECK(eng.amend_order(6, 104, 1) == AmendResult::Amended);
+    CHECK(out.get_output() == "AMD 6\nTRD 1 6 104 1\n");
+    CHECK(!eng.top_of_book().best_ask.has_value());
+    CHECK(eng.amend_order(6, 110, 1) == AmendResult::Unknown);
+    CHECK(eng.cancel_order(1) == CancelResult::Cancelled);
+
+    // in BBO feed mode an amend publishes the touch only when it changes
+    eng.process_new_order(7, Side::Buy, 90, 5);
+    eng.process_new_order(8, Side::Buy, 89, 5);
+    eng.set_bbo_feed(true);
+    out.clear();
+    eng.amend_order(8, 88, 5);
+    CHECK(out.get_output() == "AMD 8\n");
+    out.clear();
+    eng.amend_order(7, 90, 3);
+    CHECK(out.get_output().find("TOB") != string::npos);
+
+    // the text command carries the same semantics
+    MatchingEngine text;
+    TestListener text_out;
+    text.add_listener(&text_out);
+    text.process_command(Command{CommandType::New, 1, Side::Sell, 101, 4});
+    Command amend{CommandType::Amend, 1};
+    amend.price = 99;
+    amend.qty = 2;
+    text.process_command(amend);
+    CHECK(text_out.get_output() == "ACK 1\nAMD 1\n");
+    CHECK(text.top_of_book().best_ask.value().price == 99);
+
+    cout << "test_matching_amend: PASS" << endl;
+    return 0;
+}
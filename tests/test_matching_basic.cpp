@@ -6,7 +6,7 @@ Implements basic unit tests for order matching functionality
 
 #include "matching_engine.hpp"
 #include "common.hpp"
-#include <cassert>
+#include "check.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -16,7 +16,33 @@ using std::cout;
 using std::endl;
 using std::vector;
 
+// Compile-time listener that counts the events it receives
+struct CountingListener : NullListener {
+    int acks = 0;
+    int trades = 0;
+    int cancels = 0;
+    void on_ack(int) { ++acks; }
+    void on_trade(const Trade&) { ++trades; }
+    void on_cancel(int, CancelResult) { ++cancels; }
+    void on_amend(int, AmendResult) {}
+};
+
+// every listener in the pack sees every event
+void test_compile_time_listeners(){
+    BasicMatchingEngine<CountingListener, CountingListener, NullListener> eng;
+    eng.process_new_order(1, Side::Buy, 100, 5);
+    eng.process_new_order(2, Side::Sell, 100, 3);
+    eng.cancel_order(1);
+    for (CountingListener* l : {&eng.listener<0>(), &eng.listener<1>()}){
+        CHECK(l->acks == 2);
+        CHECK(l->trades == 1);
+        CHECK(l->cancels == 1);
+    }
+}
+
 int main(){
+    test_compile_time_listeners();
+
     MatchingEngine eng;
     NewOrderResponse res;
     vector<Trade> trades;
@@ -24,34 +50,34 @@ int main(){
 
     // Test adding resting orders
     res =  eng.process_new_order(1, Side::Buy, 104, 10);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
-    assert(trades.size() == 0);
+    CHECK(trades.size() == 0);
     res = eng.process_new_order(2, Side::Sell, 105, 6);
     trades = res.trades;
-    assert(trades.size() == 0);
+    CHECK(trades.size() == 0);
     tob = eng.top_of_book();
-    assert(tob.best_ask.has_value());
-    assert(tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_bid.has_value());
 
     // test invalid orders
     res =  eng.process_new_order(1, Side::Sell, 104, 10);
-    assert(res.accepted == false);
-    assert(res.reject_reason.has_value());
-    assert(res.reject_reason.value() == RejectReason::DUP);
-    assert(res.trades.size() == 0);
+    CHECK(res.accepted == false);
+    CHECK(res.reject_reason.has_value());
+    CHECK(res.reject_reason.value() == RejectReason::DUP);
+    CHECK(res.trades.size() == 0);
 
     res =  eng.process_new_order(3, Side::Sell, 0, 10);
-    assert(res.accepted == false);
-    assert(res.reject_reason.has_value());
-    assert(res.reject_reason.value() == RejectReason::BAD);
-    assert(res.trades.size() == 0);
+    CHECK(res.accepted == false);
+    CHECK(res.reject_reason.has_value());
+    CHECK(res.reject_reason.value() == RejectReason::BAD);
+    CHECK(res.trades.size() == 0);
 
     res =  eng.process_new_order(4, Side::Sell, 104, 0);
-    assert(res.accepted == false);
-    assert(res.reject_reason.has_value());
-    assert(res.reject_reason.value() == RejectReason::BAD);
-    assert(res.trades.size() == 0);
+    CHECK(res.accepted == false);
+    CHECK(res.reject_reason.has_value());
+    CHECK(res.reject_reason.value() == RejectReason::BAD);
+    CHECK(res.trades.size() == 0);
 
     // Buys:
     // 1: 104 @ 10
@@ -60,18 +86,18 @@ int main(){
 
     // Single fill (full fill incoming/resting)
     res = eng.process_new_order(3, Side::Buy, 110, 6);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 3);
-    assert(trades[0].sell_id == 2);
-    assert(trades[0].price == 105);
-    assert(trades[0].qty == 6);
-    assert(tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
-    assert(tob.best_bid.value().price == 104);
-    assert(tob.best_bid.value().qty == 10);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 3);
+    CHECK(trades[0].sell_id == 2);
+    CHECK(trades[0].price == 105);
+    CHECK(trades[0].qty == 6);
+    CHECK(tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+    CHECK(tob.best_bid.value().price == 104);
+    CHECK(tob.best_bid.value().qty == 10);
 
     // Buys:
     // 1: 104 @ 10
@@ -80,18 +106,18 @@ int main(){
 
     // Partial fill of incoming, remainder rests
     res = eng.process_new_order(4, Side::Sell, 103, 14);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 1);
-    assert(trades[0].sell_id == 4);
-    assert(trades[0].price == 104);
-    assert(trades[0].qty == 10);
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 103);
-    assert(tob.best_ask.value().qty == 4);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 1);
+    CHECK(trades[0].sell_id == 4);
+    CHECK(trades[0].price == 104);
+    CHECK(trades[0].qty == 10);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 103);
+    CHECK(tob.best_ask.value().qty == 4);
 
     // Buys:
     // 
@@ -100,18 +126,18 @@ int main(){
 
     // Partial fill of resting (resting order survives)
     res = eng.process_new_order(5, Side::Buy, 103, 2);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 5);
-    assert(trades[0].sell_id == 4);
-    assert(trades[0].price == 103);
-    assert(trades[0].qty == 2);
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 103);
-    assert(tob.best_ask.value().qty == 2);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 5);
+    CHECK(trades[0].sell_id == 4);
+    CHECK(trades[0].price == 103);
+    CHECK(trades[0].qty == 2);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 103);
+    CHECK(tob.best_ask.value().qty == 2);
 
     // Buys:
     // 
@@ -120,48 +146,48 @@ int main(){
 
     // FIFO within a price level
     res = eng.process_new_order(6, Side::Sell, 103, 3);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
-    assert(trades.empty());
+    CHECK(trades.empty());
     res = eng.process_new_order(7, Side::Sell, 103, 2);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
-    assert(trades.empty());
+    CHECK(trades.empty());
     tob = eng.top_of_book();
-    assert(tob.best_ask.value().price == 103);
-    assert(tob.best_ask.value().qty == 7);
+    CHECK(tob.best_ask.value().price == 103);
+    CHECK(tob.best_ask.value().qty == 7);
 
     res = eng.process_new_order(8, Side::Buy, 104, 2);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 8);
-    assert(trades[0].sell_id == 4);
-    assert(trades[0].price == 103);
-    assert(trades[0].qty == 2);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 8);
+    CHECK(trades[0].sell_id == 4);
+    CHECK(trades[0].price == 103);
+    CHECK(trades[0].qty == 2);
 
     res = eng.process_new_order(9, Side::Buy, 104, 3);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 9);
-    assert(trades[0].sell_id == 6);
-    assert(trades[0].price == 103);
-    assert(trades[0].qty == 3);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 9);
+    CHECK(trades[0].sell_id == 6);
+    CHECK(trades[0].price == 103);
+    CHECK(trades[0].qty == 3);
 
     res = eng.process_new_order(10, Side::Buy, 104, 2);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 10);
-    assert(trades[0].sell_id == 7);
-    assert(trades[0].price == 103);
-    assert(trades[0].qty == 2);
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 10);
+    CHECK(trades[0].sell_id == 7);
+    CHECK(trades[0].price == 103);
+    CHECK(trades[0].qty == 2);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     // Buys:
     // 
@@ -170,36 +196,53 @@ int main(){
     
     // Sweep across multiple price levels
     res = eng.process_new_order(11, Side::Sell, 100, 4);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
-    assert(trades.empty());
+    CHECK(trades.empty());
     res = eng.process_new_order(12, Side::Sell, 101, 5);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
-    assert(trades.empty());
+    CHECK(trades.empty());
     res = eng.process_new_order(13, Side::Buy, 105, 7);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 2);
-    assert(trades[0].buy_id == 13);
-    assert(trades[0].sell_id == 11);
-    assert(trades[0].price == 100);
-    assert(trades[0].qty == 4);
-    assert(trades[1].buy_id == 13);
-    assert(trades[1].sell_id == 12);
-    assert(trades[1].price == 101);
-    assert(trades[1].qty == 3);
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 101);
-    assert(tob.best_ask.value().qty == 2);
+    CHECK(trades.size() == 2);
+    CHECK(trades[0].buy_id == 13);
+    CHECK(trades[0].sell_id == 11);
+    CHECK(trades[0].price == 100);
+    CHECK(trades[0].qty == 4);
+    CHECK(trades[1].buy_id == 13);
+    CHECK(trades[1].sell_id == 12);
+    CHECK(trades[1].price == 101);
+    CHECK(trades[1].qty == 3);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 101);
+    CHECK(tob.best_ask.value().qty == 2);
 
     // Buys:
     // 
     // Sells:
     // 12: 101 @ 2
 
+    // View variant reports the same trades from the engine's buffer
+    res = eng.process_new_order(14, Side::Sell, 101, 3);
+    CHECK(res.trades.empty());
+    NewOrderView view = eng.process_new_order_view(15, Side::Buy, 102, 4);
+    CHECK(view.accepted);
+    CHECK(view.trades.size() == 2);
+    CHECK(view.trades[0].buy_id == 15);
+    CHECK(view.trades[0].sell_id == 12);
+    CHECK(view.trades[0].qty == 2);
+    CHECK(view.trades[1].sell_id == 14);
+    CHECK(view.trades[1].qty == 2);
+
+    view = eng.process_new_order_view(14, Side::Buy, 102, 4);
+    CHECK(!view.accepted);
+    CHECK(view.reject_reason.value() == RejectReason::DUP);
+    CHECK(view.trades.empty());
+
     cout << "test_matching_basic: PASS" << endl;
 
     return 0;
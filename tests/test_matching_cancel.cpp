@@ -5,8 +5,9 @@ Implements unit tests for order cancellation functionality
  */
 
 #include "matching_engine.hpp"
+#include "test_listener.hpp"
 #include "common.hpp"
-#include <cassert>
+#include "check.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -24,26 +25,26 @@ int main(){
 
     // Set up initial state: one resting ask order
     res = eng.process_new_order(12, Side::Sell, 101, 2);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 101);
-    assert(tob.best_ask.value().qty == 2);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 101);
+    CHECK(tob.best_ask.value().qty == 2);
 
     // Cancel unknown order
-    assert(eng.cancel_order(999) == CancelResult::Unknown);
+    CHECK(eng.cancel_order(999) == CancelResult::Unknown);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 101);
-    assert(tob.best_ask.value().qty == 2);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 101);
+    CHECK(tob.best_ask.value().qty == 2);
 
     // remove single resting order
-    assert(eng.cancel_order(12) == CancelResult::Cancelled);
+    CHECK(eng.cancel_order(12) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     // Buys:
     // 
@@ -52,20 +53,20 @@ int main(){
 
     // cancel reduces aggregated qty at the level
     res = eng.process_new_order(14, Side::Buy, 100, 4);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     res = eng.process_new_order(15, Side::Buy, 100, 7);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     tob = eng.top_of_book();
-    assert(tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
-    assert(tob.best_bid.value().price == 100);
-    assert(tob.best_bid.value().qty == 11);
-    assert(eng.cancel_order(15) == CancelResult::Cancelled);
+    CHECK(tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+    CHECK(tob.best_bid.value().price == 100);
+    CHECK(tob.best_bid.value().qty == 11);
+    CHECK(eng.cancel_order(15) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
-    assert(tob.best_bid.value().price == 100);
-    assert(tob.best_bid.value().qty == 4);
+    CHECK(tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+    CHECK(tob.best_bid.value().price == 100);
+    CHECK(tob.best_bid.value().qty == 4);
 
     // Buys:
     // 14: 100 @ 4
@@ -73,19 +74,19 @@ int main(){
     // 
 
     // Cancel removes the entire price level if it becomes empty
-    assert(eng.cancel_order(14) == CancelResult::Cancelled);
+    CHECK(eng.cancel_order(14) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     // Cancel after full fill returns Unknown
     res = eng.process_new_order(16, Side::Buy, 100, 4);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     res = eng.process_new_order(17, Side::Sell, 100, 4);
-    assert(res.accepted == true);
-    assert(res.trades.size() == 1);
-    assert(eng.cancel_order(16) == CancelResult::Unknown);
-    assert(eng.cancel_order(17) == CancelResult::Unknown);
+    CHECK(res.accepted == true);
+    CHECK(res.trades.size() == 1);
+    CHECK(eng.cancel_order(16) == CancelResult::Unknown);
+    CHECK(eng.cancel_order(17) == CancelResult::Unknown);
 
     // Buys:
     //
@@ -94,67 +95,123 @@ int main(){
 
     // Cancel twice: first Cancelled, second Unknown
     res = eng.process_new_order(18, Side::Sell, 100, 4);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 100);
-    assert(tob.best_ask.value().qty == 4);
-    assert(eng.cancel_order(18) == CancelResult::Cancelled);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 100);
+    CHECK(tob.best_ask.value().qty == 4);
+    CHECK(eng.cancel_order(18) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
-    assert(eng.cancel_order(18) == CancelResult::Unknown);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+    CHECK(eng.cancel_order(18) == CancelResult::Unknown);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     // Cancel affects future trades
     res = eng.process_new_order(19, Side::Sell, 100, 4);
-    assert(res.accepted == true);
-    assert(eng.cancel_order(19) == CancelResult::Cancelled);
+    CHECK(res.accepted == true);
+    CHECK(eng.cancel_order(19) == CancelResult::Cancelled);
     res = eng.process_new_order(20, Side::Buy, 100, 4);
-    assert(res.accepted == true);
-    assert(res.trades.size() == 0);
-    assert(eng.cancel_order(20) == CancelResult::Cancelled);
+    CHECK(res.accepted == true);
+    CHECK(res.trades.size() == 0);
+    CHECK(eng.cancel_order(20) == CancelResult::Cancelled);
 
     // Cancel partial quantity
     res = eng.process_new_order(21, Side::Sell, 100, 10);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     res = eng.process_new_order(22, Side::Buy, 100, 6);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     trades = res.trades;
-    assert(trades.size() == 1);
-    assert(trades[0].qty == 6);
-    assert(trades[0].buy_id == 22);
-    assert(trades[0].sell_id == 21);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].qty == 6);
+    CHECK(trades[0].buy_id == 22);
+    CHECK(trades[0].sell_id == 21);
 
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 100);
-    assert(tob.best_ask.value().qty == 4);
-    assert(eng.cancel_order(21) == CancelResult::Cancelled);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 100);
+    CHECK(tob.best_ask.value().qty == 4);
+    CHECK(eng.cancel_order(21) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     // Cancel middle order perserves FIFO of remaining orders
     res = eng.process_new_order(23, Side::Sell, 100, 1);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     res = eng.process_new_order(24, Side::Sell, 100, 1);
-    assert(res.accepted == true);
+    CHECK(res.accepted == true);
     res = eng.process_new_order(25, Side::Sell, 100, 1);
-    assert(res.accepted == true);
-    assert(eng.cancel_order(24) == CancelResult::Cancelled);
+    CHECK(res.accepted == true);
+    CHECK(eng.cancel_order(24) == CancelResult::Cancelled);
     res = eng.process_new_order(26, Side::Buy, 100, 1);
-    assert(res.accepted == true);
-    assert(res.trades[0].sell_id == 23);
+    CHECK(res.accepted == true);
+    CHECK(res.trades[0].sell_id == 23);
     res = eng.process_new_order(27, Side::Buy, 100, 1);
-    assert(res.accepted == true);
-    assert(res.trades[0].sell_id == 25);
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(res.accepted == true);
+    CHECK(res.trades[0].sell_id == 25);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+
+    // Mass cancel of a price range on one side, best level first, FIFO within a level
+    MatchingEngine mass;
+    TestListener out;
+    mass.add_listener(&out);
+    mass.process_new_order(1, Side::Buy, 100, 5);
+    mass.process_new_order(2, Side::Buy, 99, 6);
+    mass.process_new_order(3, Side::Buy, 100, 4);
+    mass.process_new_order(4, Side::Buy, 95, 1);
+    mass.process_new_order(5, Side::Sell, 103, 7);
+    mass.process_new_order(6, Side::Sell, 104, 2);
+    out.clear();
+    CHECK(mass.mass_cancel(Side::Buy, 96, 100) == 3);
+    CHECK(out.get_output() == "CXL 1\nCXL 3\nCXL 2\n");
+    tob = mass.top_of_book();
+    CHECK(tob.best_bid.value().price == 95);
+    CHECK(tob.best_bid.value().qty == 1);
+    CHECK(mass.cancel_order(1) == CancelResult::Unknown);
+
+    // a range with no orders cancels nothing and says nothing
+    out.clear();
+    CHECK(mass.mass_cancel(Side::Sell, 1, 102) == 0);
+    CHECK(out.get_output().empty());
+
+    // cancelled ids stay used
+    res = mass.process_new_order(2, Side::Buy, 99, 1);
+    CHECK(!res.accepted);
+
+    // Mass cancel of one whole side, then of everything
+    out.clear();
+    CHECK(mass.mass_cancel(Side::Sell) == 2);
+    CHECK(out.get_output() == "CXL 5\nCXL 6\n");
+    CHECK(!mass.top_of_book().best_ask.has_value());
+    mass.process_new_order(7, Side::Sell, 101, 1);
+    out.clear();
+    CHECK(mass.mass_cancel() == 2);
+    CHECK(out.get_output() == "CXL 4\nCXL 7\n");
+    tob = mass.top_of_book();
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+
+    // the book keeps working on freed nodes
+    res = mass.process_new_order(8, Side::Sell, 100, 3);
+    res = mass.process_new_order(9, Side::Buy, 100, 2);
+    CHECK(res.trades.size() == 1 && res.trades[0].sell_id == 8);
+    CHECK(mass.top_of_book().best_ask.value().qty == 1);
+
+    // order id 0 cancelled by a mass cancel is unknown to later cancels and amends
+    MatchingEngine zero;
+    TestListener zero_out;
+    zero.add_listener(&zero_out);
+    zero.process_new_order(0, Side::Buy, 100, 5);
+    CHECK(zero.mass_cancel() == 1);
+    CHECK(zero.cancel_order(0) == CancelResult::Unknown);
+    CHECK(zero.amend_order(0, 100, 1) == AmendResult::Unknown);
+    CHECK(zero_out.get_output() == "ACK 0\nCXL 0\nREJ 0 UNK\nREJ 0 UNK\n");
 
     cout << "test_matching_cancel: PASS" << endl;
 
@@ -5,7 +5,7 @@ Implements simple unit tests for matching_engine.cpp
  */
 
 #include "matching_engine.hpp"
-#include <cassert>
+#include "check.hpp"
 #include <iostream>
 #include <string>
 #include <vector>
@@ -23,28 +23,28 @@ int main(){
 
     // Test adding resting orders
     res =  eng.process_new_order(1, Side::Buy, 104, 10);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
-    assert(trades.size() == 0);
+    CHECK(trades.size() == 0);
     res = eng.process_new_order(2, Side::Sell, 105, 6);
     trades = res.trades;
-    assert(trades.size() == 0);
+    CHECK(trades.size() == 0);
     tob = eng.top_of_book();
-    assert(tob.best_ask.has_value());
-    assert(tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_bid.has_value());
 
     // test invalid orders
     res =  eng.process_new_order(1, Side::Sell, 104, 10);
-    assert(res.result == NewOrderResult::DuplicateID);
-    assert(res.trades.size() == 0);
+    CHECK(res.result == NewOrderResult::DuplicateID);
+    CHECK(res.trades.size() == 0);
 
     res =  eng.process_new_order(3, Side::Sell, 0, 10);
-    assert(res.result == NewOrderResult::Invalid);
-    assert(res.trades.size() == 0);
+    CHECK(res.result == NewOrderResult::Invalid);
+    CHECK(res.trades.size() == 0);
 
     res =  eng.process_new_order(4, Side::Sell, 104, 0);
-    assert(res.result == NewOrderResult::Invalid);
-    assert(res.trades.size() == 0);
+    CHECK(res.result == NewOrderResult::Invalid);
+    CHECK(res.trades.size() == 0);
 
     // Buys:
     // 1: 104 @ 10
@@ -53,18 +53,18 @@ int main(){
 
     // Single fill (full fill incoming/resting)
     res = eng.process_new_order(3, Side::Buy, 110, 6);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 3);
-    assert(trades[0].sell_id == 2);
-    assert(trades[0].price == 105);
-    assert(trades[0].qty == 6);
-    assert(tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
-    assert(tob.best_bid.value().price == 104);
-    assert(tob.best_bid.value().qty == 10);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 3);
+    CHECK(trades[0].sell_id == 2);
+    CHECK(trades[0].price == 105);
+    CHECK(trades[0].qty == 6);
+    CHECK(tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+    CHECK(tob.best_bid.value().price == 104);
+    CHECK(tob.best_bid.value().qty == 10);
 
     // Buys:
     // 1: 104 @ 10
@@ -73,18 +73,18 @@ int main(){
 
     // Partial fill of incoming, remainder rests
     res = eng.process_new_order(4, Side::Sell, 103, 14);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 1);
-    assert(trades[0].sell_id == 4);
-    assert(trades[0].price == 104);
-    assert(trades[0].qty == 10);
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 103);
-    assert(tob.best_ask.value().qty == 4);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 1);
+    CHECK(trades[0].sell_id == 4);
+    CHECK(trades[0].price == 104);
+    CHECK(trades[0].qty == 10);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 103);
+    CHECK(tob.best_ask.value().qty == 4);
 
     // Buys:
     // 
@@ -93,18 +93,18 @@ int main(){
 
     // Partial fill of resting (resting order survives)
     res = eng.process_new_order(5, Side::Buy, 103, 2);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 5);
-    assert(trades[0].sell_id == 4);
-    assert(trades[0].price == 103);
-    assert(trades[0].qty == 2);
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 103);
-    assert(tob.best_ask.value().qty == 2);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 5);
+    CHECK(trades[0].sell_id == 4);
+    CHECK(trades[0].price == 103);
+    CHECK(trades[0].qty == 2);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 103);
+    CHECK(tob.best_ask.value().qty == 2);
 
     // Buys:
     // 
@@ -113,48 +113,48 @@ int main(){
 
     // FIFO within a price level
     res = eng.process_new_order(6, Side::Sell, 103, 3);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
-    assert(trades.empty());
+    CHECK(trades.empty());
     res = eng.process_new_order(7, Side::Sell, 103, 2);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
-    assert(trades.empty());
+    CHECK(trades.empty());
     tob = eng.top_of_book();
-    assert(tob.best_ask.value().price == 103);
-    assert(tob.best_ask.value().qty == 7);
+    CHECK(tob.best_ask.value().price == 103);
+    CHECK(tob.best_ask.value().qty == 7);
 
     res = eng.process_new_order(8, Side::Buy, 104, 2);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 8);
-    assert(trades[0].sell_id == 4);
-    assert(trades[0].price == 103);
-    assert(trades[0].qty == 2);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 8);
+    CHECK(trades[0].sell_id == 4);
+    CHECK(trades[0].price == 103);
+    CHECK(trades[0].qty == 2);
 
     res = eng.process_new_order(9, Side::Buy, 104, 3);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 9);
-    assert(trades[0].sell_id == 6);
-    assert(trades[0].price == 103);
-    assert(trades[0].qty == 3);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 9);
+    CHECK(trades[0].sell_id == 6);
+    CHECK(trades[0].price == 103);
+    CHECK(trades[0].qty == 3);
 
     res = eng.process_new_order(10, Side::Buy, 104, 2);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 1);
-    assert(trades[0].buy_id == 10);
-    assert(trades[0].sell_id == 7);
-    assert(trades[0].price == 103);
-    assert(trades[0].qty == 2);
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].buy_id == 10);
+    CHECK(trades[0].sell_id == 7);
+    CHECK(trades[0].price == 103);
+    CHECK(trades[0].qty == 2);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     // Buys:
     // 
@@ -163,30 +163,30 @@ int main(){
     
     // Sweep across multiple price levels
     res = eng.process_new_order(11, Side::Sell, 100, 4);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
-    assert(trades.empty());
+    CHECK(trades.empty());
     res = eng.process_new_order(12, Side::Sell, 101, 5);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
-    assert(trades.empty());
+    CHECK(trades.empty());
     res = eng.process_new_order(13, Side::Buy, 105, 7);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
     tob = eng.top_of_book();
-    assert(trades.size() == 2);
-    assert(trades[0].buy_id == 13);
-    assert(trades[0].sell_id == 11);
-    assert(trades[0].price == 100);
-    assert(trades[0].qty == 4);
-    assert(trades[1].buy_id == 13);
-    assert(trades[1].sell_id == 12);
-    assert(trades[1].price == 101);
-    assert(trades[1].qty == 3);
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 101);
-    assert(tob.best_ask.value().qty == 2);
+    CHECK(trades.size() == 2);
+    CHECK(trades[0].buy_id == 13);
+    CHECK(trades[0].sell_id == 11);
+    CHECK(trades[0].price == 100);
+    CHECK(trades[0].qty == 4);
+    CHECK(trades[1].buy_id == 13);
+    CHECK(trades[1].sell_id == 12);
+    CHECK(trades[1].price == 101);
+    CHECK(trades[1].qty == 3);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 101);
+    CHECK(tob.best_ask.value().qty == 2);
 
     // Buys:
     // 
@@ -194,18 +194,18 @@ int main(){
     // 12: 101 @ 2
 
     // Cancel unknown order
-    assert(eng.cancel_order(999) == CancelResult::Unknown);
+    CHECK(eng.cancel_order(999) == CancelResult::Unknown);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 101);
-    assert(tob.best_ask.value().qty == 2);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 101);
+    CHECK(tob.best_ask.value().qty == 2);
 
     // remove single resting order
-    assert(eng.cancel_order(12) == CancelResult::Cancelled);
+    CHECK(eng.cancel_order(12) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     // Buys:
     // 
@@ -214,20 +214,20 @@ int main(){
 
     // cancel reduces aggregated qty at the level
     res = eng.process_new_order(14, Side::Buy, 100, 4);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     res = eng.process_new_order(15, Side::Buy, 100, 7);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     tob = eng.top_of_book();
-    assert(tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
-    assert(tob.best_bid.value().price == 100);
-    assert(tob.best_bid.value().qty == 11);
-    assert(eng.cancel_order(15) == CancelResult::Cancelled);
+    CHECK(tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+    CHECK(tob.best_bid.value().price == 100);
+    CHECK(tob.best_bid.value().qty == 11);
+    CHECK(eng.cancel_order(15) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
-    assert(tob.best_bid.value().price == 100);
-    assert(tob.best_bid.value().qty == 4);
+    CHECK(tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+    CHECK(tob.best_bid.value().price == 100);
+    CHECK(tob.best_bid.value().qty == 4);
 
     // Buys:
     // 14: 100 @ 4
@@ -235,19 +235,19 @@ int main(){
     // 
 
     // Cancel removes the entire price level if it becomes empty
-    assert(eng.cancel_order(14) == CancelResult::Cancelled);
+    CHECK(eng.cancel_order(14) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     // Cancel after full fill returns Unknown
     res = eng.process_new_order(16, Side::Buy, 100, 4);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     res = eng.process_new_order(17, Side::Sell, 100, 4);
-    assert(res.result == NewOrderResult::Accepted);
-    assert(res.trades.size() == 1);
-    assert(eng.cancel_order(16) == CancelResult::Unknown);
-    assert(eng.cancel_order(17) == CancelResult::Unknown);
+    CHECK(res.result == NewOrderResult::Accepted);
+    CHECK(res.trades.size() == 1);
+    CHECK(eng.cancel_order(16) == CancelResult::Unknown);
+    CHECK(eng.cancel_order(17) == CancelResult::Unknown);
 
     // Buys:
     //
@@ -256,50 +256,50 @@ int main(){
 
     // Cancel twice: first Cancelled, second Unknown
     res = eng.process_new_order(18, Side::Sell, 100, 4);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 100);
-    assert(tob.best_ask.value().qty == 4);
-    assert(eng.cancel_order(18) == CancelResult::Cancelled);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 100);
+    CHECK(tob.best_ask.value().qty == 4);
+    CHECK(eng.cancel_order(18) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
-    assert(eng.cancel_order(18) == CancelResult::Unknown);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
+    CHECK(eng.cancel_order(18) == CancelResult::Unknown);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     // Cancel affects future trades
     res = eng.process_new_order(19, Side::Sell, 100, 4);
-    assert(res.result == NewOrderResult::Accepted);
-    assert(eng.cancel_order(19) == CancelResult::Cancelled);
+    CHECK(res.result == NewOrderResult::Accepted);
+    CHECK(eng.cancel_order(19) == CancelResult::Cancelled);
     res = eng.process_new_order(20, Side::Buy, 100, 4);
-    assert(res.result == NewOrderResult::Accepted);
-    assert(res.trades.size() == 0);
-     assert(eng.cancel_order(20) == CancelResult::Cancelled);
+    CHECK(res.result == NewOrderResult::Accepted);
+    CHECK(res.trades.size() == 0);
+     CHECK(eng.cancel_order(20) == CancelResult::Cancelled);
 
     // Cancel partial quantity
     res = eng.process_new_order(21, Side::Sell, 100, 10);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     res = eng.process_new_order(22, Side::Buy, 100, 6);
-    assert(res.result == NewOrderResult::Accepted);
+    CHECK(res.result == NewOrderResult::Accepted);
     trades = res.trades;
-    assert(trades.size() == 1);
-    assert(trades[0].qty == 6);
-    assert(trades[0].buy_id == 22);
-    assert(trades[0].sell_id == 21);
+    CHECK(trades.size() == 1);
+    CHECK(trades[0].qty == 6);
+    CHECK(trades[0].buy_id == 22);
+    CHECK(trades[0].sell_id == 21);
 
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(tob.best_ask.has_value());
-    assert(tob.best_ask.value().price == 100);
-    assert(tob.best_ask.value().qty == 4);
-    assert(eng.cancel_order(21) == CancelResult::Cancelled);
+    CHECK(!tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_ask.value().price == 100);
+    CHECK(tob.best_ask.value().qty == 4);
+    CHECK(eng.cancel_order(21) == CancelResult::Cancelled);
     tob = eng.top_of_book();
-    assert(!tob.best_bid.has_value());
-    assert(!tob.best_ask.has_value());
+    CHECK(!tob.best_bid.has_value());
+    CHECK(!tob.best_ask.has_value());
 
     cout << "test_matching_engine: PASS" << endl;
 
@@ -5,8 +5,9 @@ Implements simple unit tests for order_book.cpp
  */
 
 #include "order_book.hpp"
-#include <cassert>
+#include "check.hpp"
 #include <iostream>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -15,25 +16,25 @@ using std::cout;
 using std::endl;
 using std::vector;
 
-int main(){
+void test_backend(const BookConfig& config){
 
     // empty order book
-    OrderBook ob;
+    OrderBook ob(config);
     TopOfBook tob = ob.top_of_book();
-    assert(!tob.best_ask.has_value());
-    assert(!tob.best_bid.has_value());
-    assert(ob.has_best_ask() == false);
-    assert(ob.has_best_bid() == false);
+    CHECK(!tob.best_ask.has_value());
+    CHECK(!tob.best_bid.has_value());
+    CHECK(ob.has_best_ask() == false);
+    CHECK(ob.has_best_bid() == false);
     
     // consume best ask and bid when empty
     vector<Fill> fills = ob.consume_best_ask(5);
-    assert(fills.size() == 0);
+    CHECK(fills.size() == 0);
     fills = ob.consume_best_bid(5);
-    assert(fills.size() == 0);
+    CHECK(fills.size() == 0);
 
     // add bids
-    assert(ob.add_limit(1, Side::Buy, 100, 5) == AddResult::Added);
-    assert(ob.add_limit(1, Side::Sell, 300, 99) == AddResult::Duplicate);
+    CHECK(ob.add_limit(1, Side::Buy, 100, 5) == AddResult::Added);
+    CHECK(ob.add_limit(1, Side::Sell, 300, 99) == AddResult::Duplicate);
     ob.add_limit(2, Side::Buy, 100, 10);
     ob.add_limit(3, Side::Buy, 103, 7);
 
@@ -43,102 +44,459 @@ int main(){
     ob.add_limit(6, Side::Sell, 103, 8);
     ob.add_limit(7, Side::Sell, 103, 3);
     BookSnapshot bs = ob.print_book();
-    assert(bs.asks.size() == 3);
-    assert(bs.asks[0].price == 103);
-    assert(bs.asks[0].qty == 11);
-    assert(bs.asks[1].price == 109);
-    assert(bs.asks[1].qty == 5);
-    assert(bs.asks[2].price == 120);
-    assert(bs.asks[2].qty == 3);
-
-    assert(bs.bids.size() == 2);
-    assert(bs.bids[0].price == 103);
-    assert(bs.bids[0].qty == 7);
-    assert(bs.bids[1].price == 100);
-    assert(bs.bids[1].qty == 15);
+    CHECK(bs.asks.size() == 3);
+    CHECK(bs.asks[0].price == 103);
+    CHECK(bs.asks[0].qty == 11);
+    CHECK(bs.asks[1].price == 109);
+    CHECK(bs.asks[1].qty == 5);
+    CHECK(bs.asks[2].price == 120);
+    CHECK(bs.asks[2].qty == 3);
+
+    CHECK(bs.bids.size() == 2);
+    CHECK(bs.bids[0].price == 103);
+    CHECK(bs.bids[0].qty == 7);
+    CHECK(bs.bids[1].price == 100);
+    CHECK(bs.bids[1].qty == 15);
 
     // check if top of book is accurate
     tob = ob.top_of_book();
-    assert(tob.best_ask.has_value());
-    assert(tob.best_bid.has_value());
+    CHECK(tob.best_ask.has_value());
+    CHECK(tob.best_bid.has_value());
 
     // check if queries are accurate
     // best ask: 103, 11
     // best bid: 103, 7
-    assert(tob.best_ask->price == 103);
-    assert(tob.best_ask->qty == 11);
-    assert(tob.best_bid->price == 103);
-    assert(tob.best_bid->qty == 7);
-    assert(ob.has_best_ask() == true);
-    assert(ob.has_best_bid() == true);
-    assert(ob.best_ask_price() == 103);
-    assert(ob.best_bid_price() == 103);
-    assert(ob.best_ask_quantity() == 11);
-    assert(ob.best_bid_quantity() == 7);
-    assert(ob.best_ask_front().order_id == 6);
-    assert(ob.best_bid_front().order_id == 3);
-    assert(ob.best_ask_front().qty_remaining == 8);
-    assert(ob.best_bid_front().qty_remaining == 7);
+    CHECK(tob.best_ask->price == 103);
+    CHECK(tob.best_ask->qty == 11);
+    CHECK(tob.best_bid->price == 103);
+    CHECK(tob.best_bid->qty == 7);
+    CHECK(ob.has_best_ask() == true);
+    CHECK(ob.has_best_bid() == true);
+    CHECK(ob.best_ask_price() == 103);
+    CHECK(ob.best_bid_price() == 103);
+    CHECK(ob.best_ask_quantity() == 11);
+    CHECK(ob.best_bid_quantity() == 7);
+    CHECK(ob.best_ask_front().order_id == 6);
+    CHECK(ob.best_bid_front().order_id == 3);
+    CHECK(ob.best_ask_front().qty_remaining == 8);
+    CHECK(ob.best_bid_front().qty_remaining == 7);
 
     // tob updates so that best bid price != ask price
     ob.add_limit(8, Side::Buy, 104, 6);
     tob = ob.top_of_book();
-    assert(tob.best_bid->price == 104);
-    assert(tob.best_bid->qty == 6);
+    CHECK(tob.best_bid->price == 104);
+    CHECK(tob.best_bid->qty == 6);
 
     // check consume best ask
     // best ask: 103, 11
     // best bid: 104, 6
     fills = ob.consume_best_ask(5);
-    assert(fills.size() == 1);
-    assert(fills[0].resting_order_id == 6);
-    assert(fills[0].qty_filled == 5);
-    assert(ob.best_ask_price() == 103);
-    assert(ob.best_ask_quantity() == 6);
+    CHECK(fills.size() == 1);
+    CHECK(fills[0].resting_order_id == 6);
+    CHECK(fills[0].qty_filled == 5);
+    CHECK(ob.best_ask_price() == 103);
+    CHECK(ob.best_ask_quantity() == 6);
     ob.add_limit(9, Side::Sell, 103, 6);
 
     // order 6: qty remaining 3
     // order 7: qty remaining 3
     // order 9: qty remaining 6
-    assert(ob.best_ask_quantity() == 12);
+    CHECK(ob.best_ask_quantity() == 12);
     fills = ob.consume_best_ask(7);
-    assert(fills.size() == 3);
-    assert(fills[0].resting_order_id == 6);
-    assert(fills[0].qty_filled == 3);
-    assert(fills[1].resting_order_id == 7);
-    assert(fills[1].qty_filled == 3);
-    assert(fills[2].resting_order_id == 9);
-    assert(fills[2].qty_filled == 1);
-
-    assert(ob.best_ask_quantity() == 5);
+    CHECK(fills.size() == 3);
+    CHECK(fills[0].resting_order_id == 6);
+    CHECK(fills[0].qty_filled == 3);
+    CHECK(fills[1].resting_order_id == 7);
+    CHECK(fills[1].qty_filled == 3);
+    CHECK(fills[2].resting_order_id == 9);
+    CHECK(fills[2].qty_filled == 1);
+
+    CHECK(ob.best_ask_quantity() == 5);
     fills = ob.consume_best_ask(5);
-    assert(fills.size() == 1);
-    assert(fills[0].resting_order_id == 9);
-    assert(fills[0].qty_filled == 5); 
-    assert(ob.has_best_ask());
-    assert(ob.best_ask_price() == 109);
-    assert(ob.best_ask_quantity() == 5);
+    CHECK(fills.size() == 1);
+    CHECK(fills[0].resting_order_id == 9);
+    CHECK(fills[0].qty_filled == 5); 
+    CHECK(ob.has_best_ask());
+    CHECK(ob.best_ask_price() == 109);
+    CHECK(ob.best_ask_quantity() == 5);
 
     // check consume best bid
     // best ask: 109, 5
     // best bid: 104, 6
     ob.consume_best_bid(4);
-    assert(ob.best_bid_price() == 104);
-    assert(ob.best_bid_quantity() == 2);
+    CHECK(ob.best_bid_price() == 104);
+    CHECK(ob.best_bid_quantity() == 2);
     ob.consume_best_bid(2);
-    assert(ob.best_bid_price() == 103);
-    assert(ob.best_bid_quantity() == 7);
+    CHECK(ob.best_bid_price() == 103);
+    CHECK(ob.best_bid_quantity() == 7);
     ob.consume_best_bid(8);
-    assert(ob.best_bid_price() == 100);
-    assert(ob.best_bid_quantity() == 15);
+    CHECK(ob.best_bid_price() == 100);
+    CHECK(ob.best_bid_quantity() == 15);
 
     ob.add_limit(10, Side::Buy, 103, 10);
     fills = ob.consume_best_bid(99999);
-    assert(fills.size() == 1);
-    assert(fills[0].resting_order_id == 10);
-    assert(fills[0].qty_filled == 10); 
-    assert(ob.best_bid_price() == 100);
-    assert(ob.best_bid_quantity() == 15);
+    CHECK(fills.size() == 1);
+    CHECK(fills[0].resting_order_id == 10);
+    CHECK(fills[0].qty_filled == 10); 
+    CHECK(ob.best_bid_price() == 100);
+    CHECK(ob.best_bid_quantity() == 15);
+}
+
+// prices far outside the initial ladder window force it to recentre and grow
+void test_ladder_recentering(){
+    BookConfig config;
+    config.backend = BookBackend::Ladder;
+    config.ladder_base_price = 1000;
+    config.ladder_ticks = 64;
+    OrderBook ob(config);
+
+    ob.add_limit(1, Side::Buy, 1010, 5);
+    ob.add_limit(2, Side::Buy, 1010, 3);
+    ob.add_limit(3, Side::Buy, 900, 4);      // below the window
+    ob.add_limit(4, Side::Sell, 5000, 2);    // far above the window
+    ob.add_limit(5, Side::Sell, 1020, 6);
+    ob.add_limit(6, Side::Buy, 1, 1);        // forces the bid ladder to grow
+
+    CHECK(ob.best_bid_price() == 1010);
+    CHECK(ob.best_bid_quantity() == 8);
+    CHECK(ob.best_bid_front().order_id == 1);
+    CHECK(ob.best_ask_price() == 1020);
+
+    BookSnapshot bs = ob.print_book();
+    CHECK(bs.bids.size() == 3);
+    CHECK(bs.bids[0].price == 1010 && bs.bids[0].qty == 8);
+    CHECK(bs.bids[1].price == 900 && bs.bids[1].qty == 4);
+    CHECK(bs.bids[2].price == 1 && bs.bids[2].qty == 1);
+    CHECK(bs.asks.size() == 2);
+    CHECK(bs.asks[0].price == 1020 && bs.asks[0].qty == 6);
+    CHECK(bs.asks[1].price == 5000 && bs.asks[1].qty == 2);
+
+    // FIFO order survives the move into the new window
+    vector<Fill> fills = ob.consume_best_bid(6);
+    CHECK(fills.size() == 2);
+    CHECK(fills[0].resting_order_id == 1 && fills[0].qty_filled == 5);
+    CHECK(fills[1].resting_order_id == 2 && fills[1].qty_filled == 1);
+
+    // cancels walk the best index down to the next populated level
+    CHECK(ob.cancel(2) == CancelResult::Cancelled);
+    CHECK(ob.best_bid_price() == 900);
+    CHECK(ob.cancel(3) == CancelResult::Cancelled);
+    CHECK(ob.best_bid_price() == 1);
+    CHECK(ob.cancel(6) == CancelResult::Cancelled);
+    CHECK(!ob.has_best_bid());
+
+    CHECK(ob.cancel(5) == CancelResult::Cancelled);
+    CHECK(ob.best_ask_price() == 5000);
+    fills = ob.consume_best_ask(10);
+    CHECK(fills.size() == 1);
+    CHECK(!ob.has_best_ask());
+
+    // an empty ladder is simply moved to the next price seen
+    ob.add_limit(7, Side::Sell, 2000000, 1);
+    CHECK(ob.best_ask_price() == 2000000);
+    CHECK(ob.cancel(4) == CancelResult::Unknown);
+}
+
+// prices too far apart for the largest ladder rest in the overflow map beside it
+void test_ladder_overflow(){
+    BookConfig config;
+    config.backend = BookBackend::Ladder;
+    config.ladder_ticks = 64;
+    config.ladder_max_ticks = 256;
+    OrderBook ob(config);
+
+    ob.add_limit(1, Side::Buy, 1, 5);
+    ob.add_limit(2, Side::Buy, 2000000000, 3);   // far above the whole window
+    ob.add_limit(3, Side::Buy, 1000000, 4);
+    ob.add_limit(4, Side::Buy, 1000000, 2);
+    ob.add_limit(5, Side::Sell, 2000000001, 1);
+    ob.add_limit(6, Side::Sell, 3, 7);
+    CHECK(ob.best_bid_price() == 2000000000);
+    CHECK(ob.best_ask_price() == 3);
+
+    BookSnapshot bs = ob.print_book();
+    CHECK(bs.bids.size() == 3);
+    CHECK(bs.bids[0].price == 2000000000 && bs.bids[1].price == 1000000 && bs.bids[2].price == 1);
+    CHECK(bs.bids[1].qty == 6);
+    CHECK(bs.asks.size() == 2);
+    CHECK(bs.asks[0].price == 3 && bs.asks[1].price == 2000000001);
+
+    // the touch moves between the ladder and the map
+    CHECK(ob.cancel(2) == CancelResult::Cancelled);
+    CHECK(ob.best_bid_price() == 1000000 && ob.best_bid_quantity() == 6);
+    vector<Fill> fills = ob.consume_best_bid(5);
+    CHECK(fills.size() == 2 && fills[0].resting_order_id == 3 && fills[1].resting_order_id == 4);
+    CHECK(ob.best_bid_price() == 1000000 && ob.best_bid_quantity() == 1);
+
+    // mass cancel across both
+    vector<int> cancelled;
+    ob.add_limit(7, Side::Buy, 50, 1);
+    ob.mass_cancel(Side::Buy, 1, 2000000000, cancelled);
+    CHECK((cancelled == vector<int>{4, 7, 1}));
+    CHECK(!ob.has_best_bid());
+    CHECK(ob.cancel(6) == CancelResult::Cancelled);
+    CHECK(ob.best_ask_price() == 2000000001);
+
+    // the ladder and its map agree with the map backend under random prices
+    std::mt19937 rng(11);
+    OrderBook ladder(config);
+    OrderBook map(BookConfig{});
+    vector<long long> ladder_trace, map_trace;
+    auto random_price = [&]{
+        switch (rng() % 3){
+            case 0: return 1000 + static_cast<int>(rng() % 100);
+            case 1: return 1 + static_cast<int>(rng() % 2000);
+            default: return 1 + static_cast<int>(rng() % 2000000000);
+        }
+    };
+    auto trace_book = [](const OrderBook& book, vector<long long>& trace){
+        BookSnapshot bs = book.print_book();
+        for (const PriceLevel& level : bs.bids) trace.insert(trace.end(), {level.price, level.qty});
+        for (const PriceLevel& level : bs.asks) trace.insert(trace.end(), {-level.price, level.qty});
+    };
+    for (int id = 1; id <= 20000; ++id){
+        unsigned op = rng() % 10;
+        if (op < 6){
+            Side side = rng() % 2 ? Side::Buy : Side::Sell;
+            int price = random_price();
+            ladder.add_limit(id, side, price, 1 + id % 7);
+            map.add_limit(id, side, price, 1 + id % 7);
+        } else if (op < 8){
+            int target = 1 + static_cast<int>(rng() % id);
+            ladder_trace.push_back(static_cast<int>(ladder.cancel(target)));
+            map_trace.push_back(static_cast<int>(map.cancel(target)));
+        } else if (op < 9){
+            int price = random_price();
+            int qty = static_cast<int>(rng() % 8);
+            int target = 1 + static_cast<int>(rng() % id);
+            ladder_trace.push_back(static_cast<int>(ladder.amend(target, price, qty).action));
+            map_trace.push_back(static_cast<int>(map.amend(target, price, qty).action));
+        } else {
+            Side side = rng() % 2 ? Side::Buy : Side::Sell;
+            int low = random_price();
+            int high = low + static_cast<int>(rng() % 3000);
+            vector<int> from_ladder, from_map;
+            ladder.mass_cancel(side, low, high, from_ladder);
+            map.mass_cancel(side, low, high, from_map);
+            ladder_trace.insert(ladder_trace.end(), from_ladder.begin(), from_ladder.end());
+            map_trace.insert(map_trace.end(), from_map.begin(), from_map.end());
+        }
+        if (id % 97 == 0 && ladder.has_best_bid() && map.has_best_bid()){
+            for (const Fill& fill : ladder.consume_best_bid(5)) ladder_trace.push_back(fill.resting_order_id);
+            for (const Fill& fill : map.consume_best_bid(5)) map_trace.push_back(fill.resting_order_id);
+        }
+        if (id % 500 == 0){
+            trace_book(ladder, ladder_trace);
+            trace_book(map, map_trace);
+        }
+    }
+    CHECK(ladder_trace == map_trace);
+}
+
+// limited depth snapshots hold the best levels of the full book and reuse their storage
+void test_depth(const BookConfig& config){
+    OrderBook ob(config);
+    for (int i = 0; i < 20; ++i){
+        ob.add_limit(1 + i, Side::Buy, 100 - i, 1 + i);
+        ob.add_limit(101 + i, Side::Sell, 101 + 2 * i, 2);
+    }
+    ob.add_limit(200, Side::Buy, 100, 4);
+    BookSnapshot full = ob.print_book();
+
+    BookSnapshot depth;
+    ob.print_book(5, depth);
+    CHECK(depth.bids.size() == 5 && depth.asks.size() == 5);
+    for (std::size_t i = 0; i < 5; ++i){
+        CHECK(depth.bids[i].price == full.bids[i].price && depth.bids[i].qty == full.bids[i].qty);
+        CHECK(depth.asks[i].price == full.asks[i].price && depth.asks[i].qty == full.asks[i].qty);
+    }
+    CHECK(depth.bids[0].qty == 5);
+
+    // a smaller request refills the same storage
+    const PriceLevel* bids_storage = depth.bids.data();
+    ob.print_book(2, depth);
+    CHECK(depth.bids.size() == 2 && depth.bids.data() == bids_storage);
+    CHECK(depth.asks[1].price == 103);
+
+    // depth beyond the book returns every level
+    ob.print_book(100, depth);
+    CHECK(depth.bids.size() == full.bids.size() && depth.asks.size() == full.asks.size());
+
+    ob.print_book(0, depth);
+    CHECK(depth.bids.empty() && depth.asks.empty());
+}
+
+// amends cut quantity in place, requeue on a new price or more quantity, and pull
+// orders that would cross so the caller can match them
+void test_amend(const BookConfig& config){
+    OrderBook ob(config);
+    ob.add_limit(1, Side::Buy, 100, 5);
+    ob.add_limit(2, Side::Buy, 100, 6);
+    ob.add_limit(3, Side::Buy, 99, 4);
+    ob.add_limit(4, Side::Sell, 102, 8);
+
+    // a cut keeps time priority and updates the level total and touch
+    vector<LevelUpdate> updates;
+    AmendOutcome out = ob.amend(1, 100, 2, &updates);
+    CHECK(out.action == AmendAction::Reduced && out.side == Side::Buy);
+    CHECK(ob.best_bid_front().order_id == 1);
+    CHECK(ob.best_bid_quantity() == 8);
+    CHECK(ob.top_of_book().best_bid->qty == 8);
+    CHECK(updates.size() == 1 && updates[0].price == 100 && updates[0].qty == 8);
+
+    // the same quantity changes nothing
+    updates.clear();
+    CHECK(ob.amend(1, 100, 2, &updates).action == AmendAction::Reduced);
+    CHECK(updates.empty());
+
+    // more quantity loses priority
+    CHECK(ob.amend(1, 100, 3).action == AmendAction::Requeued);
+    CHECK(ob.best_bid_front().order_id == 2);
+    CHECK(ob.best_bid_quantity() == 9);
+
+    // a new price moves the order and the touch
+    updates.clear();
+    CHECK(ob.amend(3, 101, 4, &updates).action == AmendAction::Requeued);
+    CHECK(ob.best_bid_price() == 101 && ob.best_bid_quantity() == 4);
+    CHECK(updates.size() == 2);
+    CHECK(updates[0].price == 99 && updates[0].qty == 0);
+    CHECK(updates[1].price == 101 && updates[1].qty == 4);
+
+    // moving the only order of the touch away uncovers the next level
+    CHECK(ob.amend(3, 98, 4).action == AmendAction::Requeued);
+    CHECK(ob.best_bid_price() == 100 && ob.best_bid_quantity() == 9);
+
+    // crossing the spread pulls the order: off the book but its id stays in use
+    out = ob.amend(2, 103, 10);
+    CHECK(out.action == AmendAction::Pulled && out.side == Side::Buy);
+    CHECK(ob.best_bid_price() == 100 && ob.best_bid_quantity() == 3);
+    CHECK(ob.has_order(2));
+    CHECK(ob.amend(2, 100, 1).action == AmendAction::Unknown);
+    CHECK(ob.cancel(2) == CancelResult::Unknown);
+    vector<Fill> fills = ob.consume_best_ask(8);
+    CHECK(fills.size() == 1 && fills[0].resting_order_id == 4);
+    ob.rest_pulled(2, Side::Buy, 103, 2);
+    CHECK(ob.best_bid_price() == 103 && ob.best_bid_quantity() == 2);
+    CHECK(ob.amend(2, 103, 1).action == AmendAction::Reduced);
+
+    CHECK(ob.amend(42, 100, 1).action == AmendAction::Unknown);
+}
+
+// mass cancels take whole levels in a price range, keep the touch current and free the nodes
+void test_mass_cancel(const BookConfig& config){
+    OrderBook ob(config);
+    for (int i = 0; i < 10; ++i){
+        ob.add_limit(1 + i, Side::Buy, 100 - i, 1 + i);
+        ob.add_limit(11 + i, Side::Buy, 100 - i, 1);
+        ob.add_limit(21 + i, Side::Sell, 101 + i, 2);
+    }
+    CHECK(ob.order_pool_stats().live == 30);
+
+    // a range below the touch leaves it alone
+    vector<int> cancelled;
+    vector<LevelUpdate> updates;
+    ob.mass_cancel(Side::Buy, 90, 93, cancelled, &updates);
+    CHECK((cancelled == vector<int>{8, 18, 9, 19, 10, 20}));
+    CHECK(updates.size() == 3);
+    CHECK(updates[0].price == 93 && updates[0].qty == 0 && updates[2].price == 91);
+    CHECK(ob.best_bid_price() == 100 && ob.best_bid_quantity() == 2);
+    CHECK(ob.order_pool_stats().live == 24);
+    CHECK(ob.has_order(8));
+    CHECK(ob.cancel(8) == CancelResult::Unknown);
+
+    // a range through the touch moves it to the next level left
+    cancelled.clear();
+    ob.mass_cancel(Side::Sell, 0, 103, cancelled);
+    CHECK((cancelled == vector<int>{21, 22, 23}));
+    CHECK(ob.best_ask_price() == 104 && ob.best_ask_quantity() == 2);
+
+    // prices between levels, beyond the book and empty ranges
+    cancelled.clear();
+    ob.mass_cancel(Side::Buy, 101, 200, cancelled);
+    ob.mass_cancel(Side::Buy, 97, 96, cancelled);
+    CHECK(cancelled.empty());
+    ob.mass_cancel(Side::Sell, 109, 2000000000, cancelled);
+    CHECK((cancelled == vector<int>{29, 30}));
+    CHECK(ob.best_ask_price() == 104);
+
+    // a whole side, and the freed nodes are reused
+    cancelled.clear();
+    ob.mass_cancel(Side::Buy, 1, 1000, cancelled);
+    CHECK(cancelled.size() == 14);
+    CHECK(cancelled[0] == 1 && cancelled[1] == 11 && cancelled[13] == 17);
+    CHECK(!ob.has_best_bid());
+    CHECK(ob.order_pool_stats().live == 5);
+    std::size_t high_water = ob.order_pool_stats().high_water;
+    for (int i = 0; i < 20; ++i) ob.add_limit(100 + i, Side::Buy, 50 + i % 3, 1);
+    CHECK(ob.order_pool_stats().high_water == high_water);
+    CHECK(ob.best_bid_price() == 52 && ob.best_bid_quantity() == 6);
+    vector<Fill> fills = ob.consume_best_bid(2);
+    CHECK(fills.size() == 2 && fills[0].resting_order_id == 102 && fills[1].resting_order_id == 105);
+
+    // id 0 is an ordinary id: once mass cancelled it is no longer resting
+    OrderBook zero(config);
+    zero.add_limit(0, Side::Buy, 100, 5);
+    cancelled.clear();
+    zero.mass_cancel(Side::Buy, 1, 1000, cancelled);
+    CHECK((cancelled == vector<int>{0}));
+    CHECK(zero.cancel(0) == CancelResult::Unknown);
+    CHECK(zero.amend(0, 100, 1).action == AmendAction::Unknown);
+    zero.add_limit(1, Side::Buy, 100, 2);
+    CHECK(zero.cancel(0) == CancelResult::Unknown);
+    CHECK(zero.best_bid_quantity() == 2);
+}
+
+// pool nodes are recycled through the free list and the high-water mark is kept
+void test_order_pool(){
+    BookConfig config;
+    config.order_capacity = 8;
+    OrderBook ob(config);
+    CHECK(ob.order_pool_stats().capacity >= 8);
+
+    ob.add_limit(1, Side::Buy, 100, 1);
+    ob.add_limit(2, Side::Buy, 100, 2);
+    ob.add_limit(3, Side::Buy, 100, 3);
+    CHECK(ob.order_pool_stats().live == 3);
+    CHECK(ob.order_pool_stats().high_water == 3);
+
+    // unlink from the middle of the queue keeps FIFO order of the rest
+    CHECK(ob.cancel(2) == CancelResult::Cancelled);
+    CHECK(ob.best_bid_quantity() == 4);
+    vector<Fill> fills = ob.consume_best_bid(4);
+    CHECK(fills.size() == 2);
+    CHECK(fills[0].resting_order_id == 1);
+    CHECK(fills[1].resting_order_id == 3);
+    CHECK(ob.order_pool_stats().live == 0);
+
+    // freed nodes are reused so the high-water mark does not move
+    ob.add_limit(4, Side::Sell, 101, 1);
+    ob.add_limit(5, Side::Sell, 101, 1);
+    CHECK(ob.order_pool_stats().live == 2);
+    CHECK(ob.order_pool_stats().high_water == 3);
+    CHECK(ob.best_ask_front().order_id == 4);
+}
+
+int main(){
+    BookConfig map_config;
+    map_config.backend = BookBackend::Map;
+    test_backend(map_config);
+
+    BookConfig ladder_config;
+    ladder_config.backend = BookBackend::Ladder;
+    test_backend(ladder_config);
+
+    test_depth(map_config);
+    test_depth(ladder_config);
+
+    test_amend(map_config);
+    test_amend(ladder_config);
+
+    test_mass_cancel(map_config);
+    test_mass_cancel(ladder_config);
+
+    test_ladder_recentering();
+    test_ladder_overflow();
+    test_order_pool();
 
     cout << "test_order_book: PASS" << endl;
     return 0;
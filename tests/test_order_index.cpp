@@ -0,0 +1,76 @@
+/**
+test_order_index.cpp
+--------------
+Implements simple unit tests for order_index.hpp
+ */
+
+#include "order_index.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <unordered_map>
+
+using std::cout;
+using std::endl;
+
+int main(){
+
+    // empty index
+    OrderIndex<int> index;
+    CHECK(index.size() == 0);
+    CHECK(index.find(1) == nullptr);
+    CHECK(!index.erase(1));
+
+    // insert and lookup
+    auto [value, inserted] = index.insert(7);
+    CHECK(inserted);
+    *value = 70;
+    CHECK(index.size() == 1);
+    CHECK(*index.find(7) == 70);
+
+    // duplicate insert returns the existing value
+    auto [dup, dup_inserted] = index.insert(7);
+    CHECK(!dup_inserted);
+    CHECK(*dup == 70);
+    CHECK(index.size() == 1);
+
+    // reserve keeps existing entries
+    index.reserve(1000);
+    CHECK(index.capacity() >= 1000);
+    CHECK(*index.find(7) == 70);
+
+    // many inserts force rehashing, interleaved erases shift clusters back
+    OrderIndex<int> big;
+    std::unordered_map<int, int> reference;
+    for (int id = 1; id <= 50000; ++id){
+        *big.insert(id).first = id * 2;
+        reference[id] = id * 2;
+        if (id % 3 == 0){
+            bool erased = big.erase(id / 3);
+            CHECK(erased);
+            reference.erase(id / 3);
+        }
+    }
+    CHECK(big.size() == reference.size());
+    for (int id = 1; id <= 50000; ++id){
+        const int* found = big.find(id);
+        auto it = reference.find(id);
+        if (it == reference.end()){
+            CHECK(found == nullptr);
+        } else {
+            CHECK(found != nullptr && *found == it->second);
+        }
+    }
+
+    // erase everything, table is empty again with no leftover markers
+    for (auto& kv : reference){
+        bool erased = big.erase(kv.first);
+        CHECK(erased);
+    }
+    CHECK(big.size() == 0);
+    CHECK(big.find(50000) == nullptr);
+    *big.insert(-5).first = 1;
+    CHECK(*big.find(-5) == 1);
+
+    cout << "test_order_index: PASS" << endl;
+    return 0;
+}
@@ -5,8 +5,9 @@ Implements simple unit tests for parser.cpp
  */
 
 #include "parser.hpp"
-#include <cassert>
+#include "check.hpp"
 #include <iostream>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -15,149 +16,337 @@ using std::vector;
 using std::cout;
 using std::endl;
 
+// Every field of two commands is equal
+bool same_command(const Command& a, const Command& b){
+    return a.type == b.type && a.order_id == b.order_id && a.side == b.side && a.price == b.price
+        && a.qty == b.qty && a.reject_reason == b.reject_reason && a.symbol == b.symbol;
+}
+
+// parse_command_view returns exactly what parse_command returns
+void test_view_parser_parity(){
+    vector<string> cases = {
+        "", " ", "\t", "P", "B", "X", "P extra", "X AAPL", "C 12", "C 12abc", "C 0", "C -1", "C +7",
+        "C", "C 1 2", "N 1 B 101 10", "N 2 S 105 5", "N 1 X 101 10", "N 1 B 0 10", "N 1 B 101 0",
+        "N 1 B 101 10abc", "N 1 B abc 10", "N 1 B 101 abc", "N abc B 101 10", "N 1 B -5 10",
+        "N 1 B 101 -3", "N 1 B +101 +10", "N +1 S 5 5", "N 1 B ++5 10", "N 1 B +-5 10", "N 1 B - 10",
+        "N 1 B + 10", "N 1 B 99999999999 10", "N 1 B 101 99999999999", "N 99999999999 B 1 1",
+        "N 1 B 2147483647 2147483647", "N 1 B 2147483648 1", "N 1 B -2147483649 1",
+        "N 1 B 99999999999x 10", "N 1 BB 101 10", "N 1 b 101 10", "N 1 B 101", "N 1 B 101 10 7",
+        "  N   3\tS 101  7  ", "N 1 B 101 10\r", "NN 1 B 101 10", "n 1 B 101 10", "Z",
+        "N AAPL 3 S 101 7", "C BRK.B 3", "P MSFT", "B MSFT", "N AAPL 4 B -5 10", "N AAPL 4 B x 10",
+        "N aapl 3 S 101 7", "N TOOLONGSYM 3 S 101 7", "C AAPL", "P A B", "N A1_. 1 B 1 1",
+        "N 1 2 B 101 10", "C 0x10", "C 1e3", "C 007",
+        "B 5", "B AAPL 5", "B 0", "B -1", "B x", "B 5x", "B +3", "B 5 5", "B AAPL MSFT", "B AAPL 0",
+        "B 99999999999", "B 2147483647", "P 5", "B AAPL 5 5",
+        "A 1 101 5", "A 1 0 5", "A 1 101 0", "A 1 101 x", "A x 1 1", "A 0 1 1", "A 1 101 5abc",
+        "A 1 -5 5", "A 1 99999999999 5", "A AAPL 1 101 5", "A AAPL 1 x 5", "A 1 101", "A 1 101 5 6",
+        "M", "M B", "M S", "M X", "M b", "M AAPL", "M B B", "M S S", "M AAPL B", "M B 100 105",
+        "M S 100 100", "M B 105 100", "M B 0 5", "M B -1 5", "M B 1 x", "M B x 5", "M B 5x 9",
+        "M B 1 99999999999", "M AAPL S 100 105", "M AAPL X 100 105", "M B 100", "M AAPL B 100",
+        "M B 1 2 3", "M 100 105", "M aapl", "M AAPL B 1 2 3",
+    };
+    for (const string& line : cases){
+        CHECK(same_command(parse_command(line), parse_command_view(line)));
+    }
+
+    // random mutations of valid lines
+    std::mt19937 rng(11);
+    const string alphabet = "0123456789 +-BSNCPXA.x\t";
+    vector<string> seeds = {"N 12 B 101 10", "N AAPL 12 S 99 3", "C 12", "C MSFT 4", "P", "B ZZ", "B 3", "B ZZ 10", "A 12 101 5", "A ZZ 12 99 3", "M", "M B 100 105", "M ZZ S"};
+    for (int i = 0; i < 200000; ++i){
+        string line = seeds[rng() % seeds.size()];
+        int edits = 1 + rng() % 3;
+        for (int e = 0; e < edits; ++e){
+            std::size_t at = rng() % (line.size() + 1);
+            char ch = alphabet[rng() % alphabet.size()];
+            switch (rng() % 3){
+                case 0: line.insert(line.begin() + at, ch); break;
+                case 1: if (at < line.size()) line.erase(at, 1); break;
+                default: if (at < line.size()) line[at] = ch; break;
+            }
+        }
+        CHECK(same_command(parse_command(line), parse_command_view(line)));
+    }
+
+    // batches split the same way
+    string batch = "N 1 B 100 10\n\ninvalid\nC 1\nP\nX";
+    vector<Command> expected = parse_commands(batch);
+    vector<Command> actual = parse_commands_view(batch);
+    CHECK(expected.size() == actual.size());
+    for (std::size_t i = 0; i < expected.size(); ++i){
+        CHECK(same_command(expected[i], actual[i]));
+    }
+    CHECK(parse_commands_view("\n\n\n").size() == 3);
+    CHECK(parse_commands_view("").empty());
+}
+
 int main(){
 
     // valid inputs
     string line = "P";
     Command c = parse_command(line);
-    assert(c.type == CommandType::PrintTopOfBook);
+    CHECK(c.type == CommandType::PrintTopOfBook);
 
     line = "B";
     c = parse_command(line);
-    assert(c.type == CommandType::PrintFullBook);
+    CHECK(c.type == CommandType::PrintFullBook);
 
     line = "X";
     c = parse_command(line);
-    assert(c.type == CommandType::Exit);
+    CHECK(c.type == CommandType::Exit);
 
     line = "C 12";
     c = parse_command(line);
-    assert(c.type == CommandType::Cancel);
-    assert(c.order_id == 12);
+    CHECK(c.type == CommandType::Cancel);
+    CHECK(c.order_id == 12);
 
     line = "N 1 B 101 10";
     c = parse_command(line);
-    assert(c.type == CommandType::New);
-    assert(c.order_id == 1);
-    assert(c.side == Side::Buy);
-    assert(c.price == 101);
-    assert(c.qty == 10);
+    CHECK(c.type == CommandType::New);
+    CHECK(c.order_id == 1);
+    CHECK(c.side == Side::Buy);
+    CHECK(c.price == 101);
+    CHECK(c.qty == 10);
 
     line = "N 2 S 105 5";
     c = parse_command(line);
-    assert(c.type == CommandType::New);
-    assert(c.order_id == 2);
-    assert(c.side == Side::Sell);
-    assert(c.price == 105);
-    assert(c.qty == 5);
+    CHECK(c.type == CommandType::New);
+    CHECK(c.order_id == 2);
+    CHECK(c.side == Side::Sell);
+    CHECK(c.price == 105);
+    CHECK(c.qty == 5);
 
 
     // invalid inputs
     line = "";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
 
     line = " ";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
 
     line = "P extra";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
 
     line = "C 12abc";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
 
     line = "C 0";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
 
     line = "C -1";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
 
     line = "N 1 X 101 10";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
 
     line = "N 1 B 0 10";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
 
     line = "N 1 B 101 0";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
 
     line = "N 1 B 101 10abc";
     c = parse_command(line);
-    assert(c.type == CommandType::Reject);
-    assert(c.reject_reason == RejectReason::BAD);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.reject_reason == RejectReason::BAD);
+
+    // symbol-qualified commands
+    line = "N AAPL 3 S 101 7";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::New);
+    CHECK(c.order_id == 3);
+    CHECK(c.side == Side::Sell);
+    CHECK(c.price == 101);
+    CHECK(c.qty == 7);
+    CHECK(symbol_name(c.symbol) == "AAPL");
+
+    line = "C BRK.B 3";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::Cancel);
+    CHECK(c.order_id == 3);
+    CHECK(symbol_name(c.symbol) == "BRK.B");
+
+    line = "P MSFT";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::PrintTopOfBook);
+    CHECK(symbol_name(c.symbol) == "MSFT");
+
+    line = "B MSFT";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::PrintFullBook);
+    CHECK(symbol_name(c.symbol) == "MSFT");
+
+    // B may limit the depth printed, with or without a symbol
+    line = "B";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::PrintFullBook && c.qty == 0);
+
+    line = "B 5";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::PrintFullBook && c.qty == 5);
+    CHECK(c.symbol == default_symbol);
+
+    line = "B AAPL 3";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::PrintFullBook && c.qty == 3);
+    CHECK(symbol_name(c.symbol) == "AAPL");
+
+    for (string bad : {"B 0", "B -2", "B x", "B 1 2", "B AAPL 0"}){
+        c = parse_command(bad);
+        CHECK(c.type == CommandType::Reject && c.reject_reason == RejectReason::BAD);
+    }
+
+    line = "N 1 B 101 10";
+    c = parse_command(line);
+    CHECK(c.symbol == default_symbol);
+
+    // A changes the price and quantity of an order, with or without a symbol
+    line = "A 12 101 5";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::Amend);
+    CHECK(c.order_id == 12 && c.price == 101 && c.qty == 5);
+    CHECK(c.symbol == default_symbol);
+
+    line = "A MSFT 12 99 3";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::Amend && c.order_id == 12 && c.price == 99 && c.qty == 3);
+    CHECK(symbol_name(c.symbol) == "MSFT");
+
+    // M cancels everything, one side, or a price range of one side
+    c = parse_command("M");
+    CHECK(c.type == CommandType::MassCancel && c.symbol == default_symbol);
+
+    c = parse_command("M S");
+    CHECK(c.type == CommandType::MassCancelSide && c.side == Side::Sell);
+    CHECK(c.price == 1 && c.qty == 2147483647);
+
+    c = parse_command("M AAPL B 100 105");
+    CHECK(c.type == CommandType::MassCancelSide && c.side == Side::Buy);
+    CHECK(c.price == 100 && c.qty == 105);
+    CHECK(symbol_name(c.symbol) == "AAPL");
+
+    // a lone B or S is a side; a symbol named B needs its side spelled out
+    c = parse_command("M AAPL");
+    CHECK(c.type == CommandType::MassCancel && symbol_name(c.symbol) == "AAPL");
+    c = parse_command("M B");
+    CHECK(c.type == CommandType::MassCancelSide && c.symbol == default_symbol);
+    c = parse_command("M B S");
+    CHECK(c.type == CommandType::MassCancelSide && c.side == Side::Sell && symbol_name(c.symbol) == "B");
+
+    for (string bad : {"M b", "M B 0 5", "M B 105 100", "M B 100", "M B 1 x", "M 100 105"}){
+        c = parse_command(bad);
+        CHECK(c.type == CommandType::Reject && c.reject_reason == RejectReason::BAD);
+    }
+
+    // a bad price or quantity keeps the order id for the reject, a bad id does not
+    line = "A 12 0 5";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::Reject && c.reject_reason == RejectReason::BAD && c.order_id == 12);
+
+    line = "A 12 101 5x";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::Reject && c.order_id == 12);
+
+    for (string bad : {"A x 101 5", "A 12 101", "A 12 101 5 6"}){
+        c = parse_command(bad);
+        CHECK(c.type == CommandType::Reject && c.order_id == 0);
+    }
+
+    // a bad field on a symbol-qualified order keeps the symbol for the reject
+    line = "N AAPL 4 B -5 10";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::Reject);
+    CHECK(c.order_id == 4);
+    CHECK(symbol_name(c.symbol) == "AAPL");
+
+    // invalid symbols are not taken as symbols
+    line = "N aapl 3 S 101 7";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::Reject);
+
+    line = "N TOOLONGSYM 3 S 101 7";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::Reject);
+
+    line = "X AAPL";
+    c = parse_command(line);
+    CHECK(c.type == CommandType::Reject);
 
     // Test parse_commands with valid batch
     string batch = "N 1 B 100 10\nN 2 S 105 5\nP\nC 1\nX\n";
     vector<Command> commands = parse_commands(batch);
-    assert(commands.size() == 5);
-    assert(commands[0].type == CommandType::New);
-    assert(commands[0].order_id == 1);
-    assert(commands[0].side == Side::Buy);
-    assert(commands[0].price == 100);
-    assert(commands[0].qty == 10);
+    CHECK(commands.size() == 5);
+    CHECK(commands[0].type == CommandType::New);
+    CHECK(commands[0].order_id == 1);
+    CHECK(commands[0].side == Side::Buy);
+    CHECK(commands[0].price == 100);
+    CHECK(commands[0].qty == 10);
     
-    assert(commands[1].type == CommandType::New);
-    assert(commands[1].order_id == 2);
-    assert(commands[1].side == Side::Sell);
-    assert(commands[1].price == 105);
-    assert(commands[1].qty == 5);
+    CHECK(commands[1].type == CommandType::New);
+    CHECK(commands[1].order_id == 2);
+    CHECK(commands[1].side == Side::Sell);
+    CHECK(commands[1].price == 105);
+    CHECK(commands[1].qty == 5);
     
-    assert(commands[2].type == CommandType::PrintTopOfBook);
-    assert(commands[3].type == CommandType::Cancel);
-    assert(commands[3].order_id == 1);
-    assert(commands[4].type == CommandType::Exit);
+    CHECK(commands[2].type == CommandType::PrintTopOfBook);
+    CHECK(commands[3].type == CommandType::Cancel);
+    CHECK(commands[3].order_id == 1);
+    CHECK(commands[4].type == CommandType::Exit);
 
     // Test parse_commands with empty batch
     batch = "";
     commands = parse_commands(batch);
-    assert(commands.size() == 0);  // Empty string returns no commands
+    CHECK(commands.size() == 0);  // Empty string returns no commands
 
     // Test parse_commands with multiple lines including invalid
     batch = "N 1 B 100 10\ninvalid\nC 1\nP\n";
     commands = parse_commands(batch);
-    assert(commands.size() == 4);
-    assert(commands[0].type == CommandType::New);
-    assert(commands[1].type == CommandType::Reject);  // Invalid line
-    assert(commands[2].type == CommandType::Cancel);
-    assert(commands[3].type == CommandType::PrintTopOfBook);
+    CHECK(commands.size() == 4);
+    CHECK(commands[0].type == CommandType::New);
+    CHECK(commands[1].type == CommandType::Reject);  // Invalid line
+    CHECK(commands[2].type == CommandType::Cancel);
+    CHECK(commands[3].type == CommandType::PrintTopOfBook);
 
     // Test parse_commands with only newlines
     batch = "\n\n\n";
     commands = parse_commands(batch);
-    assert(commands.size() == 3);  // Each empty line becomes a Reject
+    CHECK(commands.size() == 3);  // Each empty line becomes a Reject
     for (const auto& cmd : commands) {
-        assert(cmd.type == CommandType::Reject);
+        CHECK(cmd.type == CommandType::Reject);
     }
 
     // Test parse_commands with mixed valid and invalid commands
     batch = "N 10 B 50 20\nC 10\nN 20 S 60 15\nP\nB\n";
     commands = parse_commands(batch);
-    assert(commands.size() == 5);
-    assert(commands[0].type == CommandType::New);
-    assert(commands[0].order_id == 10);
-    assert(commands[1].type == CommandType::Cancel);
-    assert(commands[1].order_id == 10);
-    assert(commands[2].type == CommandType::New);
-    assert(commands[2].order_id == 20);
-    assert(commands[3].type == CommandType::PrintTopOfBook);
-    assert(commands[4].type == CommandType::PrintFullBook);
+    CHECK(commands.size() == 5);
+    CHECK(commands[0].type == CommandType::New);
+    CHECK(commands[0].order_id == 10);
+    CHECK(commands[1].type == CommandType::Cancel);
+    CHECK(commands[1].order_id == 10);
+    CHECK(commands[2].type == CommandType::New);
+    CHECK(commands[2].order_id == 20);
+    CHECK(commands[3].type == CommandType::PrintTopOfBook);
+    CHECK(commands[4].type == CommandType::PrintFullBook);
+
+    test_view_parser_parity();
 
     cout << "test_parser: PASS" << endl;
     return 0;
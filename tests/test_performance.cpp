@@ -1,119 +1,129 @@
 /**
 test_performance.cpp
 --------------
-Measures latency and throughput using RAII ScopedTimer
+Measures latency and throughput using RAII ScopedTimer.
+Latencies are recorded into fixed-memory LatencyHistograms, so the harness
+uses the same memory for a thousand operations or a few hundred million.
  */
 
 #include "matching_engine.hpp"
 #include "parser.hpp"
 #include "test_listener.hpp"
+#include "event_ring.hpp"
+#include "sharded_engine.hpp"
+#include "mapped_file.hpp"
+#include "binary_command.hpp"
+#include "event_journal.hpp"
+#include "printer_listener.hpp"
+#include "command_wal.hpp"
+#include "latency_histogram.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <thread>
+#include <unordered_set>
 #include <iostream>
-#include <fstream>
 #include <sstream>
+#include <random>
 #include <string>
 #include <vector>
 #include <chrono>
 #include <algorithm>
-#include <numeric>
+#include <cstdlib>
+#include <new>
 
 using std::string;
-using std::ifstream;
-using std::istringstream;
-using std::getline;
 using std::cerr;
 using std::cout;
 using std::endl;
-using std::ostringstream;
+
+// Global allocation counter, every operator new in the process goes through here.
+// The array forms are replaced too, so every new is paired with a matching delete, and
+// none is inlined, which would show the compiler malloc'd memory released by operator delete.
+static std::size_t allocation_count = 0;
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    ++allocation_count;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// Listener that discards every event, so only engine allocations are counted
+struct SilentListener : IEventListener {
+    void on_ack(int) override {}
+    void on_reject(int, RejectReason) override {}
+    void on_cancel(int, CancelResult) override {}
+    void on_amend(int, AmendResult) override {}
+    void on_trade(const Trade&) override {}
+    void on_tob(const TopOfBook&) override {}
+    void on_book(const BookSnapshot&) override {}
+};
 
 // RAII ScopedTimer for clean benchmarking
 struct ScopedTimer {
-    std::vector<long long>& latencies;
+    LatencyHistogram& latencies;
     std::chrono::high_resolution_clock::time_point start;
 
-    ScopedTimer(std::vector<long long>& storage) 
-        : latencies(storage), start(std::chrono::high_resolution_clock::now()) {}
+    ScopedTimer(LatencyHistogram& histogram) 
+        : latencies(histogram), start(std::chrono::high_resolution_clock::now()) {}
 
     ~ScopedTimer() {
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-        latencies.push_back(duration);
+        latencies.record(static_cast<std::uint64_t>(duration));
     }
 };
 
-// Reads a file into a string
-string read_file(const string& filename) {
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Could not open file " << filename << endl;
-        return "";
-    }
-    
-    ostringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
-}
-
-void print_statistics(const std::vector<long long>& latencies, const string& operation_name, 
-                      int operation_count, double total_wall_time_seconds) {
+void print_statistics(const LatencyHistogram& latencies, const string& operation_name, 
+                      std::uint64_t operation_count, double total_wall_time_seconds) {
     if (latencies.empty()) {
         return;
     }
 
-    // Sort latencies for percentile calculation
-    std::vector<long long> sorted_latencies = latencies;
-    std::sort(sorted_latencies.begin(), sorted_latencies.end());
-
-    // Calculate mean latency
-    long long sum = std::accumulate(sorted_latencies.begin(), sorted_latencies.end(), 0LL);
-    double mean_ns = static_cast<double>(sum) / sorted_latencies.size();
-    double mean_us = mean_ns / 1000.0;
-
-    // Calculate P99 latency
-    size_t p99_index = static_cast<size_t>((sorted_latencies.size() - 1) * 0.99);
-    long long p99_ns = sorted_latencies[p99_index];
-    double p99_us = p99_ns / 1000.0;
-
     // Calculate throughput: operations per second based on wall-clock time
     double throughput = operation_count / total_wall_time_seconds;
 
     cout << "=== " << operation_name << " Performance Statistics ===\n";
     cout << "Total Operations: " << operation_count << "\n";
-    cout << "Mean Latency: " << mean_us << " us\n";
-    cout << "P99 Latency: " << p99_us << " us\n";
+    cout << "Mean Latency: " << latencies.mean() / 1000.0 << " us\n";
+    cout << "P50 Latency: " << latencies.percentile(50) / 1000.0 << " us\n";
+    cout << "P90 Latency: " << latencies.percentile(90) / 1000.0 << " us\n";
+    cout << "P99 Latency: " << latencies.percentile(99) / 1000.0 << " us\n";
+    cout << "P99.9 Latency: " << latencies.percentile(99.9) / 1000.0 << " us\n";
+    cout << "P99.99 Latency: " << latencies.percentile(99.99) / 1000.0 << " us\n";
+    cout << "Max Latency: " << latencies.max() / 1000.0 << " us\n";
     cout << "Throughput: " << throughput << " " << operation_name << "s/sec\n";
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        cerr << "Please input: " << argv[0] << " <input_file>" << endl;
-        return 1;
-    }
-
-    string input_file = argv[1];
-    string input = read_file(input_file);
-    if (input.empty()) {
-        cerr << "Failed to read input file: " << input_file << endl;
-        return 1;
-    }
-
-    MatchingEngine engine;
-
-    // silent listener - output captured but not printed
-    TestListener listener;
-    engine.add_listener(&listener);
-
-    // Latency storage vectors
-    std::vector<long long> match_latencies;
-    std::vector<long long> cancel_latencies;
-
-    // Parse all commands first (exclude parsing from timing)
-    std::vector<Command> commands;
-    istringstream input_stream(input);
-    string line;
-    while (getline(input_stream, line)) {
-        if (line == "X") break;
-        commands.push_back(parse_command(line));
-    }
+// Replays commands through an engine and prints latency statistics.
+// after_command runs between commands, outside of the per-operation timers.
+template <typename Engine, typename AfterCommand>
+void run_benchmark(Engine& engine, const std::vector<Command>& commands, const string& label,
+                   AfterCommand after_command) {
+    // Latency histograms, fixed size however many commands are replayed
+    LatencyHistogram match_latencies;
+    LatencyHistogram cancel_latencies;
+    LatencyHistogram amend_latencies;
+    LatencyHistogram mass_cancel_latencies;
 
     // Measure pure logic latency (excluding parsing/I/O)
     auto overall_start = std::chrono::high_resolution_clock::now();
@@ -132,6 +142,17 @@ int main(int argc, char* argv[]) {
                 engine.cancel_order(cmd.order_id);
                 break;
             }
+            case CommandType::Amend: {
+                ScopedTimer t(amend_latencies);
+                engine.amend_order(cmd.order_id, cmd.price, cmd.qty);
+                break;
+            }
+            case CommandType::MassCancel:
+            case CommandType::MassCancelSide: {
+                ScopedTimer t(mass_cancel_latencies);
+                engine.process_command(cmd);
+                break;
+            }
             case CommandType::PrintTopOfBook:
                 engine.top_of_book();
                 break;
@@ -143,6 +164,7 @@ int main(int argc, char* argv[]) {
             default:
                 break;
         }
+        after_command();
     }
 
     auto overall_end = std::chrono::high_resolution_clock::now();
@@ -150,14 +172,641 @@ int main(int argc, char* argv[]) {
     double total_seconds = total_duration.count() / 1e9;
 
     // Print statistics
+    cout << "##### " << label << " #####\n\n";
     if (!match_latencies.empty()) {
-        print_statistics(match_latencies, "Order", match_latencies.size(), total_seconds);
+        print_statistics(match_latencies, "Order", match_latencies.count(), total_seconds);
         cout << "\n";
     }
     if (!cancel_latencies.empty()) {
-        print_statistics(cancel_latencies, "Cancel", cancel_latencies.size(), total_seconds);
+        print_statistics(cancel_latencies, "Cancel", cancel_latencies.count(), total_seconds);
+        cout << "\n";
+    }
+    if (!amend_latencies.empty()) {
+        print_statistics(amend_latencies, "Amend", amend_latencies.count(), total_seconds);
+        cout << "\n";
+    }
+    if (!mass_cancel_latencies.empty()) {
+        print_statistics(mass_cancel_latencies, "Mass Cancel", mass_cancel_latencies.count(), total_seconds);
         cout << "\n";
     }
 
+    OrderPoolStats pool_stats = engine.order_book().order_pool_stats();
+    cout << "Order Pool High-Water Mark: " << pool_stats.high_water << " orders"
+         << " (" << pool_stats.live << " live at end)\n\n";
+}
+
+template <typename Engine>
+void run_benchmark(Engine& engine, const std::vector<Command>& commands, const string& label) {
+    run_benchmark(engine, commands, label, []{});
+}
+
+// Runs the engine in ring output mode: timed calls only append event records, and the
+// ring is drained into a TestListener in batches whose cost is reported separately
+void run_ring_benchmark(const std::vector<Command>& commands, const BookConfig& config, const string& backend_name) {
+    EventRing ring(1 << 16);
+    EventReplayer replayer;
+    TestListener listener;
+    std::size_t drained = 0;
+    double drain_seconds = 0;
+
+    auto drain = [&]{
+        auto start = std::chrono::high_resolution_clock::now();
+        drained += replayer.drain(ring, listener);
+        auto end = std::chrono::high_resolution_clock::now();
+        drain_seconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+    };
+
+    BasicMatchingEngine<EventRingWriter> engine(config, EventRingWriter{&ring, drain});
+    run_benchmark(engine, commands, "Book backend: " + backend_name + ", event ring output", [&]{
+        if (ring.size() >= ring.capacity() / 2) drain();
+    });
+    drain();
+
+    cout << "Ring Drain: " << drained << " records replayed into TestListener in "
+         << drain_seconds << " s (" << drained / drain_seconds << " records/sec)\n\n";
+}
+
+// Times parse_command against parse_command_view over the same lines
+void compare_parsers(const std::vector<string>& lines, const string& label) {
+    auto time_parser = [&](auto parse) {
+        std::size_t allocations_before = allocation_count;
+        std::size_t rejects = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const string& line : lines) {
+            if (parse(line).type == CommandType::Reject) ++rejects;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+        cout << "  " << lines.size() / seconds << " lines/sec, "
+             << static_cast<double>(allocation_count - allocations_before) / lines.size() << " allocations/line, "
+             << rejects << " rejects\n";
+    };
+    cout << label << " (" << lines.size() << " lines)\n";
+    cout << "parse_command:\n";
+    time_parser([](const string& line){ return parse_command(line); });
+    cout << "parse_command_view:\n";
+    time_parser([](const string& line){ return parse_command_view(line); });
+}
+
+// Parser throughput on the input file, and on a copy where most lines are malformed
+void run_parser_benchmark(std::string_view input) {
+    std::vector<string> lines;
+    MappedLineReader reader(input);
+    std::string_view line;
+    while (reader.next(line)) lines.emplace_back(line);
+
+    std::vector<string> malformed;
+    const char* corruptions[] = {"x", "-", "99999999999", " extra", "abc"};
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        string bad = lines[i];
+        if (i % 4 != 0) {
+            std::size_t last_space = bad.rfind(' ');
+            bad = bad.substr(0, last_space == string::npos ? 0 : last_space + 1) + corruptions[i % 5];
+        }
+        malformed.push_back(bad);
+    }
+
+    cout << "=== Parser Throughput ===\n";
+    compare_parsers(lines, "Input file");
+    compare_parsers(malformed, "Malformed-heavy input (75% bad lines)");
+    cout << "\n";
+}
+
+// Decode throughput of the binary format for the same commands, to set against text parsing
+void run_decode_benchmark(const std::vector<Command>& commands) {
+    string encoded(binary_command_magic);
+    for (const Command& cmd : commands) {
+        BinaryRecord rec = encode_command(cmd);
+        encoded.append(reinterpret_cast<const char*>(&rec), sizeof(rec));
+    }
+
+    std::size_t decoded = 0;
+    std::int64_t checksum = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    BinaryCommandReader reader(encoded);
+    Command cmd;
+    while (reader.next(cmd)) {
+        ++decoded;
+        checksum += cmd.order_id;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+
+    cout << "=== Binary Decode ===\n";
+    cout << decoded << " records (" << encoded.size() << " bytes): " << decoded / seconds
+         << " commands/sec (checksum " << checksum << ")\n\n";
+}
+
+// Writes all events as text lines and as a binary journal to /dev/null and
+// compares output size per event and end-to-end throughput
+void run_output_benchmark(const std::vector<Command>& commands, const BookConfig& config) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd < 0) return;
+
+    auto replay = [&](auto& engine, OutputBuffer& output) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const Command& cmd : commands) engine.process_command(cmd);
+        output.flush();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+    };
+
+    OutputBuffer text_output(null_fd);
+    BasicMatchingEngine<PrinterListener> text_engine(config, PrinterListener(text_output));
+    double text_seconds = replay(text_engine, text_output);
+
+    OutputBuffer journal_output(null_fd);
+    EventJournal journal(journal_output);
+    BasicMatchingEngine<JournalListener> journal_engine(config, JournalListener(journal));
+    double journal_seconds = replay(journal_engine, journal_output);
+    close(null_fd);
+
+    double events = static_cast<double>(journal.events());
+    auto report = [&](const string& name, std::size_t bytes, double seconds) {
+        cout << name << ": " << bytes << " bytes, " << bytes / events << " bytes/event, "
+             << events / seconds << " events/sec, " << bytes / seconds / (1 << 20) << " MB/s\n";
+    };
+    cout << "=== Event Output (" << journal.events() << " events) ===\n";
+    report("Text printer", text_output.bytes_written(), text_seconds);
+    report("Binary journal", journal_output.bytes_written(), journal_seconds);
+    cout << "\n";
+}
+
+// Builds a book of a million resting orders by replaying them, then saves it and
+// restores it into a fresh engine, comparing warm start time with replay time
+void run_snapshot_benchmark(const BookConfig& config, const string& backend_name) {
+    const int order_count = 1000000;
+    auto seconds_since = [](std::chrono::high_resolution_clock::time_point start) {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+    };
+
+    // bids on 1..5000 and asks on 5001..10000 never cross, so every order rests
+    BasicMatchingEngine<NullListener> original(config);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int id = 1; id <= order_count; ++id) {
+        int tick = id % 5000;
+        if (id % 2) original.process_new_order_view(id, Side::Buy, 1 + tick, 1 + id % 100);
+        else original.process_new_order_view(id, Side::Sell, 5001 + tick, 1 + id % 100);
+    }
+    double replay_seconds = seconds_since(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    SnapshotWriter out;
+    original.save_snapshot(out);
+    double save_seconds = seconds_since(start);
+
+    BasicMatchingEngine<NullListener> restored(config);
+    start = std::chrono::high_resolution_clock::now();
+    SnapshotReader in(out.bytes());
+    bool loaded = restored.load_snapshot(in);
+    double restore_seconds = seconds_since(start);
+
+    cout << "=== Snapshot (" << backend_name << ", " << order_count << " resting orders) ===\n";
+    cout << "Replay: " << replay_seconds << " s\n";
+    cout << "Save: " << save_seconds << " s, " << out.size() << " bytes\n";
+    cout << "Restore: " << restore_seconds << " s (" << replay_seconds / restore_seconds << "x faster than replay)"
+         << (loaded ? "" : " FAILED") << "\n\n";
+}
+
+// Changes resting orders of a 100k order book with amend_order and with the cancel and
+// new order pair a client would otherwise send: quantity cuts, which amend makes in place,
+// and re-prices, which move the order either way
+void run_amend_benchmark(const BookConfig& config, const string& backend_name) {
+    const int order_count = 100000;
+    const int change_count = 200000;
+
+    // bids on 1..5000 and asks on 5001..10000 never cross
+    auto build = [&](BasicMatchingEngine<NullListener>& engine) {
+        for (int id = 1; id <= order_count; ++id) {
+            int tick = id % 5000;
+            if (id % 2) engine.process_new_order_view(id, Side::Buy, 1 + tick, 1000);
+            else engine.process_new_order_view(id, Side::Sell, 5001 + tick, 1000);
+        }
+    };
+    auto price_of = [](int id) { return id % 2 ? 1 + id % 5000 : 5001 + id % 5000; };
+
+    // each change targets a random resting order
+    std::mt19937 rng(5);
+    std::vector<int> targets(change_count);
+    for (int& t : targets) t = 1 + static_cast<int>(rng() % order_count);
+
+    for (bool reprice : {false, true}) {
+        LatencyHistogram amend_latencies;
+        LatencyHistogram replace_latencies;
+        BasicMatchingEngine<NullListener> amended(config);
+        BasicMatchingEngine<NullListener> replaced(config);
+        build(amended);
+        build(replaced);
+        // the replaced book gives each new order a fresh id
+        std::vector<int> current_id(order_count + 1);
+        std::vector<int> qty_of(order_count + 1, 1000);
+        std::vector<char> moved(order_count + 1, 0);
+        for (int id = 1; id <= order_count; ++id) current_id[id] = id;
+        int next_id = order_count + 1;
+
+        for (int i = 0; i < change_count; ++i) {
+            int id = targets[i];
+            // cuts take one lot each time; re-prices step one tick away from the spread and back
+            int qty = reprice ? qty_of[id] : --qty_of[id];
+            int price = price_of(id);
+            if (reprice && (moved[id] ^= 1)) price += id % 2 ? -1 : 1;
+            {
+                ScopedTimer t(amend_latencies);
+                amended.amend_order(id, price, qty);
+            }
+            {
+                ScopedTimer t(replace_latencies);
+                replaced.cancel_order(current_id[id]);
+                replaced.process_new_order_view(next_id, id % 2 ? Side::Buy : Side::Sell, price, qty);
+            }
+            current_id[id] = next_id++;
+        }
+
+        cout << "=== Amend vs cancel + new (" << backend_name << ", " << order_count << " resting orders, "
+             << (reprice ? "re-prices" : "quantity cuts") << ") ===\n";
+        cout << "Amend: mean " << amend_latencies.mean() << " ns, p50 " << amend_latencies.percentile(50)
+             << " ns, p99 " << amend_latencies.percentile(99) << " ns\n";
+        cout << "Cancel + new: mean " << replace_latencies.mean() << " ns, p50 " << replace_latencies.percentile(50)
+             << " ns, p99 " << replace_latencies.percentile(99) << " ns\n\n";
+    }
+}
+
+// Clears resting orders of a 100k order book with one mass cancel and with a cancel per
+// order: a price band of one side, one whole side and the whole book. Per-order cancels
+// go in id order, which here is also memory order, so they are at their best.
+void run_mass_cancel_benchmark(const BookConfig& config, const string& backend_name) {
+    const int order_count = 100000;
+    auto seconds_since = [](std::chrono::high_resolution_clock::time_point start) {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+    };
+
+    // bids on 1..5000 and asks on 5001..10000 never cross
+    auto build = [&](BasicMatchingEngine<NullListener>& engine) {
+        for (int id = 1; id <= order_count; ++id) {
+            int tick = id % 5000;
+            if (id % 2) engine.process_new_order_view(id, Side::Buy, 1 + tick, 1 + id % 100);
+            else engine.process_new_order_view(id, Side::Sell, 5001 + tick, 1 + id % 100);
+        }
+    };
+    auto side_of = [](int id) { return id % 2 ? Side::Buy : Side::Sell; };
+    auto price_of = [](int id) { return id % 2 ? 1 + id % 5000 : 5001 + id % 5000; };
+
+    struct Case {
+        const char* name;
+        bool both_sides;
+        int min_price;
+        int max_price;
+    };
+    const Case cases[] = {
+        {"bids 4001..5000", false, 4001, 5000},
+        {"all bids", false, 1, 5000},
+        {"whole book", true, 1, 10000},
+    };
+
+    cout << "=== Mass cancel vs per-order cancels (" << backend_name << ", " << order_count << " resting orders) ===\n";
+    for (const Case& c : cases) {
+        BasicMatchingEngine<NullListener> per_order(config);
+        BasicMatchingEngine<NullListener> mass(config);
+        build(per_order);
+        build(mass);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::size_t cancelled = 0;
+        for (int id = 1; id <= order_count; ++id) {
+            if (!c.both_sides && side_of(id) != Side::Buy) continue;
+            if (price_of(id) < c.min_price || price_of(id) > c.max_price) continue;
+            per_order.cancel_order(id);
+            ++cancelled;
+        }
+        double per_order_seconds = seconds_since(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        std::size_t mass_cancelled = c.both_sides ? mass.mass_cancel() : mass.mass_cancel(Side::Buy, c.min_price, c.max_price);
+        double mass_seconds = seconds_since(start);
+
+        cout << c.name << ": " << cancelled << " orders, per-order " << per_order_seconds * 1e6 << " us, mass "
+             << mass_seconds * 1e6 << " us (" << per_order_seconds / mass_seconds << "x)"
+             << (mass_cancelled == cancelled ? "" : " MISMATCH") << "\n";
+    }
+    cout << "\n";
+}
+
+// Runs commands after setup one process_command at a time and through process_batch in
+// batches of 1 to 4096, with compile-time and with runtime listeners. Only the commands are
+// timed, and each rate is the best of three runs, as differences of a few percent are the norm.
+void run_batch_benchmark(const std::vector<Command>& setup, const std::vector<Command>& commands,
+                         const BookConfig& config, const string& label) {
+    auto run = [&](auto& engine, std::size_t batch) {
+        engine.process_batch(setup);
+        auto start = std::chrono::high_resolution_clock::now();
+        if (batch == 0) {
+            for (const Command& cmd : commands) engine.process_command(cmd);
+        } else {
+            for (std::size_t i = 0; i < commands.size(); i += batch) {
+                engine.process_batch(CommandSpan{commands.data() + i, std::min(batch, commands.size() - i)});
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return commands.size() / (std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9);
+    };
+
+    cout << "=== Batch Throughput (" << label << ", " << commands.size() << " commands, commands/sec) ===\n";
+    cout << "Batch size: NullListener | SilentListener (runtime)\n";
+    double single_direct = 0, single_runtime = 0;
+    for (std::size_t batch : {0, 1, 4, 16, 64, 256, 4096}) {
+        double direct_rate = 0, runtime_rate = 0;
+        for (int round = 0; round < 3; ++round) {
+            BasicMatchingEngine<NullListener> direct(config);
+            direct_rate = std::max(direct_rate, run(direct, batch));
+            MatchingEngine runtime(config);
+            SilentListener silent;
+            runtime.add_listener(&silent);
+            runtime_rate = std::max(runtime_rate, run(runtime, batch));
+        }
+        if (batch == 0) {
+            single_direct = direct_rate;
+            single_runtime = runtime_rate;
+            cout << "process_command: " << direct_rate << " | " << runtime_rate << "\n";
+        } else {
+            cout << batch << ": " << direct_rate << " (" << direct_rate / single_direct << "x) | "
+                 << runtime_rate << " (" << runtime_rate / single_runtime << "x)\n";
+        }
+    }
+    cout << "\n";
+}
+
+// Cancels, quantity cuts and new orders at random over a book of a million resting orders
+// spread across 100k ticks, so most commands miss the cache for their index slot and level
+void run_deep_book_batch_benchmark(const BookConfig& config, const string& backend_name) {
+    const int order_count = 1000000;
+    const int command_count = 1000000;
+    std::vector<Command> setup;
+    std::vector<Command> commands;
+    setup.reserve(order_count);
+    commands.reserve(command_count);
+
+    // bids on 1..50000 and asks on 50001..100000 never cross
+    for (int id = 1; id <= order_count; ++id) {
+        int tick = (id / 2) % 50000;
+        if (id % 2) setup.push_back(Command{CommandType::New, id, Side::Buy, 1 + tick, 100});
+        else setup.push_back(Command{CommandType::New, id, Side::Sell, 50001 + tick, 100});
+    }
+    std::mt19937 rng(25);
+    int next_id = order_count + 1;
+    for (int i = 0; i < command_count; ++i) {
+        int id = 1 + static_cast<int>(rng() % order_count);
+        int tick = static_cast<int>(rng() % 50000);
+        unsigned op = rng() % 10;
+        if (op < 4) {
+            commands.push_back(Command{CommandType::Cancel, id});
+        } else if (op < 7) {
+            Command amend{CommandType::Amend, id};
+            amend.price = id % 2 ? 1 + (id / 2) % 50000 : 50001 + (id / 2) % 50000;
+            amend.qty = 1 + static_cast<int>(rng() % 99);
+            commands.push_back(amend);
+        } else if (rng() % 2) {
+            commands.push_back(Command{CommandType::New, next_id++, Side::Buy, 1 + tick, 100});
+        } else {
+            commands.push_back(Command{CommandType::New, next_id++, Side::Sell, 50001 + tick, 100});
+        }
+    }
+    run_batch_benchmark(setup, commands, config, backend_name + ", " + std::to_string(order_count) + " resting orders");
+}
+
+// Times full book queries against depth-limited ones on the book left by the commands,
+// and counts the heap allocations of the depth-limited queries once warm
+void run_depth_benchmark(const std::vector<Command>& commands, const BookConfig& config) {
+    BasicMatchingEngine<NullListener> engine(config);
+    for (const Command& cmd : commands) engine.process_command(cmd);
+    const int queries = 20000;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < queries; ++i) engine.print_book();
+    auto end = std::chrono::high_resolution_clock::now();
+    double full_seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+
+    cout << "=== Book Queries (" << engine.order_book().print_book().bids.size() << " bid levels, "
+         << queries << " queries) ===\n";
+    cout << "Full book: " << full_seconds / queries * 1e6 << " us per query\n";
+    for (std::size_t depth : {1, 5, 10}) {
+        engine.print_book(depth);   // warm the reused snapshot
+        std::size_t allocations_before = allocation_count;
+        start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < queries; ++i) engine.print_book(depth);
+        end = std::chrono::high_resolution_clock::now();
+        std::size_t allocations = allocation_count - allocations_before;
+        double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+        cout << "Depth " << depth << ": " << seconds / queries * 1e6 << " us per query, "
+             << allocations << " heap allocations\n";
+    }
+    cout << "\n";
+}
+
+// Times each command including its write-ahead journal append (and any sync it triggers)
+// for every durability setting, against running without a journal
+void run_wal_benchmark(const std::vector<Command>& commands, const BookConfig& config) {
+    // syncing every command is slow on real disks, so all settings run the same prefix
+    std::vector<Command> prefix(commands.begin(), commands.begin() + std::min<std::size_t>(commands.size(), 20000));
+
+    struct Setting {
+        const char* name;
+        bool journal;
+        WalSync mode;
+        std::size_t group;
+    };
+    const Setting settings[] = {
+        {"no journal", false, WalSync::None, 0},
+        {"none (write, no sync)", true, WalSync::None, 0},
+        {"group of 256", true, WalSync::Group, 256},
+        {"group of 16", true, WalSync::Group, 16},
+        {"always", true, WalSync::Always, 0},
+    };
+
+    cout << "=== Write-Ahead Journal (" << prefix.size() << " commands, per-command latency) ===\n";
+    for (const Setting& setting : settings) {
+        char path[] = "/tmp/exchange_wal_XXXXXX";
+        int fd = ::mkstemp(path);
+        if (fd < 0) return;
+        ::close(fd);
+        ::unlink(path);
+
+        CommandWal wal(setting.mode, setting.group);
+        if (setting.journal && !wal.open(path)) {
+            cout << setting.name << ": could not open " << path << "\n";
+            continue;
+        }
+        BasicMatchingEngine<NullListener> engine(config);
+        LatencyHistogram latencies;
+        for (const Command& cmd : prefix) {
+            ScopedTimer t(latencies);
+            if (setting.journal) wal.append(cmd);
+            engine.process_command(cmd);
+        }
+        wal.commit();
+        ::unlink(path);
+
+        cout << setting.name << ": p50 " << latencies.percentile(50) / 1000.0 << " us, p99 "
+             << latencies.percentile(99) / 1000.0 << " us, max "
+             << latencies.max() / 1000.0 << " us, "
+             << wal.sync_count() << " syncs" << (wal.failed() ? " FAILED" : "") << "\n";
+    }
+    cout << "\n";
+}
+
+// Runs multi-symbol input through 1, 2, 4 and 8 shards and reports end-to-end throughput.
+// Only meaningful when the input names several symbols (scripts/generate_test.py --symbols).
+void run_shard_scaling(const std::vector<Command>& commands, const BookConfig& config) {
+    std::unordered_set<Symbol> symbols;
+    for (const auto& cmd : commands) symbols.insert(cmd.symbol);
+    if (symbols.size() < 2) return;
+
+    cout << "=== Shard Scaling (" << symbols.size() << " symbols, "
+         << std::thread::hardware_concurrency() << " hardware threads) ===\n";
+    using Engine = BasicMatchingEngine<NullListener>;
+    for (std::size_t shards : {1, 2, 4, 8}) {
+        auto start = std::chrono::high_resolution_clock::now();
+        {
+            ShardedEngine<Engine> sharded(shards, [&](std::size_t, Symbol){
+                return std::make_unique<Engine>(config);
+            });
+            for (const auto& cmd : commands) sharded.submit(cmd);
+            sharded.finish();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+        cout << shards << " shard(s): " << commands.size() / seconds << " commands/sec\n";
+    }
+    cout << "\n";
+}
+
+// Counts heap allocations per order/cancel/amend once the engine is warm.
+// The first half of the commands warms up the engine buffers, the second half is measured.
+// P/B queries build snapshots by value and are skipped.
+void run_allocation_check(const std::vector<Command>& commands, BookConfig config,
+                          const string& backend_name, bool use_view) {
+    std::size_t new_orders = 0;
+    for (const auto& cmd : commands) {
+        if (cmd.type == CommandType::New) ++new_orders;
+    }
+    config.order_capacity = new_orders;
+    config.order_id_capacity = new_orders;
+
+    MatchingEngine engine(config);
+    SilentListener listener;
+    engine.add_listener(&listener);
+
+    std::size_t half = commands.size() / 2;
+    std::size_t measured_ops = 0;
+    std::size_t allocations_before = 0;
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        if (i == half) allocations_before = allocation_count;
+        const Command& cmd = commands[i];
+        if (cmd.type == CommandType::New) {
+            if (use_view) engine.process_new_order_view(cmd.order_id, cmd.side, cmd.price, cmd.qty);
+            else engine.process_new_order(cmd.order_id, cmd.side, cmd.price, cmd.qty);
+        }
+        else if (cmd.type == CommandType::Cancel) {
+            engine.cancel_order(cmd.order_id);
+        }
+        else if (cmd.type == CommandType::Amend) {
+            engine.amend_order(cmd.order_id, cmd.price, cmd.qty);
+        }
+        else {
+            continue;
+        }
+        if (i >= half) ++measured_ops;
+    }
+    std::size_t allocations = allocation_count - allocations_before;
+
+    cout << "Heap allocations (" << backend_name << ", "
+         << (use_view ? "process_new_order_view" : "process_new_order") << "): "
+         << allocations << " over " << measured_ops << " steady-state operations ("
+         << (measured_ops ? static_cast<double>(allocations) / measured_ops : 0.0) << " per operation)\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Please input: " << argv[0] << " <input_file>" << endl;
+        return 1;
+    }
+
+    string input_file = argv[1];
+    MappedFile file;
+    if (!file.open(input_file.c_str()) || file.size() == 0) {
+        cerr << "Failed to read input file: " << input_file << endl;
+        return 1;
+    }
+    std::string_view input = file.contents();
+
+    // Parse or decode all commands first (exclude parsing from timing)
+    std::vector<Command> commands;
+    bool binary = is_binary_commands(input);
+    if (binary) {
+        BinaryCommandReader reader(input);
+        Command cmd;
+        while (reader.next(cmd) && cmd.type != CommandType::Exit) commands.push_back(cmd);
+    }
+    else {
+        MappedLineReader reader(input);
+        std::string_view line;
+        while (reader.next(line)) {
+            if (line == "X") break;
+            commands.push_back(parse_command_view(line));
+        }
+    }
+
+    if (!binary) run_parser_benchmark(input);
+    run_decode_benchmark(commands);
+
+    BookConfig map_config;
+    map_config.backend = BookBackend::Map;
+    BookConfig ladder_config;
+    ladder_config.backend = BookBackend::Ladder;
+
+    // runtime listeners - TestListener output captured but not printed
+    for (const BookConfig& config : {map_config, ladder_config}) {
+        MatchingEngine engine(config);
+        TestListener listener;
+        engine.add_listener(&listener);
+        string backend = config.backend == BookBackend::Map ? "map" : "ladder";
+        run_benchmark(engine, commands, "Book backend: " + backend + ", runtime listeners (TestListener)");
+    }
+
+    // compile-time listeners - NullListener dispatch compiles away, so this is matching cost alone
+    for (const BookConfig& config : {map_config, ladder_config}) {
+        BasicMatchingEngine<NullListener> engine(config);
+        string backend = config.backend == BookBackend::Map ? "map" : "ladder";
+        run_benchmark(engine, commands, "Book backend: " + backend + ", compile-time listeners (NullListener)");
+    }
+
+    // ring output - matching cost with event formatting moved to batched drains
+    run_ring_benchmark(commands, map_config, "map");
+    run_ring_benchmark(commands, ladder_config, "ladder");
+
+    run_output_benchmark(commands, ladder_config);
+    run_batch_benchmark({}, commands, map_config, "map, input file");
+    run_batch_benchmark({}, commands, ladder_config, "ladder, input file");
+    run_deep_book_batch_benchmark(map_config, "map");
+    run_deep_book_batch_benchmark(ladder_config, "ladder");
+    run_depth_benchmark(commands, map_config);
+    run_depth_benchmark(commands, ladder_config);
+    run_snapshot_benchmark(map_config, "map");
+    run_snapshot_benchmark(ladder_config, "ladder");
+    run_amend_benchmark(map_config, "map");
+    run_amend_benchmark(ladder_config, "ladder");
+    run_mass_cancel_benchmark(map_config, "map");
+    run_mass_cancel_benchmark(ladder_config, "ladder");
+    run_wal_benchmark(commands, ladder_config);
+    run_shard_scaling(commands, ladder_config);
+
+    cout << "=== Allocation Statistics ===\n";
+    run_allocation_check(commands, map_config, "map", false);
+    run_allocation_check(commands, map_config, "map", true);
+    run_allocation_check(commands, ladder_config, "ladder", false);
+    run_allocation_check(commands, ladder_config, "ladder", true);
+    cout << "\n";
+
     return 0;
 }
@@ -0,0 +1,149 @@
+/**
+test_pipeline.cpp
+--------------
+Implements unit tests for the three-stage CommandPipeline
+ */
+
+#include "basic_matching_engine.hpp"
+#include "event_ring.hpp"
+#include "parser.hpp"
+#include "pipeline.hpp"
+#include "symbol_router.hpp"
+#include "test_listener.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+// Command source over a vector
+struct VectorCommands {
+    const vector<Command>& commands;
+    std::size_t next_index = 0;
+
+    bool next(Command& cmd){
+        if (next_index == commands.size()) return false;
+        cmd = commands[next_index++];
+        return true;
+    }
+};
+
+vector<Command> make_commands(int count){
+    const char* symbols[] = {"", "AAA ", "BBB "};
+    std::mt19937 rng(9);
+    vector<Command> commands;
+    for (int i = 1; i <= count; ++i){
+        std::ostringstream line;
+        string symbol = symbols[rng() % 3];
+        switch (rng() % 12){
+            case 0: line << "C " << symbol << 1 + rng() % i; break;
+            case 1: line << "P " << symbol; break;
+            case 2: line << "B " << symbol; break;
+            case 3: line << "N " << symbol << i << " B x 1"; break;
+            default:
+                line << "N " << symbol << i << (rng() % 2 ? " B " : " S ") << 95 + rng() % 10 << " " << 1 + rng() % 30;
+        }
+        commands.push_back(parse_command_view(line.str()));
+    }
+    return commands;
+}
+
+// Output of each book when commands run serially with direct listeners
+vector<string> run_serial(const vector<Command>& commands){
+    using Engine = BasicMatchingEngine<ListenerList>;
+    vector<std::unique_ptr<TestListener>> listeners;
+    SymbolRouter<Engine> router([&](Symbol){
+        listeners.push_back(std::make_unique<TestListener>());
+        ListenerList list;
+        list.listeners.push_back(listeners.back().get());
+        return std::make_unique<Engine>(BookConfig{}, list);
+    });
+    for (const Command& cmd : commands){
+        if (!router.process_command(cmd)) break;
+    }
+    vector<string> outputs;
+    for (auto& l : listeners) outputs.push_back(l->get_output());
+    return outputs;
+}
+
+// Output of each book when commands run through the pipeline
+vector<string> run_pipelined(const vector<Command>& commands, std::size_t event_capacity, std::size_t command_capacity){
+    EventRing ring(event_capacity);
+    vector<std::unique_ptr<TestListener>> listeners;
+    EventTargets targets;
+    CommandPipeline pipeline(ring, targets, command_capacity);
+
+    using Engine = BasicMatchingEngine<EventRingWriter>;
+    SymbolRouter<Engine> router([&](Symbol){
+        listeners.push_back(std::make_unique<TestListener>());
+        targets.push_back(listeners.back().get());
+        EventRingWriter writer{&ring, [&]{ pipeline.wait_for_output(); }, static_cast<std::uint32_t>(targets.size() - 1)};
+        return std::make_unique<Engine>(BookConfig{}, writer);
+    });
+    VectorCommands source{commands};
+    std::size_t drains = 0;
+    pipeline.run(source, router, [&]{ ++drains; });
+
+    CHECK(drains > 0);
+    CHECK(pipeline.match_stage().items <= pipeline.read_stage().items);
+    vector<string> outputs;
+    for (auto& l : listeners) outputs.push_back(l->get_output());
+    return outputs;
+}
+
+int main(){
+    vector<Command> commands = make_commands(20000);
+    vector<string> expected = run_serial(commands);
+    CHECK(expected.size() == 3);
+
+    // roomy rings, and rings small enough that every stage waits on back-pressure
+    CHECK(run_pipelined(commands, 1 << 16, 1 << 14) == expected);
+    CHECK(run_pipelined(commands, 4, 2) == expected);
+
+    // processing stops at Exit, like the serial path
+    vector<Command> with_exit(commands.begin(), commands.begin() + 5000);
+    with_exit.push_back(parse_command_view("X"));
+    with_exit.insert(with_exit.end(), commands.begin() + 5000, commands.end());
+    CHECK(run_pipelined(with_exit, 8, 8) == run_serial(with_exit));
+
+    // books are added while the output thread replays earlier ones, across storage chunks
+    vector<Command> many_books;
+    for (int i = 1; i <= 10000; ++i){
+        many_books.push_back(parse_command_view("N S" + std::to_string(i) + " " + std::to_string(i) + " B 100 1"));
+        if (i % 7 == 0) many_books.push_back(parse_command_view("P S" + std::to_string(i / 2)));
+    }
+    CHECK(run_pipelined(many_books, 64, 16) == run_serial(many_books));
+
+    // stage statistics add up
+    {
+        EventRing ring(1 << 10);
+        EventTargets targets;
+        TestListener listener;
+        targets.push_back(&listener);
+        CommandPipeline pipeline(ring, targets);
+        using Engine = BasicMatchingEngine<EventRingWriter>;
+        SymbolRouter<Engine> router([&](Symbol){
+            return std::make_unique<Engine>(BookConfig{}, EventRingWriter{&ring, [&]{ pipeline.wait_for_output(); }, 0});
+        });
+        vector<Command> single = {parse_command_view("N 1 B 100 5"), parse_command_view("N 2 S 100 5")};
+        VectorCommands source{single};
+        pipeline.run(source, router, []{});
+        CHECK(listener.get_output() == "ACK 1\nACK 2\nTRD 1 2 100 5\n");
+        CHECK(pipeline.read_stage().items == 2);
+        CHECK(pipeline.match_stage().items == 2);
+        CHECK(pipeline.output_stage().items == 3);
+        for (const auto* stage : {&pipeline.read_stage(), &pipeline.match_stage(), &pipeline.output_stage()}){
+            CHECK(stage->utilization() >= 0 && stage->utilization() <= 1);
+        }
+    }
+
+    cout << "test_pipeline: PASS" << endl;
+    return 0;
+}
@@ -0,0 +1,158 @@
+/**
+test_printer.cpp
+--------------
+Implements unit tests for the buffered PrinterListener and event formatting
+ */
+
+#include "printer_listener.hpp"
+#include "test_listener.hpp"
+#include "check.hpp"
+#include <climits>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using std::cout;
+using std::endl;
+using std::ostringstream;
+
+// Sends one of every event to a listener
+void emit_all(IEventListener& l){
+    l.on_ack(1);
+    l.on_reject(2, RejectReason::BAD);
+    l.on_reject(3, RejectReason::DUP);
+    l.on_trade(Trade{4, 5, 101, 7});
+    l.on_cancel(6, CancelResult::Cancelled);
+    l.on_cancel(7, CancelResult::Unknown);
+    l.on_ack(INT_MAX);
+    l.on_reject(-12, RejectReason::BAD);
+
+    TopOfBook tob;
+    l.on_tob(tob);
+    tob.best_bid = PriceLevel{100, 3};
+    tob.best_ask = PriceLevel{102, 9};
+    l.on_tob(tob);
+
+    BookSnapshot book;
+    book.bids = {PriceLevel{100, 3}, PriceLevel{99, 1}};
+    book.asks = {PriceLevel{102, 9}};
+    l.on_book(book);
+}
+
+const char* expected_text =
+    "ACK 1\n"
+    "REJ 2 BAD\n"
+    "REJ 3 DUP\n"
+    "TRD 4 5 101 7\n"
+    "CXL 6\n"
+    "REJ 7 UNK\n"
+    "ACK 2147483647\n"
+    "REJ -12 BAD\n"
+    "TOB BID 100 3\n"
+    "TOB ASK 102 9\n"
+    "BOOK BID 100 3\n"
+    "BOOK BID 99 1\n"
+    "BOOK ASK 102 9\n";
+
+int main(){
+    // printer and test listener produce the same bytes
+    {
+        TestListener test;
+        emit_all(test);
+        CHECK(test.get_output() == expected_text);
+
+        ostringstream os;
+        {
+            OutputBuffer buffer(os);
+            PrinterListener printer(buffer);
+            emit_all(printer);
+            // nothing is written until the buffer fills or is flushed
+            CHECK(os.str().empty());
+        }
+        CHECK(os.str() == expected_text);
+    }
+
+    // every line carries the prefix
+    {
+        ostringstream os;
+        OutputBuffer buffer(os);
+        PrinterListener printer(buffer, "AAPL ");
+        printer.on_ack(1);
+        printer.on_trade(Trade{1, 2, 3, 4});
+        buffer.flush();
+        CHECK(os.str() == "AAPL ACK 1\nAAPL TRD 1 2 3 4\n");
+    }
+
+    // a full buffer is written, only whole lines are ever written
+    {
+        ostringstream os;
+        OutputBuffer buffer(os, 16);
+        PrinterListener printer(buffer);
+        printer.on_ack(1);
+        CHECK(os.str().empty());
+        printer.on_ack(22);
+        printer.on_ack(333);
+        CHECK(os.str() == "ACK 1\nACK 22\nACK 333\n");
+        CHECK(buffer.pending() == 0);
+    }
+
+    // queries flush immediately when asked to
+    {
+        ostringstream os;
+        OutputBuffer buffer(os);
+        PrinterListener printer(buffer, "", true);
+        printer.on_ack(1);
+        CHECK(os.str().empty());
+        TopOfBook tob;
+        tob.best_bid = PriceLevel{100, 3};
+        printer.on_tob(tob);
+        CHECK(os.str() == "ACK 1\nTOB BID 100 3\n");
+    }
+
+    // output waits for the before-write hook, and is dropped from the first time it fails
+    {
+        ostringstream os;
+        bool durable = true;
+        int hook_calls = 0;
+        OutputBuffer buffer(os);
+        buffer.set_before_write([&]{
+            ++hook_calls;
+            return durable;
+        });
+        PrinterListener printer(buffer);
+        printer.on_ack(1);
+        buffer.flush();
+        CHECK(os.str() == "ACK 1\n" && hook_calls == 1);
+        durable = false;
+        printer.on_ack(2);
+        buffer.flush();
+        CHECK(buffer.failed() && buffer.pending() == 0);
+        durable = true;
+        printer.on_ack(3);
+        buffer.flush();
+        CHECK(os.str() == "ACK 1\n" && hook_calls == 2);
+        CHECK(buffer.bytes_written() == 6);
+    }
+
+    // file descriptor output goes through write(2)
+    {
+        int fds[2];
+        int rc = pipe(fds);
+        CHECK(rc == 0);
+        {
+            OutputBuffer buffer(fds[1]);
+            PrinterListener printer(buffer);
+            printer.on_cancel(9, CancelResult::Cancelled);
+        }
+        close(fds[1]);
+        char text[32] = {};
+        ssize_t n = read(fds[0], text, sizeof(text) - 1);
+        close(fds[0]);
+        CHECK(n == 6);
+        CHECK(std::string(text) == "CXL 9\n");
+    }
+
+    cout << "test_printer: PASS" << endl;
+    return 0;
+}
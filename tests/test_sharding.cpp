@@ -0,0 +1,127 @@
+/**
+test_sharding.cpp
+--------------
+Implements unit tests for multi-symbol routing and sharded execution
+ */
+
+#include "basic_matching_engine.hpp"
+#include "parser.hpp"
+#include "printer_listener.hpp"
+#include "sharded_engine.hpp"
+#include "symbol_router.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::map;
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+using Engine = BasicMatchingEngine<PrinterListener>;
+
+// random orders, cancels and queries spread over symbols
+vector<Command> make_commands(const vector<string>& symbols, int count){
+    std::mt19937 rng(7);
+    vector<Command> commands;
+    vector<std::pair<string, int>> resting;
+    int next_id = 1;
+    for (int i = 0; i < count; ++i){
+        int kind = rng() % 10;
+        string symbol = symbols[rng() % symbols.size()];
+        ostringstream line;
+        if (kind < 7 || resting.empty()){
+            line << "N " << symbol << " " << next_id << (rng() % 2 ? " B " : " S ")
+                 << 95 + rng() % 10 << " " << 1 + rng() % 20;
+            resting.push_back({symbol, next_id++});
+        }
+        else if (kind < 9){
+            auto victim = resting[rng() % resting.size()];
+            line << "C " << victim.first << " " << victim.second;
+        }
+        else {
+            line << (rng() % 2 ? "P " : "B ") << symbol;
+        }
+        commands.push_back(parse_command(line.str()));
+    }
+    return commands;
+}
+
+// per-symbol output is the same whether symbols run on one thread or across shards
+void test_sharded_matches_single_thread(){
+    vector<string> names = {"AAPL", "MSFT", "GOOG", "AMZN", "TSLA", "NVDA", "META"};
+    vector<Command> commands = make_commands(names, 20000);
+
+    map<Symbol, ostringstream> expected;
+    map<Symbol, ostringstream> actual;
+    map<Symbol, std::unique_ptr<OutputBuffer>> expected_buffers;
+    map<Symbol, std::unique_ptr<OutputBuffer>> actual_buffers;
+    for (const string& name : names){
+        Symbol symbol;
+        parse_symbol(name, symbol);
+        // small buffers so flushes happen mid-run
+        expected_buffers[symbol] = std::make_unique<OutputBuffer>(expected[symbol], 256);
+        actual_buffers[symbol] = std::make_unique<OutputBuffer>(actual[symbol], 256);
+    }
+
+    SymbolRouter<Engine> router([&](Symbol symbol){
+        return std::make_unique<Engine>(BookConfig{}, PrinterListener(*expected_buffers.at(symbol)));
+    });
+    for (const Command& cmd : commands) router.process_command(cmd);
+    CHECK(router.size() == names.size());
+
+    {
+        // buffers exist up front, so each shard only touches its own symbols' buffers
+        ShardedEngine<Engine> sharded(3, [&](std::size_t, Symbol symbol){
+            return std::make_unique<Engine>(BookConfig{}, PrinterListener(*actual_buffers.at(symbol)));
+        }, {}, 64);
+        for (const Command& cmd : commands) sharded.submit(cmd);
+        sharded.finish();
+    }
+    for (auto& entry : expected_buffers) entry.second->flush();
+    for (auto& entry : actual_buffers) entry.second->flush();
+
+    for (auto& entry : expected){
+        CHECK(!entry.second.str().empty());
+        CHECK(entry.second.str() == actual.at(entry.first).str());
+    }
+}
+
+// books of different symbols are independent
+void test_router_isolates_symbols(){
+    ostringstream out;
+    OutputBuffer buffer(out);
+    SymbolRouter<Engine> router([&](Symbol symbol){
+        return std::make_unique<Engine>(BookConfig{}, PrinterListener(buffer, symbol_name(symbol) + " "));
+    });
+    router.process_command(parse_command("N AAA 1 B 100 5"));
+    router.process_command(parse_command("N BBB 2 S 100 5"));
+    router.process_command(parse_command("N BBB 1 S 100 5"));
+    buffer.flush();
+    CHECK(out.str() == "AAA ACK 1\nBBB ACK 2\nBBB ACK 1\n");
+
+    Symbol aaa;
+    parse_symbol("AAA", aaa);
+    CHECK(router.engine_for(aaa).order_book().best_bid_quantity() == 5);
+    CHECK(!router.engine_for(aaa).order_book().has_best_ask());
+}
+
+int main(){
+    test_router_isolates_symbols();
+    test_sharded_matches_single_thread();
+
+    // every symbol maps to a valid shard
+    for (Symbol s = 1; s < 1000; ++s){
+        CHECK(ShardedEngine<Engine>::shard_of(s, 5) < 5);
+    }
+
+    cout << "test_sharding: PASS" << endl;
+    return 0;
+}
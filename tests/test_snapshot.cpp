@@ -0,0 +1,185 @@
+/**
+test_snapshot.cpp
+--------------
+Implements unit tests for OrderBook and engine snapshot save/restore
+ */
+
+#include "matching_engine.hpp"
+#include "order_book.hpp"
+#include "test_listener.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+struct Step {
+    int kind;   // 0 new, 1 cancel, 2 top of book, 3 book, 4 mass cancel of price to price + 2
+    int id;
+    Side side;
+    int price;
+    int qty;
+};
+
+vector<Step> make_steps(int count){
+    std::mt19937 rng(17);
+    vector<Step> steps;
+    for (int i = 1; i <= count; ++i){
+        int r = rng() % 20;
+        Step s{0, i, rng() % 2 ? Side::Buy : Side::Sell, 90 + static_cast<int>(rng() % 20), 1 + static_cast<int>(rng() % 40)};
+        if (r < 3) s = Step{1, 1 + static_cast<int>(rng() % i), Side::Buy, 0, 0};
+        else if (r == 3) s.kind = 2;
+        else if (r == 4) s.kind = 3;
+        // reuse old ids now and then to exercise the duplicate history
+        else if (r == 5) s.id = 1 + rng() % i;
+        // mass-cancelled ids must stay duplicates after a restore
+        else if (r == 6 && rng() % 8 == 0) s.kind = 4;
+        steps.push_back(s);
+    }
+    return steps;
+}
+
+void run_steps(MatchingEngine& engine, const vector<Step>& steps, std::size_t from, std::size_t to){
+    for (std::size_t i = from; i < to; ++i){
+        const Step& s = steps[i];
+        switch (s.kind){
+            case 0: engine.process_new_order(s.id, s.side, s.price, s.qty); break;
+            case 1: engine.cancel_order(s.id); break;
+            case 2: engine.top_of_book(); break;
+            case 4: engine.mass_cancel(s.side, s.price, s.price + 2); break;
+            default: engine.print_book(); break;
+        }
+    }
+}
+
+// A restored engine continues exactly like the engine it was saved from
+void test_engine_continuation(const BookConfig& config){
+    vector<Step> steps = make_steps(40000);
+    std::size_t half = steps.size() / 2;
+
+    MatchingEngine original(config);
+    run_steps(original, steps, 0, half);
+
+    SnapshotWriter out;
+    original.save_snapshot(out);
+
+    MatchingEngine restored(config);
+    SnapshotReader in(out.bytes());
+    CHECK(restored.load_snapshot(in));
+    CHECK(in.remaining() == 0);
+
+    TestListener expected;
+    TestListener actual;
+    original.add_listener(&expected);
+    restored.add_listener(&actual);
+    run_steps(original, steps, half, steps.size());
+    run_steps(restored, steps, half, steps.size());
+
+    CHECK(!expected.get_output().empty());
+    CHECK(expected.get_output() == actual.get_output());
+    CHECK(expected.get_output().find("DUP") != string::npos);
+}
+
+// Time priority within a level and dead ids survive a round trip
+void test_book_round_trip(){
+    OrderBook book;
+    book.add_limit(1, Side::Buy, 100, 5);
+    book.add_limit(2, Side::Buy, 100, 7);
+    book.add_limit(3, Side::Buy, 99, 1);
+    book.add_limit(4, Side::Sell, 105, 2);
+    book.add_limit(5, Side::Sell, 105, 3);
+    book.add_limit(6, Side::Sell, 110, 4);
+    book.cancel(3);
+    book.add_limit(7, Side::Buy, 90, 1);
+    vector<int> cancelled;
+    book.mass_cancel(Side::Buy, 1, 90, cancelled);
+
+    SnapshotWriter out;
+    book.save(out);
+    OrderBook copy;
+    SnapshotReader in(out.bytes());
+    CHECK(copy.load(in));
+
+    CHECK(copy.best_bid_price() == 100);
+    CHECK(copy.best_bid_quantity() == 12);
+    CHECK(copy.best_bid_front().order_id == 1);
+    CHECK(copy.best_ask_front().order_id == 4);
+    CHECK(copy.print_book().asks.size() == 2);
+    CHECK(copy.print_book().bids.size() == 1);
+    CHECK(copy.has_order(3));
+    CHECK(copy.cancel(3) == CancelResult::Unknown);
+    CHECK(copy.add_limit(3, Side::Buy, 98, 1) == AddResult::Duplicate);
+    CHECK(copy.cancel(7) == CancelResult::Unknown);
+    CHECK(copy.add_limit(7, Side::Buy, 98, 1) == AddResult::Duplicate);
+
+    vector<Fill> fills;
+    copy.consume_best_bid(6, fills);
+    CHECK(fills.size() == 2);
+    CHECK(fills[0].resting_order_id == 1);
+    CHECK(fills[1].resting_order_id == 2);
+
+    // an empty book round-trips too
+    OrderBook empty;
+    SnapshotWriter empty_out;
+    empty.save(empty_out);
+    OrderBook empty_copy;
+    SnapshotReader empty_in(empty_out.bytes());
+    CHECK(empty_copy.load(empty_in));
+    CHECK(!empty_copy.has_best_bid() && !empty_copy.has_best_ask());
+}
+
+// Truncated or inconsistent snapshots are refused
+void test_malformed(){
+    OrderBook book;
+    book.add_limit(1, Side::Buy, 100, 5);
+    book.add_limit(2, Side::Sell, 101, 5);
+    SnapshotWriter out;
+    book.save(out);
+    string bytes = out.bytes();
+
+    for (std::size_t cut = 0; cut < bytes.size(); ++cut){
+        OrderBook copy;
+        string truncated = bytes.substr(0, cut);
+        SnapshotReader in(truncated);
+        CHECK(!copy.load(in));
+    }
+
+    // an order id appearing twice
+    SnapshotWriter dup;
+    dup.put_u64(0);
+    dup.put_u64(2);
+    dup.put_u32(1);
+    dup.put_i32(100);
+    dup.put_u32(2);
+    dup.put_i32(7);
+    dup.put_i32(1);
+    dup.put_i32(7);
+    dup.put_i32(1);
+    dup.put_u32(0);
+    OrderBook copy;
+    SnapshotReader in(dup.bytes());
+    CHECK(!copy.load(in));
+
+    // loading needs an empty book
+    SnapshotReader again(bytes);
+    CHECK(!book.load(again));
+}
+
+int main(){
+    BookConfig map_config;
+    BookConfig ladder_config;
+    ladder_config.backend = BookBackend::Ladder;
+
+    test_book_round_trip();
+    test_malformed();
+    test_engine_continuation(map_config);
+    test_engine_continuation(ladder_config);
+
+    cout << "test_snapshot: PASS" << endl;
+    return 0;
+}
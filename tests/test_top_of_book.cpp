@@ -0,0 +1,160 @@
+/**
+test_top_of_book.cpp
+--------------
+Implements unit tests for the cached top of book and the BBO feed mode
+ */
+
+#include "matching_engine.hpp"
+#include "common.hpp"
+#include "check.hpp"
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+bool same_level(const std::optional<PriceLevel>& a, const std::optional<PriceLevel>& b){
+    if (!a || !b) return a.has_value() == b.has_value();
+    return a->price == b->price && a->qty == b->qty;
+}
+
+bool same_touch(const TopOfBook& a, const TopOfBook& b){
+    return same_level(a.best_bid, b.best_bid) && same_level(a.best_ask, b.best_ask);
+}
+
+// Top of book taken from the full book, without the cache
+TopOfBook touch_from_book(const OrderBook& ob){
+    BookSnapshot bs = ob.print_book();
+    TopOfBook tob;
+    if (!bs.bids.empty()) tob.best_bid = bs.bids.front();
+    if (!bs.asks.empty()) tob.best_ask = bs.asks.front();
+    return tob;
+}
+
+// Compile-time listener collecting every top of book it is sent
+struct TobRecorder {
+    vector<TopOfBook>* tobs;
+
+    void on_ack(int) {}
+    void on_reject(int, RejectReason) {}
+    void on_cancel(int, CancelResult) {}
+    void on_amend(int, AmendResult) {}
+    void on_trade(const Trade&) {}
+    void on_tob(const TopOfBook& tob) { tobs->push_back(tob); }
+    void on_book(const BookSnapshot&) {}
+};
+
+// Random orders, cancels, amends and mass cancels: the cache always equals the full book's first levels, and the
+// BBO feed sends exactly one on_tob per command that changed it
+void check_random(const BookConfig& config, unsigned seed){
+    vector<TopOfBook> tobs;
+    BasicMatchingEngine<TobRecorder> engine(config, TobRecorder{&tobs});
+    engine.set_bbo_feed(true);
+    std::mt19937 rng(seed);
+    int mid = 1000;
+    int next_id = 1;
+    std::vector<int> prices(1);   // last price of each id
+    std::size_t changes = 0;
+    for (int i = 0; i < 100000; ++i){
+        if (rng() % 100 == 0) mid += static_cast<int>(rng() % 21) - 10;
+        TopOfBook before = touch_from_book(engine.order_book());
+        std::size_t sent = tobs.size();
+        unsigned op = rng() % 6;
+        if (op < 2 && next_id > 1){
+            engine.cancel_order(1 + static_cast<int>(rng() % next_id));
+        }
+        else if (op == 2 && next_id > 1){
+            // half keep the price (cuts keep priority), half move it, some across the spread
+            int id = 1 + static_cast<int>(rng() % (next_id - 1));
+            int price = rng() % 2 ? prices[id] : mid + static_cast<int>(rng() % 40) - 20;
+            if (engine.amend_order(id, price, 1 + static_cast<int>(rng() % 50)) == AmendResult::Amended){
+                prices[id] = price;
+            }
+        }
+        else if (op == 3 && rng() % 256 == 0){
+            // now and then clear a band of one side, sometimes through the touch
+            int low = mid + static_cast<int>(rng() % 40) - 20;
+            engine.mass_cancel(rng() % 2 ? Side::Buy : Side::Sell, low, low + static_cast<int>(rng() % 10));
+        }
+        else {
+            Side side = rng() % 2 ? Side::Buy : Side::Sell;
+            int offset = static_cast<int>(rng() % 40) - 15;
+            int price = side == Side::Buy ? mid - offset : mid + offset;
+            prices.push_back(price);
+            engine.process_new_order_view(next_id++, side, price, 1 + static_cast<int>(rng() % 50));
+        }
+        TopOfBook after = touch_from_book(engine.order_book());
+        CHECK(same_touch(engine.order_book().top_of_book(), after));
+        if (same_touch(before, after)) CHECK(tobs.size() == sent);
+        else {
+            CHECK(tobs.size() == sent + 1);
+            CHECK(same_touch(tobs.back(), after));
+            ++changes;
+        }
+    }
+    CHECK(changes > 0);
+}
+
+int main(){
+    vector<TopOfBook> tobs;
+    BasicMatchingEngine<TobRecorder> eng(BookConfig{}, TobRecorder{&tobs});
+
+    // without the feed, on_tob is only sent on request
+    eng.process_new_order(1, Side::Buy, 100, 5);
+    CHECK(tobs.empty());
+    eng.top_of_book();
+    CHECK(tobs.size() == 1 && tobs[0].best_bid->price == 100 && !tobs[0].best_ask);
+
+    eng.set_bbo_feed(true);
+    tobs.clear();
+
+    // orders behind the touch and rejects do not move it
+    eng.process_new_order(2, Side::Buy, 99, 5);
+    eng.process_new_order(1, Side::Buy, 101, 5);
+    eng.cancel_order(42);
+    eng.cancel_order(2);
+    CHECK(tobs.empty());
+
+    // joining the touch changes its quantity
+    eng.process_new_order(3, Side::Buy, 100, 2);
+    CHECK(tobs.size() == 1 && tobs.back().best_bid->qty == 7);
+
+    // a new best ask, then a fill that empties the best bid
+    eng.process_new_order(4, Side::Sell, 102, 3);
+    CHECK(tobs.size() == 2 && tobs.back().best_ask->price == 102);
+    eng.process_new_order(5, Side::Sell, 100, 7);
+    CHECK(tobs.size() == 3 && !tobs.back().best_bid && tobs.back().best_ask->price == 102);
+
+    // cancelling the last ask empties the book
+    eng.cancel_order(4);
+    CHECK(tobs.size() == 4 && !tobs.back().best_bid && !tobs.back().best_ask);
+
+    // a restored book has its touch cached
+    BasicMatchingEngine<NullListener> original;
+    original.process_new_order(1, Side::Buy, 100, 5);
+    original.process_new_order(2, Side::Sell, 105, 1);
+    original.process_new_order(3, Side::Sell, 104, 2);
+    SnapshotWriter out;
+    original.save_snapshot(out);
+    {
+        std::string bytes = out.bytes();
+        SnapshotReader in(bytes);
+        BasicMatchingEngine<NullListener> restored;
+        CHECK(restored.load_snapshot(in));
+        CHECK(same_touch(restored.top_of_book(), original.top_of_book()));
+        CHECK(restored.top_of_book().best_ask->price == 104);
+    }
+
+    BookConfig map_config;
+    BookConfig ladder_config;
+    ladder_config.backend = BookBackend::Ladder;
+    ladder_config.ladder_ticks = 64;
+    check_random(map_config, 3);
+    check_random(ladder_config, 4);
+
+    cout << "test_top_of_book: PASS" << endl;
+    return 0;
+}
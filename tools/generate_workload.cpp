@@ -0,0 +1,493 @@
+/**
+generate_workload.cpp
+--------------
+Streams a synthetic command workload to disk in the text or binary command
+format, for runs far larger than scripts/generate_test.py can produce.
+Commands are written as they are generated and only a bounded window of
+recent orders is remembered for cancels, so memory stays fixed however many
+commands are requested. Distributions:
+  - each symbol's mid price random-walks one tick at a time
+  - passive orders rest a geometric number of ticks behind the touch
+  - order sizes follow a power law (Pareto), capped at --size-max
+  - a cancel picks the k-th most recent live order with k geometric, so
+    recently added orders are cancelled far more often than old ones
+  - an amend picks its order the same way and mostly cuts its quantity,
+    otherwise moves it a tick
+  - bursts of aggressive orders on one side of one symbol start at random,
+    last a geometric number of commands and push the mid their way
+The random source and every distribution are implemented here rather than
+taken from <random>, so a seed gives the same file on every standard library.
+ */
+
+#include "binary_command.hpp"
+#include "command.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+struct Options {
+    std::uint64_t count = 1000000;      // commands before the final X
+    std::uint64_t seed = 1;
+    bool binary = false;
+    int symbols = 0;                    // 0 = single unnamed book
+    int mid = 10000;                    // starting mid price of every symbol
+    double volatility = 0.05;           // chance per order that the mid moves a tick
+    double depth_ticks = 10;            // mean distance of passive orders behind the touch
+    double size_min = 10;
+    double size_alpha = 1.5;            // Pareto shape, smaller means heavier tail
+    int size_max = 10000;
+    double cancel_rate = 0.25;
+    double cancel_recency = 50;         // mean rank (from newest) of the cancelled or amended order
+    double amend_rate = 0;
+    double amend_reprice = 0.3;         // chance an amend moves the price rather than cutting the quantity
+    std::size_t window = 1000000;       // recent orders remembered for cancels
+    double query_rate = 0.02;           // P and B, half each
+    int book_depth = 10;                // levels per side of B queries, 0 = full book
+    double aggressive_rate = 0.05;      // chance an order crosses the spread outside bursts
+    double sweep_ticks = 3;             // mean ticks an aggressive order reaches past the touch
+    double burst_rate = 0.0005;         // chance per command that a burst starts
+    double burst_length = 200;          // mean commands in a burst
+    double burst_aggressive = 0.7;      // chance an order in a burst is aggressive
+    string output;
+};
+
+// splitmix64 with the distributions the generator needs
+class Random {
+private:
+    std::uint64_t state;
+
+public:
+    explicit Random(std::uint64_t seed) : state(seed) {}
+
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1)
+    double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+    bool chance(double p) { return uniform() < p; }
+
+    // Uniform in [0, n)
+    std::uint64_t below(std::uint64_t n) { return next() % n; }
+
+    // Failures before the first success, with the given mean
+    std::uint64_t geometric(double mean) {
+        if (mean <= 0) return 0;
+        double q = mean / (mean + 1);
+        return static_cast<std::uint64_t>(std::log(1 - uniform()) / std::log(q));
+    }
+
+    // Pareto with minimum xm and shape alpha
+    double pareto(double xm, double alpha) { return xm / std::pow(1 - uniform(), 1 / alpha); }
+};
+
+// Ring of the most recently added orders, newest last. Cancelled entries are
+// cleared in place; once the ring is full the oldest order is forgotten and
+// simply stays on the book.
+class RecentOrders {
+public:
+    struct Entry {
+        std::int32_t order_id;      // 0 once cancelled
+        std::uint32_t symbol;       // index into the symbol table
+        std::int32_t price;         // as last sent, fills are not tracked
+        std::int32_t qty;
+    };
+
+private:
+    vector<Entry> entries;
+    std::size_t next_slot = 0;
+    std::size_t filled = 0;
+
+public:
+    explicit RecentOrders(std::size_t capacity) : entries(std::max<std::size_t>(capacity, 1)) {}
+
+    void add(std::int32_t order_id, std::uint32_t symbol, std::int32_t price, std::int32_t qty) {
+        entries[next_slot] = Entry{order_id, symbol, price, qty};
+        next_slot = (next_slot + 1) % entries.size();
+        filled = std::min(filled + 1, entries.size());
+    }
+
+    // The live order rank places behind the newest, nullptr if there is none there
+    Entry* at(std::size_t rank) {
+        if (rank >= filled) return nullptr;
+        Entry& e = entries[(next_slot + entries.size() - 1 - rank) % entries.size()];
+        return e.order_id == 0 ? nullptr : &e;
+    }
+
+    // Removes the order rank places behind the newest, false if there is none there
+    bool take(std::size_t rank, std::int32_t& order_id, std::uint32_t& symbol) {
+        Entry* e = at(rank);
+        if (!e) return false;
+        order_id = e->order_id;
+        symbol = e->symbol;
+        e->order_id = 0;
+        return true;
+    }
+};
+
+// Buffered writer of text lines or binary records
+class CommandWriter {
+private:
+    std::FILE* file;
+    bool binary;
+    vector<char> buffer;
+    std::size_t used = 0;
+    std::uint64_t total = 0;
+
+    void put(std::string_view s) {
+        std::copy(s.begin(), s.end(), buffer.data() + used);
+        used += s.size();
+    }
+
+    void put(std::int64_t value) {
+        used = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+    }
+
+public:
+    CommandWriter(std::FILE* f, bool binary_format) : file(f), binary(binary_format), buffer(1 << 20) {
+        if (binary) put(binary_command_magic);
+    }
+
+    void write(const Command& cmd, std::string_view symbol) {
+        if (used + 128 > buffer.size()) flush();
+        if (binary){
+            BinaryRecord rec = encode_command(cmd);
+            std::copy(reinterpret_cast<const char*>(&rec), reinterpret_cast<const char*>(&rec) + sizeof(rec),
+                      buffer.data() + used);
+            used += sizeof(rec);
+            return;
+        }
+        switch (cmd.type){
+            case CommandType::New: put("N "); break;
+            case CommandType::Cancel: put("C "); break;
+            case CommandType::Amend: put("A "); break;
+            case CommandType::PrintTopOfBook: put("P"); break;
+            case CommandType::PrintFullBook: put("B"); break;
+            default: put("X"); break;
+        }
+        if (!symbol.empty()){
+            if (cmd.type == CommandType::PrintTopOfBook || cmd.type == CommandType::PrintFullBook) put(" ");
+            put(symbol);
+            if (cmd.type == CommandType::New || cmd.type == CommandType::Cancel || cmd.type == CommandType::Amend) put(" ");
+        }
+        if (cmd.type == CommandType::New){
+            put(cmd.order_id);
+            put(cmd.side == Side::Buy ? " B " : " S ");
+            put(cmd.price);
+            put(" ");
+            put(cmd.qty);
+        }
+        else if (cmd.type == CommandType::Cancel){
+            put(cmd.order_id);
+        }
+        else if (cmd.type == CommandType::Amend){
+            put(cmd.order_id);
+            put(" ");
+            put(cmd.price);
+            put(" ");
+            put(cmd.qty);
+        }
+        else if (cmd.type == CommandType::PrintFullBook && cmd.qty > 0){
+            put(" ");
+            put(cmd.qty);
+        }
+        put("\n");
+    }
+
+    void flush() {
+        total += std::fwrite(buffer.data(), 1, used, file);
+        used = 0;
+    }
+
+    std::uint64_t bytes() const { return total; }
+};
+
+struct SymbolState {
+    string name;
+    Symbol symbol = default_symbol;
+    int mid = 0;
+};
+
+struct Counts {
+    std::uint64_t orders = 0;
+    std::uint64_t aggressive = 0;
+    std::uint64_t cancels = 0;
+    std::uint64_t amends = 0;
+    std::uint64_t queries = 0;
+    std::uint64_t bursts = 0;
+};
+
+// Writes options.count commands and a final Exit to out
+Counts generate(const Options& options, CommandWriter& out){
+    Random rng(options.seed);
+    RecentOrders recent(options.window);
+    Counts counts;
+
+    vector<SymbolState> symbols(std::max(options.symbols, 1));
+    for (std::size_t i = 0; i < symbols.size(); ++i){
+        if (options.symbols > 0){
+            char name[32];
+            std::snprintf(name, sizeof(name), "SYM%04zu", i);
+            symbols[i].name = name;
+            parse_symbol(symbols[i].name, symbols[i].symbol);
+        }
+        symbols[i].mid = options.mid;
+    }
+    // keeps passive orders of the deepest usual level above price 0
+    const int min_mid = std::max(2, static_cast<int>(options.depth_ticks * 10) + 2);
+
+    std::int32_t next_id = 1;
+    std::uint64_t burst_left = 0;
+    std::uint32_t burst_symbol = 0;
+    Side burst_side = Side::Buy;
+
+    for (std::uint64_t n = 0; n < options.count; ++n){
+        if (burst_left == 0 && rng.chance(options.burst_rate)){
+            burst_left = 1 + rng.geometric(options.burst_length);
+            burst_symbol = static_cast<std::uint32_t>(rng.below(symbols.size()));
+            burst_side = rng.chance(0.5) ? Side::Buy : Side::Sell;
+            ++counts.bursts;
+        }
+        bool in_burst = burst_left > 0;
+        if (in_burst) --burst_left;
+
+        Command cmd;
+        double r = rng.uniform();
+        if (r < options.cancel_rate){
+            std::int32_t id;
+            std::uint32_t sym;
+            if (recent.take(rng.geometric(options.cancel_recency), id, sym)){
+                cmd.type = CommandType::Cancel;
+                cmd.order_id = id;
+                cmd.symbol = symbols[sym].symbol;
+                out.write(cmd, symbols[sym].name);
+                ++counts.cancels;
+                continue;
+            }
+            // nothing live at that rank, send an order instead
+        }
+        else if (r < options.cancel_rate + options.query_rate){
+            const SymbolState& s = symbols[rng.below(symbols.size())];
+            cmd.symbol = s.symbol;
+            if (rng.chance(0.5)){
+                cmd.type = CommandType::PrintTopOfBook;
+            }
+            else {
+                cmd.type = CommandType::PrintFullBook;
+                cmd.qty = options.book_depth;
+            }
+            out.write(cmd, s.name);
+            ++counts.queries;
+            continue;
+        }
+        else if (r < options.cancel_rate + options.query_rate + options.amend_rate){
+            if (RecentOrders::Entry* e = recent.at(rng.geometric(options.cancel_recency))){
+                if (rng.chance(options.amend_reprice)){
+                    e->price = std::max(1, e->price + (rng.chance(0.5) ? 1 : -1));
+                }
+                else if (e->qty > 1){
+                    e->qty = 1 + static_cast<std::int32_t>(rng.below(e->qty - 1));
+                }
+                cmd.type = CommandType::Amend;
+                cmd.order_id = e->order_id;
+                cmd.price = e->price;
+                cmd.qty = e->qty;
+                cmd.symbol = symbols[e->symbol].symbol;
+                out.write(cmd, symbols[e->symbol].name);
+                ++counts.amends;
+                continue;
+            }
+            // nothing live at that rank, send an order instead
+        }
+
+        std::uint32_t sym = in_burst ? burst_symbol : static_cast<std::uint32_t>(rng.below(symbols.size()));
+        SymbolState& s = symbols[sym];
+        if (rng.chance(options.volatility)) s.mid += rng.chance(0.5) ? 1 : -1;
+
+        bool aggressive = rng.chance(in_burst ? options.burst_aggressive : options.aggressive_rate);
+        Side side = aggressive && in_burst ? burst_side : (rng.chance(0.5) ? Side::Buy : Side::Sell);
+        int sign = side == Side::Buy ? 1 : -1;
+        int price;
+        if (aggressive){
+            price = s.mid + sign * static_cast<int>(1 + rng.geometric(options.sweep_ticks));
+            // a burst moves the market its way
+            if (in_burst) s.mid += sign;
+            ++counts.aggressive;
+        }
+        else {
+            price = s.mid - sign * static_cast<int>(1 + rng.geometric(options.depth_ticks));
+        }
+        s.mid = std::max(s.mid, min_mid);
+
+        cmd.type = CommandType::New;
+        cmd.order_id = next_id;
+        cmd.side = side;
+        cmd.price = std::max(price, 1);
+        cmd.qty = static_cast<std::int32_t>(std::min<double>(options.size_max, rng.pareto(options.size_min, options.size_alpha)));
+        cmd.symbol = s.symbol;
+        out.write(cmd, s.name);
+        recent.add(next_id, sym, cmd.price, cmd.qty);
+        ++next_id;
+        ++counts.orders;
+    }
+
+    Command exit_cmd;
+    exit_cmd.type = CommandType::Exit;
+    out.write(exit_cmd, "");
+    out.flush();
+    return counts;
+}
+
+void usage(const char* program){
+    cerr << "Usage: " << program << " [options] <output>\n"
+         << "  --count=N             commands to write (default 1000000)\n"
+         << "  --binary              write the binary command format instead of text\n"
+         << "  --seed=N              random seed (default 1)\n"
+         << "  --symbols=N           spread commands over N symbols (default 0, one unnamed book)\n"
+         << "  --mid=P               starting mid price (default 10000)\n"
+         << "  --volatility=F        chance per order that the mid moves one tick (default 0.05)\n"
+         << "  --depth-ticks=F       mean ticks of passive orders behind the touch (default 10)\n"
+         << "  --size-min=F --size-alpha=F --size-max=N\n"
+         << "                        Pareto order sizes (default 10, 1.5, 10000)\n"
+         << "  --cancel=F            share of cancels (default 0.25)\n"
+         << "  --cancel-recency=F    mean rank from the newest order of a cancel or amend (default 50)\n"
+         << "  --amend=F             share of amends (default 0)\n"
+         << "  --amend-reprice=F     chance an amend moves the price a tick instead of cutting the quantity (default 0.3)\n"
+         << "  --window=N            recent orders remembered for cancels (default 1000000)\n"
+         << "  --query=F             share of P and B queries (default 0.02)\n"
+         << "  --book-depth=N        levels per side of B queries, 0 = full book (default 10)\n"
+         << "  --aggressive=F        chance an order crosses the spread outside bursts (default 0.05)\n"
+         << "  --sweep-ticks=F       mean ticks aggressive orders reach past the touch (default 3)\n"
+         << "  --burst-rate=F        chance per command that a burst starts (default 0.0005)\n"
+         << "  --burst-length=F      mean commands per burst (default 200)\n"
+         << "  --burst-aggressive=F  chance an order in a burst is aggressive (default 0.7)\n";
+}
+
+// Parses the whole of text into out, returning false unless it is a plain number
+template <typename T>
+bool parse_number(const char* text, T& out){
+    const char* end = text + std::char_traits<char>::length(text);
+    T value{};
+    auto [ptr, ec] = std::from_chars(text, end, value);
+    if (ec != std::errc() || ptr != end) return false;
+    out = value;
+    return true;
+}
+
+// Chances and shares are probabilities, means are finite and non-negative (NaN fails both)
+bool is_probability(double p){ return p >= 0 && p <= 1; }
+bool is_mean(double m){ return m >= 0 && std::isfinite(m); }
+
+int main(int argc, char* argv[]){
+    Options options;
+    for (int i = 1; i < argc; ++i){
+        string arg = argv[i];
+        auto value = [&](const char* name) -> const char* {
+            std::size_t len = std::char_traits<char>::length(name);
+            return arg.compare(0, len, name) == 0 ? argv[i] + len : nullptr;
+        };
+        bool ok = true;
+        if (const char* v = value("--count=")) ok = parse_number(v, options.count);
+        else if (arg == "--binary") options.binary = true;
+        else if (const char* v = value("--seed=")) ok = parse_number(v, options.seed);
+        else if (const char* v = value("--symbols=")) ok = parse_number(v, options.symbols);
+        else if (const char* v = value("--mid=")) ok = parse_number(v, options.mid);
+        else if (const char* v = value("--volatility=")) ok = parse_number(v, options.volatility);
+        else if (const char* v = value("--depth-ticks=")) ok = parse_number(v, options.depth_ticks);
+        else if (const char* v = value("--size-min=")) ok = parse_number(v, options.size_min);
+        else if (const char* v = value("--size-alpha=")) ok = parse_number(v, options.size_alpha);
+        else if (const char* v = value("--size-max=")) ok = parse_number(v, options.size_max);
+        else if (const char* v = value("--cancel=")) ok = parse_number(v, options.cancel_rate);
+        else if (const char* v = value("--cancel-recency=")) ok = parse_number(v, options.cancel_recency);
+        else if (const char* v = value("--amend=")) ok = parse_number(v, options.amend_rate);
+        else if (const char* v = value("--amend-reprice=")) ok = parse_number(v, options.amend_reprice);
+        else if (const char* v = value("--window=")) ok = parse_number(v, options.window);
+        else if (const char* v = value("--query=")) ok = parse_number(v, options.query_rate);
+        else if (const char* v = value("--book-depth=")) ok = parse_number(v, options.book_depth);
+        else if (const char* v = value("--aggressive=")) ok = parse_number(v, options.aggressive_rate);
+        else if (const char* v = value("--sweep-ticks=")) ok = parse_number(v, options.sweep_ticks);
+        else if (const char* v = value("--burst-rate=")) ok = parse_number(v, options.burst_rate);
+        else if (const char* v = value("--burst-length=")) ok = parse_number(v, options.burst_length);
+        else if (const char* v = value("--burst-aggressive=")) ok = parse_number(v, options.burst_aggressive);
+        else if (arg.rfind("--", 0) != 0 && options.output.empty()) options.output = arg;
+        else ok = false;
+        if (!ok){
+            cerr << "Invalid argument " << arg << endl;
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.output.empty() || options.symbols < 0 || options.symbols > 10000 || options.mid <= 0
+        || !(options.size_min >= 1) || !(options.size_alpha > 0) || options.size_max < 1 || options.book_depth < 0){
+        usage(argv[0]);
+        return 1;
+    }
+    for (double p : {options.volatility, options.cancel_rate, options.amend_rate, options.amend_reprice,
+                     options.query_rate, options.aggressive_rate, options.burst_rate, options.burst_aggressive}){
+        if (!is_probability(p)){
+            cerr << "Chances and shares must be from 0 to 1" << endl;
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    // the rest of the commands are orders
+    if (options.cancel_rate + options.amend_rate + options.query_rate > 1){
+        cerr << "--cancel, --amend and --query must add up to at most 1" << endl;
+        usage(argv[0]);
+        return 1;
+    }
+    // min_mid is derived from depth_ticks as an int, so it is kept far below INT_MAX / 10
+    if (!is_mean(options.depth_ticks) || options.depth_ticks > 1e6 || !is_mean(options.cancel_recency)
+        || !is_mean(options.sweep_ticks) || !is_mean(options.burst_length)){
+        cerr << "Mean ticks and lengths must be non-negative, --depth-ticks at most 1000000" << endl;
+        usage(argv[0]);
+        return 1;
+    }
+    // every order needs its own positive 32-bit id
+    if (options.count >= static_cast<std::uint64_t>(INT32_MAX)){
+        cerr << "--count must be below " << INT32_MAX << endl;
+        return 1;
+    }
+
+    std::FILE* file = std::fopen(options.output.c_str(), options.binary ? "wb" : "w");
+    if (!file){
+        cerr << "Could not open output file " << options.output << endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CommandWriter writer(file, options.binary);
+    Counts counts = generate(options, writer);
+    bool write_failed = std::ferror(file) != 0;
+    if (std::fclose(file) != 0 || write_failed){
+        cerr << "Failed writing " << options.output << endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    cout << "Generated " << options.count << " commands in " << options.output << " ("
+         << writer.bytes() << " bytes, " << seconds << " s)\n"
+         << "  - Orders: " << counts.orders << " (" << counts.aggressive << " aggressive)\n"
+         << "  - Cancels: " << counts.cancels << "\n"
+         << "  - Amends: " << counts.amends << "\n"
+         << "  - Queries: " << counts.queries << "\n"
+         << "  - Bursts: " << counts.bursts << endl;
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**
+journal_to_text.cpp
+--------------
+Decodes a binary event journal (exchange_simulator --output=journal)
+and prints exactly the text output the simulator would have printed.
+ */
+
+#include "event_journal.hpp"
+#include "mapped_file.hpp"
+#include "printer_listener.hpp"
+#include <iostream>
+#include <unistd.h>
+
+using std::cerr;
+using std::endl;
+
+// Prints each event with the prefix of the book the decoder says it belongs to
+struct SymbolPrinter : IEventListener {
+    const JournalDecoder& decoder;
+    PrinterListener& printer;
+    Symbol prefix_symbol = default_symbol;
+
+    SymbolPrinter(const JournalDecoder& d, PrinterListener& p) : decoder(d), printer(p) {}
+
+    PrinterListener& target() {
+        if (decoder.current_symbol() != prefix_symbol){
+            prefix_symbol = decoder.current_symbol();
+            printer.prefix = prefix_symbol == default_symbol ? "" : symbol_name(prefix_symbol) + " ";
+        }
+        return printer;
+    }
+
+    void on_ack(int order_id) override { target().on_ack(order_id); }
+    void on_reject(int order_id, RejectReason rr) override { target().on_reject(order_id, rr); }
+    void on_cancel(int order_id, CancelResult cr) override { target().on_cancel(order_id, cr); }
+    void on_amend(int order_id, AmendResult ar) override { target().on_amend(order_id, ar); }
+    void on_trade(const Trade& trd) override { target().on_trade(trd); }
+    void on_tob(const TopOfBook& tob) override { target().on_tob(tob); }
+    void on_book(const BookSnapshot& bs) override { target().on_book(bs); }
+};
+
+int main(int argc, char* argv[]){
+    if (argc < 2){
+        cerr << "Usage: " << argv[0] << " <journal_file>" << endl;
+        return 1;
+    }
+
+    MappedFile input;
+    if (!input.open(argv[1])){
+        cerr << "Could not open journal file " << argv[1] << endl;
+        return 1;
+    }
+
+    OutputBuffer output(STDOUT_FILENO);
+    PrinterListener printer(output);
+    JournalDecoder decoder(input.contents());
+    SymbolPrinter symbol_printer(decoder, printer);
+    while (decoder.next(symbol_printer)){}
+    output.flush();
+
+    if (decoder.error()){
+        cerr << "Journal " << argv[1] << " is truncated or corrupt" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+text_to_binary.cpp
+--------------
+Converts a text command file into the fixed-width binary command format
+read by exchange_simulator and test_performance.
+Every line becomes one record (malformed lines become Reject records),
+so the binary file replays with exactly the output of the text file.
+ */
+
+#include "binary_command.hpp"
+#include "mapped_file.hpp"
+#include "parser.hpp"
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+int main(int argc, char* argv[]){
+    if (argc < 3){
+        cerr << "Usage: " << argv[0] << " <input.txt> <output.bin>" << endl;
+        return 1;
+    }
+
+    MappedFile input;
+    if (!input.open(argv[1])){
+        cerr << "Could not open input file " << argv[1] << endl;
+        return 1;
+    }
+    std::FILE* output = std::fopen(argv[2], "wb");
+    if (!output){
+        cerr << "Could not open output file " << argv[2] << endl;
+        return 1;
+    }
+
+    std::fwrite(binary_command_magic.data(), 1, binary_command_magic.size(), output);
+
+    // records are written in batches
+    std::vector<BinaryRecord> batch;
+    batch.reserve(4096);
+    std::size_t records = 0;
+    MappedLineReader reader(input.contents());
+    std::string_view line;
+    while (reader.next(line)){
+        batch.push_back(encode_command(parse_command_view(line)));
+        if (batch.size() == batch.capacity()){
+            std::fwrite(batch.data(), sizeof(BinaryRecord), batch.size(), output);
+            records += batch.size();
+            batch.clear();
+        }
+    }
+    std::fwrite(batch.data(), sizeof(BinaryRecord), batch.size(), output);
+    records += batch.size();
+
+    bool write_failed = std::ferror(output) != 0;
+    if (std::fclose(output) != 0 || write_failed){
+        cerr << "Failed writing " << argv[2] << endl;
+        return 1;
+    }
+    cout << records << " records, " << input.size() << " -> "
+         << binary_command_magic.size() + records * binary_record_size << " bytes" << endl;
+    return 0;
+}